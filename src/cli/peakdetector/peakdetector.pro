@@ -12,6 +12,8 @@ TARGET = peakdetector
 CONFIG += warn_off xml console
 
 QMAKE_CXXFLAGS += -std=c++11
+QMAKE_CXXFLAGS += -DOMP_PARALLEL
+!macx: QMAKE_CXXFLAGS += -fopenmp
 
 INCLUDEPATH +=  $$top_srcdir/src/core/libmaven     \
                 $$top_srcdir/3rdparty/pugixml/src  \
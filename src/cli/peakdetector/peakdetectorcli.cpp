@@ -1,3 +1,7 @@
+#include <chrono>
+
+#include <omp.h>
+
 #include "common/analytics.h"
 #include "common/downloadmanager.h"
 #include "Compound.h"
@@ -21,6 +25,7 @@ PeakDetectorCLI::PeakDetectorCLI(Logger* log, Analytics* analytics)
     clsfModelFilename = "default.model";
     alignMode = AlignmentMode::None;
     _reduceGroupsFlag = true;
+    _loadThreads = 0;
     _parseOptions = new ParseOptions();
     _dlManager = new DownloadManager;
     _pollyIntegration = new PollyIntegration(_dlManager);
@@ -156,6 +161,16 @@ void PeakDetectorCLI::processOptions(int argc, char* argv[])
             mavenParameters->charge = atoi(optarg);
             break;
 
+        case 'K':
+            mzSample::setCompactScans(atoi(optarg) > 0);
+            mzSample::setCompactScanCacheSize(atoi(optarg));
+            break;
+
+        case 'l':
+            mzSample::setLazyLoading(atoi(optarg) > 0);
+            mzSample::setLazyScanCacheSize(atoi(optarg));
+            break;
+
         case 'm':
             clsfModelFilename = optarg;
             break;
@@ -200,6 +215,14 @@ void PeakDetectorCLI::processOptions(int argc, char* argv[])
             mavenParameters->rtStepSize = atoi(optarg);
             break;
 
+        case 's':
+            mzSample::setUseSampleCache(atoi(optarg) != 0);
+            break;
+
+        case 't':
+            _loadThreads = atoi(optarg);
+            break;
+
         case 'v':
             mavenParameters->ionizationMode = atoi(optarg);
             break;
@@ -521,6 +544,23 @@ void PeakDetectorCLI::_processGeneralArgsXML(xml_node& generalArgs)
             if (atoi(node.attribute("value").value()) == 0)
                 saveJsonEIC = false;
 
+        } else if (strcmp(node.name(), "sampleCache") == 0) {
+            mzSample::setUseSampleCache(
+                atoi(node.attribute("value").value()) != 0);
+
+        } else if (strcmp(node.name(), "loadThreads") == 0) {
+            _loadThreads = atoi(node.attribute("value").value());
+
+        } else if (strcmp(node.name(), "lazyLoading") == 0) {
+            int megabytes = atoi(node.attribute("value").value());
+            mzSample::setLazyLoading(megabytes > 0);
+            mzSample::setLazyScanCacheSize(megabytes);
+
+        } else if (strcmp(node.name(), "compactScans") == 0) {
+            int megabytes = atoi(node.attribute("value").value());
+            mzSample::setCompactScans(megabytes > 0);
+            mzSample::setCompactScanCacheSize(megabytes);
+
         } else if (strcmp(node.name(), "outputdir") == 0) {
             mavenParameters->outputdir =
                 node.attribute("value").value() + string(DIR_SEPARATOR_STR);
@@ -617,21 +657,44 @@ void PeakDetectorCLI::loadSamples(vector<string>& filenames)
 #endif
     _log->info() << "Loading samples…" << std::flush;
 
-    for (unsigned int i = 0; i < filenames.size(); i++) {
+    // Files are loaded concurrently, each by a single thread. A lone file
+    // is instead decoded in parallel by `mzSample` itself.
+    int fileCount = filenames.size();
+    int threads = _loadThreads > 0 ? _loadThreads : omp_get_max_threads();
+    threads = max(1, min(threads, fileCount));
+
+    vector<mzSample*> loadedSamples(fileCount, nullptr);
+    vector<double> loadingTimes(fileCount, 0.0);
+#pragma omp parallel for schedule(dynamic) num_threads(threads) if(threads > 1)
+    for (int i = 0; i < fileCount; i++) {
+        auto start = chrono::steady_clock::now();
         mzSample* sample = new mzSample();
         sample->loadSample(filenames[i].c_str());
         sample->sampleName = mzUtils::cleanFilename(filenames[i]);
         sample->isSelected = true;
+        loadedSamples[i] = sample;
+        loadingTimes[i] = chrono::duration<double>(chrono::steady_clock::now()
+                                                   - start).count();
+    }
+
+    // samples are reported and kept in the order of the input files
+    for (int i = 0; i < fileCount; i++) {
+        mzSample* sample = loadedSamples[i];
         if (sample->scans.size() >= 1) {
             mavenParameters->samples.push_back(sample);
             _log->info() << "Loaded Sample: "
                          << sample->getSampleName()
+                         << " ("
+                         << sample->scans.size()
+                         << " scans in "
+                         << loadingTimes[i]
+                         << " seconds)"
                          << std::flush;
         } else {
-            if (sample != NULL) {
-                delete sample;
-                sample = NULL;
-            }
+            _log->error() << "Failed to load sample: "
+                         << filenames[i]
+                         << std::flush;
+            delete sample;
         }
     }
 
@@ -640,9 +703,9 @@ void PeakDetectorCLI::loadSamples(vector<string>& filenames)
         exit(1);
     }
 
-    sort(mavenParameters->samples.begin(),
-         mavenParameters->samples.end(),
-         mzSample::compSampleSort);
+    stable_sort(mavenParameters->samples.begin(),
+                mavenParameters->samples.end(),
+                mzSample::compSampleSort);
 
     _log->info() << "Loaded "
                  << mavenParameters->samples.size()
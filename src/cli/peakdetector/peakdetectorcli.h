@@ -36,6 +36,7 @@
 
 #ifndef __APPLE__
     #ifdef OMP_PARALLEL
+        #include <omp.h>
         #define getTime() omp_get_wtime()
     #else
         #define getTime() get_wall_time()
@@ -108,8 +109,10 @@ public:
     void loadCompoundsFile();
 
     /**
-     * [loadSamples description]
-     * @param filenames [description]
+     * @brief Load the given sample files concurrently.
+     * @details Samples that could not be loaded are skipped. The remaining
+     * ones are sorted by name, ties being kept in the order of the files.
+     * @param filenames Paths of the sample files.
      */
     void loadSamples(vector<string>& filenames);
 
@@ -167,6 +170,8 @@ public:
             "I?quantileIntensity: Specify required percentage of peaks above the intensity threshold. <float>",
             "j?saveEicJson: Enter non-zero integer to save EIC JSON in the output folder. <int>",
             "k?charge: Enter the magnitude of charge on each compound. <int>",
+            "K?compactScans: Enter megabytes of uncompressed scans to keep in memory per sample to keep the peak data of samples compressed, 0 keeps it uncompressed. <int>",
+            "l?lazyLoading: Enter megabytes of decoded scans to keep in memory per sample to load samples lazily, 0 loads them in full. <int>",
             "m?model: Enter full path to the model file. <string>",
             "n?eicMaxGroups: Enter maximum number of groups reported per compound. <int>",
             "o?outputdir: Enter full path to output folder. <string>",
@@ -174,6 +179,8 @@ public:
             "q?minQuality: Enter min peak quality threshold for a group. <float>",
             "Q?quantileQuality: Specify required percentage of peaks above quality threshold. <float>",
             "r?rtStepSize: Enter retention time window for untargeted peak detection. <float>",
+            "s?sampleCache: Enter non-zero integer to cache decoded samples next to their files and reuse them in later runs. <int>",
+            "t?loadThreads: Enter number of threads used to load samples, 0 uses all available cores. <int>",
             "v?ionizationMode: Enter 0, -1 or 1 ionization mode. <int>",
             "w?minPeakWidth: Enter min peak width threshold in a group. <int>",
             "x?xml: Enter full path to the config file or a settings file from El-MAVEN. <string>",
@@ -201,6 +208,7 @@ private:
     Databases _db;
     JSONReports* _jsonReports;
     bool _reduceGroupsFlag;
+    int _loadThreads;
     PollyApp _currentPollyApp;
     QString _pollyExtraInfo;
     Logger *_log;
@@ -264,6 +272,10 @@ struct Arguments
     void populateArgs() {
         generalArgs << "int" << "alignSamples" << "0";
         generalArgs << "int" << "saveEicJson" << "0";
+        generalArgs << "int" << "sampleCache" << "0";
+        generalArgs << "int" << "lazyLoading" << "0";
+        generalArgs << "int" << "compactScans" << "0";
+        generalArgs << "int" << "loadThreads" << "0";
         generalArgs << "string" << "outputdir" << "0";
         generalArgs << "string" << "pollyExtra" << "";
         generalArgs << "string" << "samples" << "path/to/sample1";
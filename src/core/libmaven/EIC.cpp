@@ -943,6 +943,18 @@ vector<PeakGroup> EIC::groupPeaks(vector<EIC *> &eics,
 
     //cerr << "EIC::groupPeaks() peakgroups=" << pgroups.size() << endl;
 
+    //merged peaks are sorted by rt, but their bounds need not be. Keep a
+    //running maximum of the bounds seen so far, so that the merged peaks
+    //lying entirely before a sample peak can be skipped with a binary search
+    vector<float> highestBound(m->peaks.size());
+    for (unsigned int k = 0; k < m->peaks.size(); k++)
+    {
+        Peak &a = m->peaks[k];
+        highestBound[k] = max(a.rtmin, a.rtmax);
+        if (k > 0)
+            highestBound[k] = max(highestBound[k], highestBound[k - 1]);
+    }
+
     for (unsigned int i = 0; i < eics.size(); i++)
     { //for every sample
         for (unsigned int j = 0; j < eics[i]->peaks.size(); j++)
@@ -951,14 +963,28 @@ vector<PeakGroup> EIC::groupPeaks(vector<EIC *> &eics,
             b.groupNum = -1;
             b.groupOverlap = FLT_MIN;
 
-            vector<Peak>::iterator itr = lower_bound(m->peaks.begin(), m->peaks.end(), b, Peak::compRtMin);
-            int lb = (itr - (m->peaks.begin())) - 1;
-            if (lb < 0)
-                lb = 0;
-            //cerr << "\tb=" << b.rtmin << "<=>" << b.rtmax << " lb=" << lb << endl;
+            //first merged peak that can be scored against this peak; all
+            //merged peaks before it would have been skipped below
+            unsigned int first = 0;
+            if (useOverlap)
+            {
+                first = lower_bound(highestBound.begin(),
+                                    highestBound.end(),
+                                    b.rtmin) - highestBound.begin();
+            }
+            else
+            {
+                auto itr = partition_point(m->peaks.begin(),
+                                           m->peaks.end(),
+                                           [&](const Peak &a) {
+                                               return a.rt < b.rt
+                                                      && abs(b.rt - a.rt) > maxRtDiff;
+                                           });
+                first = itr - m->peaks.begin();
+            }
 
             //Find best matching group
-            for (unsigned int k = 0; k < m->peaks.size(); k++)
+            for (unsigned int k = first; k < m->peaks.size(); k++)
             {
                 Peak &a = m->peaks[k];
 
@@ -984,6 +1010,10 @@ vector<PeakGroup> EIC::groupPeaks(vector<EIC *> &eics,
                 else
                 {
 
+                    //merged peaks are sorted by rt, none of the remaining
+                    //ones can be within the rt window
+                    if (distx > maxRtDiff && a.rt > b.rt)
+                        break;
                     if (distx > maxRtDiff)
                         continue;
 
@@ -1094,6 +1124,82 @@ void EIC::getRTMinMaxPerScan()
     }
 }
 
+void EIC::reduceMzRange(const float *mzs,
+                        const float *intensities,
+                        unsigned int nobs,
+                        float mzmin,
+                        float mzmax,
+                        int eicType,
+                        float &eicMz,
+                        float &eicIntensity)
+{
+    eicMz = 0;
+    eicIntensity = 0;
+
+    //binary search, unless the caller has already positioned the arrays
+    unsigned int lb = 0;
+    if (nobs > 0 && mzs[0] < mzmin)
+        lb = lower_bound(mzs, mzs + nobs, mzmin) - mzs;
+
+    switch ((EIC::EicType)eicType)
+    {
+
+    //takes the sum of all intensities for given m/z range in a scan
+    //associated m/z is the weighted average(with intensities as weights)
+    case EIC::SUM:
+    {
+        float n = 0;
+        for (unsigned int scanIdx = lb; scanIdx < nobs; scanIdx++)
+        {
+            if (mzs[scanIdx] < mzmin)
+                continue;
+            if (mzs[scanIdx] > mzmax)
+                break;
+
+            eicIntensity += intensities[scanIdx];
+            eicMz += mzs[scanIdx] * intensities[scanIdx];
+            n += intensities[scanIdx];
+        }
+        eicMz /= n;
+        break;
+    }
+
+    //takes the maximum intensity for given m/z range in a scan
+    case EIC::MAX:
+    default:
+    {
+        for (unsigned int scanIdx = lb; scanIdx < nobs; scanIdx++)
+        {
+            if (mzs[scanIdx] < mzmin)
+                continue;
+            if (mzs[scanIdx] > mzmax)
+                break;
+
+            if (intensities[scanIdx] > eicIntensity)
+            {
+                eicIntensity = intensities[scanIdx];
+                eicMz = mzs[scanIdx];
+            }
+        }
+        break;
+    }
+    }
+}
+
+void EIC::addScanObservation(int scanNum, float scanRt, float eicMz, float eicIntensity)
+{
+    this->scannum.push_back(scanNum);
+    this->rt.push_back(scanRt);
+    this->intensity.push_back(eicIntensity);
+    this->mz.push_back(eicMz);
+    this->totalIntensity += eicIntensity;
+    if (eicIntensity > this->maxIntensity) {
+        this->maxIntensity = eicIntensity;
+        this->rtAtMaxIntensity = scanRt;
+        this->mzAtMaxIntensity = eicMz;
+    }
+}
+
 /**
  * This is the functon which gets the EIC of the given scan for the
  * given mzmin and mzmax. This function will go through the each scan
@@ -1104,15 +1210,21 @@ void EIC::getRTMinMaxPerScan()
 bool EIC::makeEICSlice(mzSample *sample, float mzmin, float mzmax, float rtmin, float rtmax, int mslevel, int eicType, string filterline)
 {
     float eicMz = 0, eicIntensity = 0;
-    int lb, scanNum;
-    vector<float>::iterator mzItr;
-    deque<Scan *>::iterator scanItr;
-    deque<Scan *> scans;
+    int scanNum;
+    deque<Scan *>::const_iterator scanItr;
+
+    // walk the sample's scans in place, copying the deque for every slice
+    // dominates EIC extraction time for large files
+    const deque<Scan *> &scans = sample->scans;
 
-    scans = sample->scans;
     //binary search rt domain iterator
-    Scan tmpScan(sample, 0, 1, rtmin - 0.1, 0, -1);
-    scanItr = lower_bound(scans.begin(), scans.end(), &tmpScan, Scan::compRt);
+    float rtLowerBound = rtmin - 0.1;
+    scanItr = lower_bound(scans.begin(),
+                          scans.end(),
+                          rtLowerBound,
+                          [](const Scan *scan, float rt) {
+                              return scan->rt < rt;
+                          });
     if (scanItr >= scans.end())
     {
         return false;
@@ -1139,93 +1251,25 @@ bool EIC::makeEICSlice(mzSample *sample, float mzmin, float mzmax, float rtmin,
         Scan *scan = *(scanItr);
         scanNum++;
 
-        if (!(scan->filterLine == filterline || filterline == ""))
-            continue;
         if (scan->mslevel != mslevel)
             continue;
+        if (!(filterline.empty() || scan->filterLine == filterline))
+            continue;
         if (scan->rt < rtmin)
             continue;
         if (scan->rt > rtmax)
             break;
 
-        eicMz = 0;
-        eicIntensity = 0;
-
-        //binary search
-        mzItr = lower_bound(scan->mz.begin(), scan->mz.end(), mzmin);
-        lb = mzItr - scan->mz.begin();
-
-        switch ((EIC::EicType)eicType)
-        {
-
-        //takes the maximum intensity for given m/z range in a scan
-            case EIC::MAX:
-        {
-            for (unsigned int scanIdx = lb; scanIdx < scan->nobs(); scanIdx++)
-            {
-                if (scan->mz[scanIdx] < mzmin)
-                    continue;
-                if (scan->mz[scanIdx] > mzmax)
-                    break;
-
-                if (scan->intensity[scanIdx] > eicIntensity)
-                {
-                    eicIntensity = scan->intensity[scanIdx];
-                    eicMz = scan->mz[scanIdx];
-                }
-            }
-            break;
-        }
-
-        //takes the sum of all intensities for given m/z range in a scan
-        //associated m/z is the weighted average(with intensities as weights)
-        case EIC::SUM:
-        {
-            float n = 0;
-            for (unsigned int scanIdx = lb; scanIdx < scan->nobs(); scanIdx++)
-            {
-                if (scan->mz[scanIdx] < mzmin)
-                    continue;
-                if (scan->mz[scanIdx] > mzmax)
-                    break;
-
-                eicIntensity += scan->intensity[scanIdx];
-                eicMz += scan->mz[scanIdx] * scan->intensity[scanIdx];
-                n += scan->intensity[scanIdx];
-            }
-            eicMz /= n;
-            break;
-        }
-
-        default:
-        {
-            for (unsigned int scanIdx = lb; scanIdx < scan->nobs(); scanIdx++)
-            {
-                if (scan->mz[scanIdx] < mzmin)
-                    continue;
-                if (scan->mz[scanIdx] > mzmax)
-                    break;
-
-                if (scan->intensity[scanIdx] > eicIntensity)
-                {
-                    eicIntensity = scan->intensity[scanIdx];
-                    eicMz = scan->mz[scanIdx];
-                }
-            }
-            break;
-        }
-        }
-
-        this->scannum.push_back(scanNum);
-        this->rt.push_back(scan->rt);
-        this->intensity.push_back(eicIntensity);
-        this->mz.push_back(eicMz);
-        this->totalIntensity += eicIntensity;
-        if (eicIntensity > this->maxIntensity) {
-            this->maxIntensity = eicIntensity;
-            this->rtAtMaxIntensity = scan->rt;
-            this->mzAtMaxIntensity = eicMz;
-        }
+        ScanLoader::Pin pin(sample->scanLoader(), scan);
+        reduceMzRange(scan->mz.data(),
+                      scan->intensity.data(),
+                      scan->nobs(),
+                      mzmin,
+                      mzmax,
+                      eicType,
+                      eicMz,
+                      eicIntensity);
+        addScanObservation(scanNum, scan->rt, eicMz, eicIntensity);
     }
 
     return true;
@@ -227,6 +227,37 @@ class EIC
     */
     bool makeEICSlice(mzSample *sample, float mzmin, float mzmax, float rtmin, float rtmax, int mslevel, int eicType, string filterline);
 
+    /**
+    * @brief reduce the observations of a scan that lie within an m/z range to
+    * a single m/z-intensity pair
+    * @details for EIC::MAX the most intense observation is picked, for
+    * EIC::SUM the intensities are summed up and the m/z is their intensity
+    * weighted average
+    * @param mzs sorted array of m/z values of the scan
+    * @param intensities array of intensities parallel to `mzs`
+    * @param nobs number of observations in the scan
+    * @param mzmin lower bound of the m/z range
+    * @param mzmax upper bound of the m/z range
+    * @param eicType type of EIC (max or sum)
+    * @param eicMz output m/z value
+    * @param eicIntensity output intensity value
+    */
+    static void reduceMzRange(const float *mzs,
+                              const float *intensities,
+                              unsigned int nobs,
+                              float mzmin,
+                              float mzmax,
+                              int eicType,
+                              float &eicMz,
+                              float &eicIntensity);
+
+    /**
+    * @brief append a point, obtained from a single scan, to the EIC
+    * @details also keeps total intensity and the maximum intensity (along with
+    * its rt and m/z) of the EIC up-to-date
+    */
+    void addScanObservation(int scanNum, float scanRt, float eicMz, float eicIntensity);
+
     void getRTMinMaxPerScan();
 
     void normalizeIntensityPerScan(float scale);
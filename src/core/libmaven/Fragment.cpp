@@ -29,6 +29,9 @@ Fragment::Fragment(Scan* scan,
     this->sampleName = scan->sample->sampleName;
     this->scanNum = scan->scannum;
     this->precursorCharge = scan->precursorCharge;
+
+    // the peak data of the scan may have to be loaded first
+    ScanLoader::Pin pin(scan->sample->scanLoader(), scan);
     vector<pair<float, float>> mzarray = scan->getTopPeaks(minFractionalIntensity,
                                                            minSigNoiseRatio,
                                                            5);
@@ -82,23 +82,7 @@ vector<EIC*> PeakDetector::pullEICs(mzSlice* slice,
 
             if (e) {
                 // if eic exists, perform smoothing
-                EIC::SmootherType smootherType =
-                    (EIC::SmootherType)mp->eic_smoothingAlgorithm;
-                e->setSmootherType(smootherType);
-
-                // set appropriate baseline parameters
-                if (mp->aslsBaselineMode) {
-                    e->setBaselineMode(EIC::BaselineMode::AsLSSmoothing);
-                    e->setAsLSSmoothness(mp->aslsSmoothness);
-                    e->setAsLSAsymmetry(mp->aslsAsymmetry);
-                } else {
-                    e->setBaselineMode(EIC::BaselineMode::Threshold);
-                    e->setBaselineSmoothingWindow(mp->baseline_smoothingWindow);
-                    e->setBaselineDropTopX(mp->baseline_dropTopX);
-                }
-                e->setFilterSignalBaselineDiff(mp->minSignalBaselineDifference);
-                e->getPeakPositions(mp->eic_smoothingWindow);
-                // smoohing over
+                _prepareEIC(e, mp);
 
 #pragma omp critical
                 // push eic to all eics vector
@@ -109,6 +93,85 @@ vector<EIC*> PeakDetector::pullEICs(mzSlice* slice,
     return eics;
 }
 
+vector<vector<EIC*>> PeakDetector::pullEICs(const vector<mzSlice*>& slices,
+                                            vector<mzSample*>& samples,
+                                            MavenParameters* mp)
+{
+    vector<vector<EIC*>> eics(slices.size());
+
+    vector<mzSample*> vsamples;
+    for (auto sample : samples) {
+        if (sample == nullptr || sample->isSelected == false)
+            continue;
+        vsamples.push_back(sample);
+    }
+
+    // only slices bounded purely by m/z and RT can be swept in a single pass,
+    // SRM and MRM slices are pulled one at a time
+    vector<mzSlice*> sweepSlices;
+    vector<unsigned int> sweepIndexes;
+    for (unsigned int i = 0; i < slices.size(); i++) {
+        mzSlice* slice = slices[i];
+        Compound* c = slice->compound;
+        if (!slice->srmId.empty()
+            || (c && c->precursorMz() > 0 && c->productMz() > 0)) {
+            eics[i] = pullEICs(slice, samples, mp);
+        } else {
+            sweepSlices.push_back(slice);
+            sweepIndexes.push_back(i);
+        }
+    }
+
+    if (sweepSlices.empty())
+        return eics;
+
+    vector<vector<EIC*>> eicsPerSample(vsamples.size());
+#pragma omp parallel for schedule(dynamic)
+    for (unsigned int i = 0; i < vsamples.size(); i++) {
+        eicsPerSample[i] = vsamples[i]->getEICs(sweepSlices,
+                                                1,
+                                                mp->eicType,
+                                                mp->filterline);
+    }
+
+    // peak picking is spread over all EICs, so that all threads are kept busy
+    // even when there are fewer samples than threads
+    unsigned int eicCount = vsamples.size() * sweepSlices.size();
+#pragma omp parallel for schedule(dynamic, 16)
+    for (unsigned int k = 0; k < eicCount; k++) {
+        _prepareEIC(eicsPerSample[k / sweepSlices.size()][k % sweepSlices.size()],
+                    mp);
+    }
+
+    for (unsigned int j = 0; j < sweepSlices.size(); j++) {
+        vector<EIC*>& sliceEics = eics[sweepIndexes[j]];
+        sliceEics.reserve(vsamples.size());
+        for (unsigned int i = 0; i < vsamples.size(); i++)
+            sliceEics.push_back(eicsPerSample[i][j]);
+    }
+    return eics;
+}
+
+void PeakDetector::_prepareEIC(EIC* e, MavenParameters* mp)
+{
+    EIC::SmootherType smootherType =
+        (EIC::SmootherType)mp->eic_smoothingAlgorithm;
+    e->setSmootherType(smootherType);
+
+    // set appropriate baseline parameters
+    if (mp->aslsBaselineMode) {
+        e->setBaselineMode(EIC::BaselineMode::AsLSSmoothing);
+        e->setAsLSSmoothness(mp->aslsSmoothness);
+        e->setAsLSAsymmetry(mp->aslsAsymmetry);
+    } else {
+        e->setBaselineMode(EIC::BaselineMode::Threshold);
+        e->setBaselineSmoothingWindow(mp->baseline_smoothingWindow);
+        e->setBaselineDropTopX(mp->baseline_dropTopX);
+    }
+    e->setFilterSignalBaselineDiff(mp->minSignalBaselineDifference);
+    e->getPeakPositions(mp->eic_smoothingWindow);
+}
+
 void PeakDetector::processSlices() {
         processSlices(mavenParameters->_slices, "sliceset");
 }
@@ -120,18 +183,25 @@ void PeakDetector::processSlice(mzSlice& slice) {
 }
 
 void PeakDetector::pullAllIsotopes() {
-    for (unsigned int j = 0; j < mavenParameters->allgroups.size(); j++) {
-        if(mavenParameters->stop) break;
-        PeakGroup& group = mavenParameters->allgroups[j];
-        Compound* compound = group.getCompound();
+    if (!mavenParameters->pullIsotopesFlag)
+        return;
 
-        if (mavenParameters->pullIsotopesFlag && !group.isIsotope())
-        {
-            bool C13Flag = mavenParameters->C13Labeled_BPE;
-            bool N15Flag = mavenParameters->N15Labeled_BPE;
-            bool S34Flag = mavenParameters->S34Labeled_BPE;
-            bool D2Flag = mavenParameters->D2Labeled_BPE;
+    bool C13Flag = mavenParameters->C13Labeled_BPE;
+    bool N15Flag = mavenParameters->N15Labeled_BPE;
+    bool S34Flag = mavenParameters->S34Labeled_BPE;
+    bool D2Flag = mavenParameters->D2Labeled_BPE;
+
+    // groups are independent of each other and every thread only adds
+    // children to the group it is currently working on
+    unsigned int progressCount = 0;
+    unsigned int groupCount = mavenParameters->allgroups.size();
+#pragma omp parallel for schedule(dynamic)
+    for (unsigned int j = 0; j < groupCount; j++) {
+        if (mavenParameters->stop)
+            continue;
 
+        PeakGroup& group = mavenParameters->allgroups[j];
+        if (!group.isIsotope()) {
             IsotopeDetection::IsotopeDetectionType isoType;
             isoType = IsotopeDetection::PeakDetection;
 
@@ -145,10 +215,13 @@ void PeakDetector::pullAllIsotopes() {
             isotopeDetection.pullIsotopes(&group);
         }
 
+#pragma omp atomic
+        ++progressCount;
 
-        if (mavenParameters->showProgressFlag &&
-            mavenParameters->pullIsotopesFlag && j % 10 == 0) {
-			sendBoostSignal("Calculating Isotopes", j, mavenParameters->allgroups.size());
+        if (mavenParameters->showProgressFlag && omp_get_thread_num() == 0) {
+            sendBoostSignal("Calculating Isotopes",
+                            progressCount,
+                            groupCount);
         }
     }
 }
@@ -306,7 +379,7 @@ void PeakDetector::processSlices(vector<mzSlice*> &slices, string setName)
     if (slices.empty())
         return;
 
-    // lambda that adds detected groups to mavenparameters
+    // lambda that detects groups for a slice, returning the best ranked ones
     auto detectGroupsForSlice = [&](vector<EIC*>& eics, mzSlice* slice) {
         vector<PeakGroup> peakgroups =
         EIC::groupPeaks(eics,
@@ -329,27 +402,14 @@ void PeakDetector::processSlices(vector<mzSlice*> &slices, string setName)
         std::sort(peakgroups.begin(), peakgroups.end(),
                   PeakGroup::compRank);
 
-        for (unsigned int j = 0; j < peakgroups.size(); j++) {
-            // check for duplicates	and append group
-            if (j >= mavenParameters->eicMaxGroups)
-                break;
-            mavenParameters->allgroups.push_back(peakgroups[j]);
-        }
+        if (peakgroups.size() > mavenParameters->eicMaxGroups)
+            peakgroups.resize(mavenParameters->eicMaxGroups);
+        return peakgroups;
     };
 
-    mavenParameters->allgroups.clear();
-    sort(slices.begin(), slices.end(), mzSlice::compIntensity);
-    for (unsigned int s = 0; s < slices.size(); s++) {
-        if (mavenParameters->stop)
-            break;
-
-        mzSlice* slice = slices[s];
-        Compound *compound = slice->compound;
-
-        vector<EIC*> eics = pullEICs(slice,
-                                     mavenParameters->samples,
-                                     mavenParameters);
-
+    // lambda that finds groups for a slice from its EICs, consuming the EICs
+    auto processSlice = [&](vector<EIC*>& eics, mzSlice* slice) {
+        vector<PeakGroup> peakgroups;
         if (mavenParameters->clsf->hasModel())
             mavenParameters->clsf->scoreEICs(eics);
 
@@ -382,39 +442,86 @@ void PeakDetector::processSlices(vector<mzSlice*> &slices, string setName)
                 eicMaxIntensity = max;
         }
 
-        if (eicMaxIntensity < mavenParameters->minGroupIntensity) {
-            delete_all(eics);
-            continue;
-        }
+        if (eicMaxIntensity >= mavenParameters->minGroupIntensity) {
+            bool isIsotope = false;
+            PeakFiltering peakFiltering(mavenParameters, isIsotope);
+            peakFiltering.filter(eics);
 
-        bool isIsotope = false;
-        PeakFiltering peakFiltering(mavenParameters, isIsotope);
-        peakFiltering.filter(eics);
-
-        detectGroupsForSlice(eics, slice);
+            peakgroups = detectGroupsForSlice(eics, slice);
+        }
 
         // cleanup
         delete_all(eics);
+        return peakgroups;
+    };
+
+    mavenParameters->allgroups.clear();
+    sort(slices.begin(), slices.end(), mzSlice::compIntensity);
 
-        if (mavenParameters->allgroups.size() > mavenParameters->limitGroupCount) {
-            cerr << "Group limit exceeded!" << endl;
+    // EICs are pulled for blocks of slices at a time, so that each sample's
+    // scans are swept once per block instead of once per slice, while keeping
+    // the number of EICs held in memory bounded. Slices of a block are then
+    // processed in parallel and their groups are appended in slice order, so
+    // that the result is the same as when processing slices one at a time.
+    const unsigned int blockSize = 100;
+    bool limitExceeded = false;
+    for (unsigned int blockStart = 0;
+         blockStart < slices.size() && !limitExceeded;
+         blockStart += blockSize) {
+        if (mavenParameters->stop)
             break;
-        }
 
-        if (zeroStatus) {
-            sendBoostSignal("Status", 0, 1);
-            zeroStatus = false;
+        unsigned int blockEnd = std::min((unsigned int)slices.size(),
+                                         blockStart + blockSize);
+        vector<mzSlice*> block(slices.begin() + blockStart,
+                               slices.begin() + blockEnd);
+        vector<vector<EIC*>> blockEics = pullEICs(block,
+                                                  mavenParameters->samples,
+                                                  mavenParameters);
+
+        vector<vector<PeakGroup>> blockGroups(block.size());
+#pragma omp parallel for schedule(dynamic)
+        for (unsigned int i = 0; i < block.size(); i++) {
+            if (mavenParameters->stop)
+                continue;
+            blockGroups[i] = processSlice(blockEics[i], block[i]);
         }
 
-        if (mavenParameters->showProgressFlag && s % 10 == 0) {
-            string progressText = "Found "
-                                  + to_string(mavenParameters->allgroups.size())
-                                  + " "
-                                  + setName;
-            sendBoostSignal(progressText,
-                            s + 1,
-                            std::min((int)slices.size(),
-                                     mavenParameters->limitGroupCount));
+        // release EICs of slices skipped due to an early exit
+        for (auto& eics : blockEics)
+            delete_all(eics);
+
+        for (unsigned int s = blockStart; s < blockEnd; s++) {
+            if (mavenParameters->stop)
+                break;
+
+            vector<PeakGroup>& peakgroups = blockGroups[s - blockStart];
+            mavenParameters->allgroups.insert(mavenParameters->allgroups.end(),
+                                              peakgroups.begin(),
+                                              peakgroups.end());
+
+            if (mavenParameters->allgroups.size()
+                > mavenParameters->limitGroupCount) {
+                cerr << "Group limit exceeded!" << endl;
+                limitExceeded = true;
+                break;
+            }
+
+            if (zeroStatus) {
+                sendBoostSignal("Status", 0, 1);
+                zeroStatus = false;
+            }
+
+            if (mavenParameters->showProgressFlag && s % 10 == 0) {
+                string progressText = "Found "
+                                      + to_string(mavenParameters->allgroups.size())
+                                      + " "
+                                      + setName;
+                sendBoostSignal(progressText,
+                                s + 1,
+                                std::min((int)slices.size(),
+                                         mavenParameters->limitGroupCount));
+            }
         }
     }
 }
@@ -129,6 +129,22 @@ public:
                                  std::vector<mzSample*>& samples,
                                  MavenParameters* mp);
 
+    /**
+     * @brief Pull EICs for a block of slices from all selected samples.
+     * @details Slices bounded only by m/z and RT are extracted from each
+     * sample in a single sweep over its scans (see `mzSample::getEICs`),
+     * whereas SRM and MRM slices are pulled one at a time.
+     * @param slices A vector of slices for which EICs should be pulled.
+     * @param samples A vector of samples from which EICs should be pulled.
+     * @param mp Parameters used for smoothing and baseline estimation.
+     * @return A vector of EICs for each slice, in the order of the given
+     * slices. Within each vector, EICs follow the order of the samples.
+     */
+    static std::vector<std::vector<EIC*>> pullEICs(
+        const std::vector<mzSlice*>& slices,
+        std::vector<mzSample*>& samples,
+        MavenParameters* mp);
+
     /**
      * @brief This method can be used to identify features found by performing
      * untargeted detection.
@@ -151,6 +167,12 @@ public:
 	 */
 	MavenParameters* mavenParameters;
 	bool zeroStatus;
+
+    /**
+     * @brief Set smoothing and baseline parameters of an EIC and find its
+     * peaks.
+     */
+    static void _prepareEIC(EIC* e, MavenParameters* mp);
 };
 
 #endif // PEAKDETECTOR_H
@@ -13,6 +13,7 @@ PeakGroup::PeakGroup()  {
     metaGroupId=0;
     clusterId = 0;
     groupRank=INT_MAX;
+    quantitationType = AreaTop;
 
     maxIntensity=0;
     maxAreaTopIntensity = 0;
@@ -88,6 +89,7 @@ void PeakGroup::copyObj(const PeakGroup& o)  {
     metaGroupId= o.metaGroupId;
     clusterId = o.clusterId;
     groupRank= o.groupRank;
+    quantitationType = o.quantitationType;
 
     minQuality = o.minQuality;
     minIntensity = o.minIntensity;
@@ -29,7 +29,10 @@ vector<mzSlice*> SRMList::getSrmSlices(double amuQ1, double amuQ3, int userPolar
             if (filterLine.isEmpty()) continue;
 
             if (seenMRMS.contains(filterLine)){
-                if(scan->intensity[0] <= seenMRMS.value(filterLine)->intensity[0]) continue;
+                Scan* seenScan = seenMRMS.value(filterLine);
+                ScanLoader::Pin pin(sample->scanLoader(), scan);
+                ScanLoader::Pin seenPin(seenScan->sample->scanLoader(), seenScan);
+                if(scan->intensity[0] <= seenScan->intensity[0]) continue;
             }
 
             seenMRMS.insert(filterLine, scan);
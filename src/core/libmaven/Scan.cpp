@@ -18,6 +18,8 @@ Scan::Scan(mzSample* sample, int scannum, int mslevel, float rt, float precursor
 	this->precursorCharge = 0;
 	this->precursorIntensity = 0;
     this->isolationWindow = 1;
+    this->peakSummary = {0.0f, 0.0f, 0.0f, 0.0f, 0.0f};
+    this->peakSummaryValid = false;
 }
 
 void Scan::deepcopy(Scan* b) {
@@ -39,7 +41,37 @@ void Scan::deepcopy(Scan* b) {
     this->setPolarity( b->getPolarity() );
     this->originalRt = b->originalRt;
     this->isolationWindow = b->isolationWindow;
+    this->peakSummary = b->peakSummary;
+    this->peakSummaryValid = b->peakSummaryValid;
+}
+
+Scan::PeakSummary Scan::computePeakSummary() const {
+    PeakSummary summary = {0.0f, 0.0f, 0.0f, 0.0f, 0.0f};
+
+    // accumulate in double, so that the total of scans with many
+    // observations does not lose precision
+    double total = 0.0;
+    for (unsigned int i = 0; i < intensity.size(); i++) {
+        total += intensity[i];
+        if (intensity[i] > summary.maxIntensity) {
+            summary.maxIntensity = intensity[i];
+            if (i < mz.size())
+                summary.basePeakMz = mz[i];
+        }
+    }
+    summary.totalIntensity = static_cast<float>(total);
+
+    if (!mz.empty()) {
+        auto range = std::minmax_element(mz.begin(), mz.end());
+        summary.minMz = *range.first;
+        summary.maxMz = *range.second;
+    }
+    return summary;
+}
 
+void Scan::summarizePeaks() {
+    peakSummary = computePeakSummary();
+    peakSummaryValid = true;
 }
 
 int Scan::findHighestIntensityPos(float _mz, MassCutoff *massCutoff) {
@@ -106,6 +138,7 @@ vector<int> Scan::findMatchingMzs(float mzmin, float mzmax) {
 void Scan::quantileFilter(int minQuantile) {
         if (intensity.size() == 0 ) return;
         if( minQuantile <= 0 || minQuantile >= 100 ) return;
+        peakSummaryValid = false;
 
         int vsize=intensity.size();
         vector<float>dist = quantileDistribution(this->intensity);
@@ -125,6 +158,7 @@ void Scan::quantileFilter(int minQuantile) {
 
 void Scan::intensityFilter(int minIntensity) {
         if (intensity.size() == 0 ) return;
+        peakSummaryValid = false;
 
         //first pass.. find local maxima in intensity space
         int vsize=intensity.size();
@@ -145,6 +179,7 @@ void Scan::intensityFilter(int minIntensity) {
 void Scan::simpleCentroid() {
 
         if (intensity.size() < 5 ) return;
+        peakSummaryValid = false;
 
         vector<float> spline=smoothenIntensitites();
 
@@ -239,17 +274,17 @@ vector<float> Scan::chargeSeries(float Mx, unsigned int Zx) {
 }
 
 
-bool Scan::setParentPeakData(float mzfocus,  float noiseLevel, MassCutoff *massCutoffMerge,float minSigNoiseRatio) {
+bool Scan::setParentPeakData(float mzfocus,  float noiseLevel, MassCutoff *massCutoffMerge,float minSigNoiseRatio, float *parentPeakIntensity) {
     bool flag=true;
     int mzfocus_pos = this->findHighestIntensityPos(mzfocus,massCutoffMerge);
     if (mzfocus_pos < 0 ) { cout << "ERROR: Can't find parent " << mzfocus << endl; flag=false; return flag; }
-    parentPeakIntensity=this->intensity[mzfocus_pos];
-    float parentPeakSN=parentPeakIntensity/noiseLevel;
+    *parentPeakIntensity=this->intensity[mzfocus_pos];
+    float parentPeakSN=*parentPeakIntensity/noiseLevel;
     if(parentPeakSN <=minSigNoiseRatio){ flag=false; return flag;}
     return flag;
 }
 
-void Scan::initialiseBrotherData(int z, float mzfocus) {
+void Scan::initialiseBrotherData(BrotherData *brotherdata, int z, float mzfocus) {
         brotherdata->expectedMass = (mzfocus*z)-z;     //predict what M ought to be
         brotherdata->countMatches=0;
         brotherdata->totalIntensity=0;
@@ -259,7 +294,7 @@ void Scan::initialiseBrotherData(int z, float mzfocus) {
         brotherdata->maxZ=z;
 }
 
-void Scan::updateBrotherDataIfPeakFound(int loopdirection, int ii, bool *flag, bool *lastMatched, float *lastIntensity, float noiseLevel,  MassCutoff *massCutoffMerge) {
+void Scan::updateBrotherDataIfPeakFound(BrotherData *brotherdata, int loopdirection, int ii, bool *flag, bool *lastMatched, float *lastIntensity, float noiseLevel,  MassCutoff *massCutoffMerge) {
 
             float brotherMz = (brotherdata->expectedMass+ii)/ii;
             int pos = this->findHighestIntensityPos(brotherMz, massCutoffMerge);
@@ -286,11 +321,12 @@ void Scan::updateBrotherDataIfPeakFound(int loopdirection, int ii, bool *flag, b
 
 }
 
-void Scan::findBrotherPeaks (ChargedSpecies* x, float mzfocus, float noiseLevel,  MassCutoff *massCutoffMerge,int minDeconvolutionCharge, int maxDeconvolutionCharge, int minDeconvolutionMass, int maxDeconvolutionMass, int minChargedStates) {
-    brotherdata=&b;
+void Scan::findBrotherPeaks (ChargedSpecies* x, float mzfocus, float parentPeakIntensity, float noiseLevel,  MassCutoff *massCutoffMerge,int minDeconvolutionCharge, int maxDeconvolutionCharge, int minDeconvolutionMass, int maxDeconvolutionMass, int minChargedStates) {
+    BrotherData b;
+    BrotherData *brotherdata=&b;
     for(int z=minDeconvolutionCharge; z <= maxDeconvolutionCharge; z++ ) {
 
-        initialiseBrotherData(z,mzfocus);
+        initialiseBrotherData(brotherdata,z,mzfocus);
 
         if (brotherdata->expectedMass >= maxDeconvolutionMass || brotherdata->expectedMass <= minDeconvolutionMass ) continue;
         bool flag=true;
@@ -299,7 +335,7 @@ void Scan::findBrotherPeaks (ChargedSpecies* x, float mzfocus, float noiseLevel,
         loopdirection=1;
         float lastIntensity=parentPeakIntensity;
         for(int ii=z; ii < z+50 && ii<maxDeconvolutionCharge; ii++ ) {
-            updateBrotherDataIfPeakFound(loopdirection,ii,&flag, &lastMatched,&lastIntensity,noiseLevel,massCutoffMerge);
+            updateBrotherDataIfPeakFound(brotherdata,loopdirection,ii,&flag, &lastMatched,&lastIntensity,noiseLevel,massCutoffMerge);
             if (flag==false)
                break;
         }
@@ -309,19 +345,19 @@ void Scan::findBrotherPeaks (ChargedSpecies* x, float mzfocus, float noiseLevel,
         loopdirection=-1;
         lastIntensity=parentPeakIntensity;
         for(int ii=z-1; ii > z-50 && ii>minDeconvolutionCharge; ii--) {
-             updateBrotherDataIfPeakFound(loopdirection,ii,&flag, &lastMatched,&lastIntensity,noiseLevel,massCutoffMerge);
+             updateBrotherDataIfPeakFound(brotherdata,loopdirection,ii,&flag, &lastMatched,&lastIntensity,noiseLevel,massCutoffMerge);
              if (flag==false)
                  break;
         }
 
-        updateChargedSpeciesDataAndFindQScore(x, z, mzfocus,noiseLevel,massCutoffMerge,minChargedStates);
+        updateChargedSpeciesDataAndFindQScore(brotherdata, x, z, mzfocus,noiseLevel,massCutoffMerge,minChargedStates);
 
     }
     // done..
 }
 
 
-void Scan::updateChargedSpeciesDataAndFindQScore(ChargedSpecies* x, int z,float mzfocus, float noiseLevel,  MassCutoff *massCutoffMerge, int minChargedStates) {
+void Scan::updateChargedSpeciesDataAndFindQScore(BrotherData *brotherdata, ChargedSpecies* x, int z,float mzfocus, float noiseLevel,  MassCutoff *massCutoffMerge, int minChargedStates) {
         if (x->totalIntensity < brotherdata->totalIntensity && brotherdata->countMatches>minChargedStates && brotherdata->upCount >= 2 && brotherdata->downCount >= 2 ) {
                 x->totalIntensity = brotherdata->totalIntensity;
                 x->countMatches=brotherdata->countMatches;
@@ -356,7 +392,8 @@ void Scan::updateChargedSpeciesDataAndFindQScore(ChargedSpecies* x, int z,float
 ChargedSpecies* Scan::deconvolute(float mzfocus, float noiseLevel,  MassCutoff *massCutoffMerge, float minSigNoiseRatio, int minDeconvolutionCharge, int maxDeconvolutionCharge, int minDeconvolutionMass, int maxDeconvolutionMass, int minChargedStates ) {
 
 
-    bool flag=setParentPeakData(mzfocus,noiseLevel,massCutoffMerge,minSigNoiseRatio);
+    float parentPeakIntensity=0;
+    bool flag=setParentPeakData(mzfocus,noiseLevel,massCutoffMerge,minSigNoiseRatio,&parentPeakIntensity);
 
         if (flag==false)
             return NULL;
@@ -366,7 +403,7 @@ ChargedSpecies* Scan::deconvolute(float mzfocus, float noiseLevel,  MassCutoff *
     for(unsigned int i=0; i<this->nobs();i++) scanTotalIntensity+=this->intensity[i];
 
     ChargedSpecies* x = new ChargedSpecies();
-    findBrotherPeaks (x, mzfocus, noiseLevel, massCutoffMerge, minDeconvolutionCharge, maxDeconvolutionCharge, minDeconvolutionMass, maxDeconvolutionMass, minChargedStates);
+    findBrotherPeaks (x, mzfocus, parentPeakIntensity, noiseLevel, massCutoffMerge, minDeconvolutionCharge, maxDeconvolutionCharge, minDeconvolutionMass, maxDeconvolutionMass, minChargedStates);
 
 
     if ( x->countMatches > minChargedStates ) {
@@ -380,12 +417,11 @@ ChargedSpecies* Scan::deconvolute(float mzfocus, float noiseLevel,  MassCutoff *
 }
 
 void Scan::findError(ChargedSpecies* x) {
-            float totalError=0; brotherdata->totalIntensity=0;
+            float totalError=0;
             for(unsigned int i=0; i < x->observedCharges.size(); i++ ) {
                     float My = (x->observedMzs[i]*x->observedCharges[i]) - x->observedCharges[i];
                     float deltaM = abs(x->deconvolutedMass - My);
                     totalError += deltaM*deltaM;
-                    brotherdata->totalIntensity += x->observedIntensities[i];
             }
             //cout << "\t" << mzfocus << " matches=" << x->countMatches << " totalInts=" << x->totalIntensity << " Score=" << x->qscore << endl;
             x->error = sqrt(totalError/x->countMatches);
@@ -563,6 +599,7 @@ void Scan::recalculatePrecursorMz(float ppm)
     Scan* fullScan = getLastFullScan(50);
     if (!fullScan)
         return;
+    ScanLoader::Pin pin(sample->scanLoader(), fullScan);
     
     MassCutoff* massCutoff = new MassCutoff();
     massCutoff->setMassCutoffAndType(ppm, "ppm");
@@ -587,6 +624,7 @@ vector<mzPoint> Scan::getIsolatedRegion(float isolationWindowAmu)
 	//find last ms1 scan or get out
 	Scan* lastFullScan = this->getLastFullScan();
 	if (!lastFullScan) return isolatedSegment;
+	ScanLoader::Pin pin(sample->scanLoader(), lastFullScan);
 
 	//no precursor information
 	if (this->precursorMz <= 0) return isolatedSegment;
@@ -617,6 +655,7 @@ double Scan::getPrecursorPurity(float ppm)
     //get last full scan
     Scan* lastFullScan = this->getLastFullScan();
     if (!lastFullScan) return 0;
+    ScanLoader::Pin pin(sample->scanLoader(), lastFullScan);
 
     //locate intensity of isolated mass
     MassCutoff* massCutoff = new MassCutoff();
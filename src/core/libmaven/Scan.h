@@ -6,6 +6,7 @@
 #include <QStringList>
 
 #include "standardincludes.h"
+#include "stringpool.h"
 
 class mzSample;
 class mzPoint;
@@ -38,22 +39,30 @@ class Scan
      * @brief Obtain the smallest m/z value stored.
      * @return Fractional m/z value.
      */
-    inline float minMz() {
-        if(nobs() > 0)
-            return *(std::min_element(begin(mz),
-                                      end(mz)));
-        return 0.0f;
-    }
+    inline float minMz() const { return currentPeakSummary().minMz; }
 
     /**
      * @brief Obtain the largest m/z value stored.
      * @return Fractional m/z value.
      */
-    inline float maxMz() {
-        if(nobs() > 0)
-            return *(std::max_element(begin(mz),
-                                      end(mz)));
-        return 0.0f; }
+    inline float maxMz() const { return currentPeakSummary().maxMz; }
+
+    /**
+     * @brief Compute the summary statistics of the peak data (total and
+     * maximum intensity, m/z range) and keep them, so that their accessors
+     * no longer walk the arrays.
+     * @details Done when a scan is added to its sample. The filters of the
+     * scan discard the summary again. Code that changes `mz` or `intensity`
+     * of a summarized scan directly has to call this again afterwards.
+     * The summary stays valid while the peak data of a lazily loaded or
+     * compact scan is not in memory.
+     */
+    void summarizePeaks();
+
+    /**
+     * @brief Whether the summary statistics of the scan are kept.
+     */
+    inline bool hasPeakSummary() const { return peakSummaryValid; }
 
     /**
     *@brief return the corresponding sample
@@ -110,29 +119,26 @@ class Scan
     * @brief Calculate the sum of all the intensities for a scan
     * @return return total intensity
     */
-    int totalIntensity() const
+    inline float totalIntensity() const
     {
-        int sum = 0;
-        for (unsigned int i = 0; i < intensity.size(); i++)
-            sum += intensity[i];
-        return sum;
+        return currentPeakSummary().totalIntensity;
     }
 
-
     //TODO: basePeakIntensity value in every scan of mzXml file represents maxIntensity. Use it rather than looping over all the  intensities
     /**
     * @brief return the maxIntensity in scan
     */
-
-    float maxIntensity()
+    inline float maxIntensity() const
     {
-        float max = 0;
-        for (unsigned int i = 0; i < intensity.size(); i++)
-            if (intensity[i] > max)
-                max = intensity[i];
-        return max;
+        return currentPeakSummary().maxIntensity;
     }
 
+    /**
+    * @brief return the m/z of the most intense observation in scan, 0 if
+    * the scan has no observation with positive intensity
+    */
+    inline float basePeakMz() const { return currentPeakSummary().basePeakMz; }
+
     /**
     * @brief return pairs of m/z, intensity values for top intensities.
     * @details intensities are normalized to a maximum intensity in a scan * 100]
@@ -214,8 +220,8 @@ class Scan
 
     vector<float> intensity; /**< intensities found in one scan */
     vector<float> mz; /**< m/z's found in one scan */
-    string scanType;
-    string filterLine;
+    InternedString scanType; /**< shared with the other scans of the sample */
+    InternedString filterLine; /**< shared with the other scans of the sample */
     mzSample *sample; /**< sample corresponding to the scan */
     int polarity; /**< +1 for positively charged, -1 for negatively charged, 0 for neutral*/
 
@@ -240,8 +246,27 @@ class Scan
     bool operator<(const Scan &b) const { return rt < b.rt; }
 
   private:
-    float parentPeakIntensity;
+    struct PeakSummary
+    {
+        float totalIntensity;
+        float maxIntensity;
+        float basePeakMz;
+        float minMz;
+        float maxMz;
+    };
 
+    PeakSummary peakSummary;
+    bool peakSummaryValid;
+    PeakSummary computePeakSummary() const;
+    inline PeakSummary currentPeakSummary() const
+    {
+        return peakSummaryValid ? peakSummary : computePeakSummary();
+    }
+
+    /**
+     * @brief charge-state ladder followed while deconvoluting a peak; kept on
+     * the stack of `deconvolute` rather than in every scan
+     */
     struct BrotherData
     {
         float expectedMass;
@@ -253,13 +278,11 @@ class Scan
         int maxZ;
     };
 
-    ofstream file;
-    BrotherData *brotherdata, b;
-    void initialiseBrotherData(int z, float mzfocus);
-    void updateBrotherDataIfPeakFound(int loopdirection, int ii, bool *flag, bool *lastMatched, float *lastIntensity, float noiseLevel, MassCutoff *massCutoffMerge);
-    void updateChargedSpeciesDataAndFindQScore(ChargedSpecies *x, int z, float mzfocus, float noiseLevel, MassCutoff *massCutoffMerge, int minChargedStates);
-    void findBrotherPeaks(ChargedSpecies *x, float mzfocus, float noiseLevel, MassCutoff *massCutoffMerge, int minDeconvolutionCharge, int maxDeconvolutionCharge, int minDeconvolutionMass, int maxDeconvolutionMass, int minChargedStates);
-    bool setParentPeakData(float mzfocus, float noiseLevel, MassCutoff *massCutoffMerge, float minSigNoiseRatio);
+    void initialiseBrotherData(BrotherData *brotherdata, int z, float mzfocus);
+    void updateBrotherDataIfPeakFound(BrotherData *brotherdata, int loopdirection, int ii, bool *flag, bool *lastMatched, float *lastIntensity, float noiseLevel, MassCutoff *massCutoffMerge);
+    void updateChargedSpeciesDataAndFindQScore(BrotherData *brotherdata, ChargedSpecies *x, int z, float mzfocus, float noiseLevel, MassCutoff *massCutoffMerge, int minChargedStates);
+    void findBrotherPeaks(ChargedSpecies *x, float mzfocus, float parentPeakIntensity, float noiseLevel, MassCutoff *massCutoffMerge, int minDeconvolutionCharge, int maxDeconvolutionCharge, int minDeconvolutionMass, int maxDeconvolutionMass, int minChargedStates);
+    bool setParentPeakData(float mzfocus, float noiseLevel, MassCutoff *massCutoffMerge, float minSigNoiseRatio, float *parentPeakIntensity);
     void findError(ChargedSpecies *x);
     
     /**
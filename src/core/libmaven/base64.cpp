@@ -1,46 +1,237 @@
 #include "base64.h"
 #include "mzUtils.h"
 
+#if defined(__GNUC__) && (defined(__x86_64__) || defined(__i386__))
+#define BASE64_X86_SIMD
+#include <immintrin.h>
+#endif
+
 using namespace std;
 
 namespace base64 {
-    string decodeString(const char *data, const size_t len)
+    static const int B64index[256] = {
+        0,  0,  0,  0,  0,  0,  0,  0,  0,  0,  0,  0,  0,  0,  0,  0,
+        0,  0,  0,  0,  0,  0,  0,  0,  0,  0,  0,  0,  0,  0,  0,  0,
+        0,  0,  0,  0,  0,  0,  0,  0,  0,  0,  0,  62, 63, 62, 62, 63,
+        52, 53, 54, 55, 56, 57, 58, 59, 60, 61, 0,  0,  0,  0,  0,  0,
+        0,  0,  1,  2,  3,  4,  5,  6,  7,  8,  9,  10, 11, 12, 13, 14,
+        15, 16, 17, 18, 19, 20, 21, 22, 23, 24, 25, 0,  0,  0,  0,  63,
+        0,  26, 27, 28, 29, 30, 31, 32, 33, 34, 35, 36, 37, 38, 39, 40,
+        41, 42, 43, 44, 45, 46, 47, 48, 49, 50, 51
+    };
+
+    /**
+     * Decode complete groups of four characters, through the lookup table.
+     * Returns the number of bytes written.
+     */
+    static size_t decodeQuadsScalar(const unsigned char* p,
+                                    size_t len,
+                                    char* dest)
     {
-        unsigned char* p = (unsigned char*)data;
-        int pad = len > 0 && (len % 4 || p[len - 1] == '=');
-        const size_t L = ((len + 3) / 4 - pad) * 4;
-        std::string str(L / 4 * 3 + pad, '\0');
-
-        const int B64index[256] = {
-            0,  0,  0,  0,  0,  0,  0,  0,  0,  0,  0,  0,  0,  0,  0,  0,
-            0,  0,  0,  0,  0,  0,  0,  0,  0,  0,  0,  0,  0,  0,  0,  0,
-            0,  0,  0,  0,  0,  0,  0,  0,  0,  0,  0,  62, 63, 62, 62, 63,
-            52, 53, 54, 55, 56, 57, 58, 59, 60, 61, 0,  0,  0,  0,  0,  0,
-            0,  0,  1,  2,  3,  4,  5,  6,  7,  8,  9,  10, 11, 12, 13, 14,
-            15, 16, 17, 18, 19, 20, 21, 22, 23, 24, 25, 0,  0,  0,  0,  63,
-            0,  26, 27, 28, 29, 30, 31, 32, 33, 34, 35, 36, 37, 38, 39, 40,
-            41, 42, 43, 44, 45, 46, 47, 48, 49, 50, 51
-        };
-
-        for (size_t i = 0, j = 0; i < L; i += 4)
-        {
+        size_t j = 0;
+        for (size_t i = 0; i < len; i += 4) {
             int n = B64index[p[i]] << 18 | B64index[p[i + 1]] << 12
                     | B64index[p[i + 2]] << 6 | B64index[p[i + 3]];
-            str[j++] = n >> 16;
-            str[j++] = n >> 8 & 0xFF;
-            str[j++] = n & 0xFF;
+            dest[j++] = n >> 16;
+            dest[j++] = n >> 8 & 0xFF;
+            dest[j++] = n & 0xFF;
         }
-        if (pad)
-        {
-            int n = B64index[p[L]] << 18 | B64index[p[L + 1]] << 12;
-            str[str.size() - 1] = n >> 16;
+        return j;
+    }
+
+#ifdef BASE64_X86_SIMD
+    // The vectorised decoders translate 16 (or 32) characters at a time, by
+    // classifying them on their high and low nibbles. Blocks holding anything
+    // other than the standard alphabet are left to the scalar decoder, which
+    // also accepts the URL-safe characters. Each block is stored as a whole,
+    // so a few bytes past its output are overwritten and decoding stops early
+    // enough for the following block to fit in the destination.
+
+    __attribute__((target("ssse3")))
+    static size_t decodeQuadsSSSE3(const unsigned char* p,
+                                   size_t len,
+                                   char* dest)
+    {
+        const __m128i lutLo = _mm_setr_epi8(0x15, 0x11, 0x11, 0x11,
+                                            0x11, 0x11, 0x11, 0x11,
+                                            0x11, 0x11, 0x13, 0x1A,
+                                            0x1B, 0x1B, 0x1B, 0x1A);
+        const __m128i lutHi = _mm_setr_epi8(0x10, 0x10, 0x01, 0x02,
+                                            0x04, 0x08, 0x04, 0x08,
+                                            0x10, 0x10, 0x10, 0x10,
+                                            0x10, 0x10, 0x10, 0x10);
+        const __m128i lutRoll = _mm_setr_epi8(0, 16, 19, 4, -65, -65, -71, -71,
+                                              0, 0, 0, 0, 0, 0, 0, 0);
+        const __m128i mask2F = _mm_set1_epi8(0x2F);
+        const __m128i pack = _mm_setr_epi8(2, 1, 0, 6, 5, 4, 10, 9,
+                                           8, 14, 13, 12, -1, -1, -1, -1);
+
+        size_t i = 0, j = 0;
+        while (i + 24 <= len) {
+            __m128i in = _mm_loadu_si128((const __m128i*) (p + i));
+            __m128i hiNibbles = _mm_and_si128(_mm_srli_epi32(in, 4), mask2F);
+            __m128i loNibbles = _mm_and_si128(in, mask2F);
+            __m128i hi = _mm_shuffle_epi8(lutHi, hiNibbles);
+            __m128i lo = _mm_shuffle_epi8(lutLo, loNibbles);
+            __m128i invalid = _mm_cmpgt_epi8(_mm_and_si128(lo, hi),
+                                             _mm_setzero_si128());
+            if (_mm_movemask_epi8(invalid)) {
+                j += decodeQuadsScalar(p + i, 16, dest + j);
+                i += 16;
+                continue;
+            }
+
+            __m128i eq2F = _mm_cmpeq_epi8(in, mask2F);
+            __m128i roll = _mm_shuffle_epi8(lutRoll,
+                                            _mm_add_epi8(eq2F, hiNibbles));
+            __m128i values = _mm_add_epi8(in, roll);
+
+            // merge four 6-bit values into three bytes
+            __m128i merged = _mm_maddubs_epi16(values,
+                                               _mm_set1_epi32(0x01400140));
+            merged = _mm_madd_epi16(merged, _mm_set1_epi32(0x00011000));
+            merged = _mm_shuffle_epi8(merged, pack);
+            _mm_storeu_si128((__m128i*) (dest + j), merged);
+
+            i += 16;
+            j += 12;
+        }
+        return j + decodeQuadsScalar(p + i, len - i, dest + j);
+    }
+
+    __attribute__((target("avx2")))
+    static size_t decodeQuadsAVX2(const unsigned char* p,
+                                  size_t len,
+                                  char* dest)
+    {
+        const __m256i lutLo = _mm256_setr_epi8(0x15, 0x11, 0x11, 0x11,
+                                               0x11, 0x11, 0x11, 0x11,
+                                               0x11, 0x11, 0x13, 0x1A,
+                                               0x1B, 0x1B, 0x1B, 0x1A,
+                                               0x15, 0x11, 0x11, 0x11,
+                                               0x11, 0x11, 0x11, 0x11,
+                                               0x11, 0x11, 0x13, 0x1A,
+                                               0x1B, 0x1B, 0x1B, 0x1A);
+        const __m256i lutHi = _mm256_setr_epi8(0x10, 0x10, 0x01, 0x02,
+                                               0x04, 0x08, 0x04, 0x08,
+                                               0x10, 0x10, 0x10, 0x10,
+                                               0x10, 0x10, 0x10, 0x10,
+                                               0x10, 0x10, 0x01, 0x02,
+                                               0x04, 0x08, 0x04, 0x08,
+                                               0x10, 0x10, 0x10, 0x10,
+                                               0x10, 0x10, 0x10, 0x10);
+        const __m256i lutRoll = _mm256_setr_epi8(0, 16, 19, 4, -65, -65, -71, -71,
+                                                 0, 0, 0, 0, 0, 0, 0, 0,
+                                                 0, 16, 19, 4, -65, -65, -71, -71,
+                                                 0, 0, 0, 0, 0, 0, 0, 0);
+        const __m256i mask2F = _mm256_set1_epi8(0x2F);
+        const __m256i pack = _mm256_setr_epi8(2, 1, 0, 6, 5, 4, 10, 9,
+                                              8, 14, 13, 12, -1, -1, -1, -1,
+                                              2, 1, 0, 6, 5, 4, 10, 9,
+                                              8, 14, 13, 12, -1, -1, -1, -1);
+        const __m256i lanes = _mm256_setr_epi32(0, 1, 2, 4, 5, 6, -1, -1);
+
+        size_t i = 0, j = 0;
+        while (i + 44 <= len) {
+            __m256i in = _mm256_loadu_si256((const __m256i*) (p + i));
+            __m256i hiNibbles = _mm256_and_si256(_mm256_srli_epi32(in, 4),
+                                                 mask2F);
+            __m256i loNibbles = _mm256_and_si256(in, mask2F);
+            __m256i hi = _mm256_shuffle_epi8(lutHi, hiNibbles);
+            __m256i lo = _mm256_shuffle_epi8(lutLo, loNibbles);
+            __m256i invalid = _mm256_cmpgt_epi8(_mm256_and_si256(lo, hi),
+                                                _mm256_setzero_si256());
+            if (_mm256_movemask_epi8(invalid)) {
+                j += decodeQuadsScalar(p + i, 32, dest + j);
+                i += 32;
+                continue;
+            }
+
+            __m256i eq2F = _mm256_cmpeq_epi8(in, mask2F);
+            __m256i roll = _mm256_shuffle_epi8(lutRoll,
+                                               _mm256_add_epi8(eq2F, hiNibbles));
+            __m256i values = _mm256_add_epi8(in, roll);
+
+            // merge four 6-bit values into three bytes, then move the
+            // 12 bytes of each lane next to each other
+            __m256i merged = _mm256_maddubs_epi16(values,
+                                                  _mm256_set1_epi32(0x01400140));
+            merged = _mm256_madd_epi16(merged, _mm256_set1_epi32(0x00011000));
+            merged = _mm256_shuffle_epi8(merged, pack);
+            merged = _mm256_permutevar8x32_epi32(merged, lanes);
+            _mm256_storeu_si256((__m256i*) (dest + j), merged);
+
+            i += 32;
+            j += 24;
+        }
+        return j + decodeQuadsSSSE3(p + i, len - i, dest + j);
+    }
+#endif
+
+    typedef size_t (*QuadDecoder)(const unsigned char*, size_t, char*);
+
+    static QuadDecoder selectQuadDecoder()
+    {
+#ifdef BASE64_X86_SIMD
+        __builtin_cpu_init();
+        if (__builtin_cpu_supports("avx2"))
+            return decodeQuadsAVX2;
+        if (__builtin_cpu_supports("ssse3"))
+            return decodeQuadsSSSE3;
+#endif
+        return decodeQuadsScalar;
+    }
+
+    /**
+     * Length of the input that consists of complete groups of four
+     * characters, leaving out a final group that is padded or incomplete.
+     */
+    static size_t quadLength(const char* data, const size_t len)
+    {
+        const unsigned char* p = (const unsigned char*)data;
+        int pad = len > 0 && (len % 4 || p[len - 1] == '=');
+        return ((len + 3) / 4 - pad) * 4;
+    }
+
+    size_t decodedSize(const char* data, const size_t len)
+    {
+        const unsigned char* p = (const unsigned char*)data;
+        size_t L = quadLength(data, len);
+        size_t size = L / 4 * 3;
+        if (L < len) {
+            size++;
+            if (len > L + 2 && p[L + 2] != '=')
+                size++;
+        }
+        return size;
+    }
+
+    size_t decodeBytes(const char* data, const size_t len, char* dest)
+    {
+        static const QuadDecoder decodeQuads = selectQuadDecoder();
+
+        const unsigned char* p = (const unsigned char*)data;
+        size_t L = quadLength(data, len);
+        size_t j = decodeQuads(p, L, dest);
+        if (L < len) {
+            int c1 = len > L + 1 ? B64index[p[L + 1]] : 0;
+            int n = B64index[p[L]] << 18 | c1 << 12;
+            dest[j++] = n >> 16;
 
             if (len > L + 2 && p[L + 2] != '=')
             {
                 n |= B64index[p[L + 2]] << 6;
-                str.push_back(n >> 8 & 0xFF);
+                dest[j++] = n >> 8 & 0xFF;
             }
         }
+        return j;
+    }
+
+    string decodeString(const char *data, const size_t len)
+    {
+        std::string str(decodedSize(data, len), '\0');
+        if (!str.empty())
+            decodeBytes(data, len, &str[0]);
         return str;
     }
 
@@ -49,51 +240,78 @@ namespace base64 {
                                bool neworkorder,
                                bool decompress)
     {
-        string destStr = decodeString(src.c_str(), src.size());
+        return decodeBase64(src.data(),
+                            src.size(),
+                            float_size,
+                            neworkorder,
+                            decompress);
+    }
 
-        if (decompress) {
-#ifdef ZLIB
-            destStr = mzUtils::decompressString(destStr);
-#endif
-        }
+    vector<float> decodeBase64(const char* src,
+                               size_t len,
+                               int float_size,
+                               bool neworkorder,
+                               bool decompress)
+    {
+        vector<float> decodedArray;
+        size_t byteCount = decodedSize(src, len);
+        if (byteCount == 0 || float_size <= 0)
+            return decodedArray;
 
 #if (LITTLE_ENDIAN == 1)
          cerr << "INFO: little endian… inverted network order.";
          neworkorder=!neworkorder;
 #endif
 
-        int size = 1 + (destStr.size() - 4) / float_size;
+        // plain single precision data is decoded straight into the array
+        if (float_size == 4 && !neworkorder && !decompress) {
+            decodedArray.resize((byteCount + 3) / 4);
+            decodeBytes(src, len, (char*) decodedArray.data());
+            decodedArray.resize(byteCount / 4);
+            return decodedArray;
+        }
+
+        string destStr(byteCount, '\0');
+        decodeBytes(src, len, &destStr[0]);
+
+        if (decompress) {
+#ifdef ZLIB
+            string inflated;
+            mzUtils::inflateBytes(destStr.data(), destStr.size(), inflated);
+            destStr.swap(inflated);
+#endif
+        }
 
         // we will cast everything as a float may be this is not wise,
         // but have not found a need for double precission yet.
-        vector<float> decodedArray(size);
-        const char* dest = destStr.c_str();
-
-        if ( float_size == 8 ) {
-            if ( neworkorder == false ) {
-                for (int i=0; i<size; i++)
-                    decodedArray[i] = (float) ((double*) dest)[i];
-            } else {
-                uint64_t *u = (uint64_t *) dest;
-                double data=0;
-                for (int i=0; i<size; i++) {
-                    uint64_t t = swapbytes64(u[i]);
-                    memcpy(&data,&t,8);
-                    decodedArray[i] = (float) data;
+        size_t size = destStr.size() / float_size;
+        decodedArray.resize(size);
+        char* dest = &destStr[0];
+
+        if (float_size == 8) {
+            if (neworkorder) {
+                for (size_t i = 0; i < size; i++) {
+                    uint64_t t;
+                    memcpy(&t, dest + i * 8, 8);
+                    t = swapbytes64(t);
+                    memcpy(dest + i * 8, &t, 8);
                 }
             }
-        } else if (float_size == 4 ) {
-            if ( neworkorder == false) {
-                for (int i=0; i<size; i++) decodedArray[i] = ((float*)dest)[i];
-            } else {
-                uint32_t *u = (uint32_t *) dest;
-                float data=0;
-                for (int i=0; i<size; i++) {
-                    uint32_t t = swapbytes(u[i]);
-                    memcpy(&data,&t,4);
-                    decodedArray[i] = data;
+            for (size_t i = 0; i < size; i++) {
+                double data = 0;
+                memcpy(&data, dest + i * 8, 8);
+                decodedArray[i] = (float) data;
+            }
+        } else if (float_size == 4) {
+            if (neworkorder) {
+                for (size_t i = 0; i < size; i++) {
+                    uint32_t t;
+                    memcpy(&t, dest + i * 4, 4);
+                    t = swapbytes(t);
+                    memcpy(dest + i * 4, &t, 4);
                 }
             }
+            memcpy(decodedArray.data(), dest, size * 4);
         }
 
         return decodedArray;
@@ -53,6 +53,44 @@ namespace base64 {
                                bool neworkorder,
                                bool decompress);
 
+    /**
+     * @brief Decode a base64 encoded binary data buffer, without copying it
+     * into a string first.
+     * @details The data is decoded using SIMD instructions where the
+     * processor supports them, and, if it is neither compressed nor in
+     * network order, decoded directly into the returned array.
+     * @param src Pointer to the base64 encoded data.
+     * @param len Length of the base64 encoded data.
+     * @param float_size Value denoting precision of floating point data.
+     * @param neworkorder Boolean indication network order.
+     * @param decompress Whether the data needs to be decompressed after
+     * decoding step.
+     * @return A vector of floating point values extracted from undecoded binary
+     * data.
+     */
+    vector<float> decodeBase64(const char* src,
+                               size_t len,
+                               int float_size,
+                               bool neworkorder,
+                               bool decompress);
+
+    /**
+     * @brief Number of bytes that a base64-encoded buffer decodes to.
+     * @param data A raw base64-encoded buffer.
+     * @param len Length of the buffer containing base64 data.
+     */
+    size_t decodedSize(const char* data, const size_t len);
+
+    /**
+     * @brief Decode a base64-encoded buffer into a preallocated buffer.
+     * @param data A raw base64-encoded buffer.
+     * @param len Length of the buffer containing base64 data.
+     * @param dest Destination buffer, which must be able to hold at least
+     * `decodedSize(data, len)` bytes.
+     * @return Number of bytes written.
+     */
+    size_t decodeBytes(const char* data, const size_t len, char* dest);
+
     /**
      * @brief Decode a plain base64-encoded string.
      * @param data A raw base64-encoded buffer.
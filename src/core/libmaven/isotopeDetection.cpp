@@ -7,6 +7,7 @@
 #include "masscutofftype.h"
 #include "mavenparameters.h"
 #include "mzSample.h"
+#include "mzUtils.h"
 #include "Peak.h"
 #include "peakFiltering.h"
 #include "PeakGroup.h"
@@ -65,121 +66,199 @@ void IsotopeDetection::pullIsotopes(PeakGroup* parentgroup)
 
 map<string, PeakGroup> IsotopeDetection::getIsotopes(PeakGroup* parentgroup, vector<Isotope> masslist)
 {
+    unsigned int sampleCount = _mavenParameters->samples.size();
+    unsigned int isotopeCount = masslist.size();
+    unsigned int pairCount = sampleCount * isotopeCount;
+
+    //check every isotope in every sample independently; samples × isotopes
+    //are spread over all threads
+    vector<float> isotopeRts(pairCount, 0.0f);
+#pragma omp parallel for schedule(dynamic)
+    for (unsigned int n = 0; n < pairCount; n++) {
+        mzSample* sample = _mavenParameters->samples[n / isotopeCount];
+        isotopeRts[n] = findIsotopeRt(parentgroup, sample, masslist[n % isotopeCount]);
+    }
+
+    //pull the EICs of all remaining isotopes of a sample together
+    vector<vector<Peak>> nearestPeaks(sampleCount);
+    vector<vector<char>> found(sampleCount);
+#pragma omp parallel for schedule(dynamic)
+    for (unsigned int s = 0; s < sampleCount; s++) {
+        vector<float> rts(isotopeRts.begin() + s * isotopeCount,
+                          isotopeRts.begin() + (s + 1) * isotopeCount);
+        findNearestIsotopePeaks(parentgroup,
+                                _mavenParameters->samples[s],
+                                masslist,
+                                rts,
+                                nearestPeaks[s],
+                                found[s]);
+    }
+
     //iterate over samples to find properties for parent's isotopes.
     map<string, PeakGroup> isotopes;
 
-    for (unsigned int s = 0; s < _mavenParameters->samples.size(); s++) {
-        mzSample* sample = _mavenParameters->samples[s];
-        for (unsigned int k = 0; k < masslist.size(); k++) {
-            //			if (stopped())
-            //				break; TODO: stop
+    for (unsigned int s = 0; s < sampleCount; s++) {
+        for (unsigned int k = 0; k < isotopeCount; k++) {
+            if (!found[s][k])
+                continue;
+
             Isotope& x = masslist[k];
             string isotopeName = x.name;
             double isotopeMass = x.mass;
             double expectedAbundance = x.abundance;
 
-            float mzmin = isotopeMass -_mavenParameters->compoundMassCutoffWindow->massCutoffValue(isotopeMass);
-            float mzmax = isotopeMass +_mavenParameters->compoundMassCutoffWindow->massCutoffValue(isotopeMass);
+            if (isotopes.count(isotopeName) == 0) { //label the peak of isotope
+                float mzmin = isotopeMass -_mavenParameters->compoundMassCutoffWindow->massCutoffValue(isotopeMass);
+                float mzmax = isotopeMass +_mavenParameters->compoundMassCutoffWindow->massCutoffValue(isotopeMass);
+
+                PeakGroup g;
+                g.meanMz = isotopeMass; //This get's updated in groupStatistics function
+                g.expectedMz = isotopeMass;
+                g.tagString = isotopeName;
+                g.expectedAbundance = expectedAbundance;
+                g.isotopeC13count = x.C13;
+                g.setSelectedSamples(parentgroup->samples);
+
+                // create a slice for this group; RT will be updated later
+                mzSlice childSlice(mzmin,
+                                   mzmax,
+                                   0.0f,
+                                   numeric_limits<float>::max());
+                g.setSlice(childSlice);
+                isotopes[isotopeName] = g;
+            }
+            isotopes[isotopeName].addPeak(nearestPeaks[s][k]); //add nearestPeak to isotope peak list
+        }
+    }
+    return isotopes;
+}
+
+float IsotopeDetection::findIsotopeRt(PeakGroup* parentgroup,
+                                      mzSample* sample,
+                                      Isotope& x)
+{
+    double isotopeMass = x.mass;
 
-            float rt = parentgroup->medianRt();
-            float rtmin = parentgroup->minRt;
-            float rtmax = parentgroup->maxRt;
+    float mzmin = isotopeMass -_mavenParameters->compoundMassCutoffWindow->massCutoffValue(isotopeMass);
+    float mzmax = isotopeMass +_mavenParameters->compoundMassCutoffWindow->massCutoffValue(isotopeMass);
 
-            Peak* parentPeak = parentgroup->getPeak(sample);
-            if (parentPeak) {
-                rt = parentPeak->rt;
-                rtmin = parentPeak->rtmin;
-                rtmax = parentPeak->rtmax;
-            }
+    Peak* parentPeak = parentgroup->getPeak(sample);
+    if (parentPeak == NULL)
+        return 0.0f;
 
-            float isotopePeakIntensity = 0;
-            float parentPeakIntensity = 0;
+    float parentPeakIntensity = parentPeak->peakIntensity;
+    Scan* scan = parentPeak->getScan();
+    std::pair<float, float> isotope = getIntensity(scan, mzmin, mzmax);
+    float isotopePeakIntensity = isotope.first;
+    float rt = isotope.second;
 
-            if (parentPeak) {
-                parentPeakIntensity = parentPeak->peakIntensity;
-                Scan* scan = parentPeak->getScan();
-                std::pair<float, float> isotope = getIntensity(scan, mzmin, mzmax);
-                isotopePeakIntensity = isotope.first;
-                rt = isotope.second;
-            }
+    if (isotopePeakIntensity == 0 || rt == 0)
+        return 0.0f;
 
-            if (isotopePeakIntensity == 0 || rt == 0) continue;
+    if (filterIsotope(x, isotopePeakIntensity, parentPeakIntensity, sample, parentgroup))
+        return 0.0f;
 
-            if (filterIsotope(x, isotopePeakIntensity, parentPeakIntensity, sample, parentgroup))
-                continue;
+    return rt;
+}
+
+void IsotopeDetection::findNearestIsotopePeaks(PeakGroup* parentgroup,
+                                               mzSample* sample,
+                                               vector<Isotope>& masslist,
+                                               const vector<float>& isotopeRts,
+                                               vector<Peak>& nearestPeaks,
+                                               vector<char>& found)
+{
+    nearestPeaks.assign(masslist.size(), Peak());
+    found.assign(masslist.size(), false);
+
+    Peak* parentPeak = parentgroup->getPeak(sample);
+    if (parentPeak == NULL)
+        return;
 
-            vector<Peak> allPeaks;
+    // find nearest peak as long as it is within RT window
+    float maxRtDiff=_mavenParameters->maxIsotopeScanDiff * _mavenParameters->avgScanTime;
+    //why are we even doing this calculation, why not have the parameter be in units of RT?
+
+    //EICs are only extracted around the isotope's apex, leaving room for a
+    //whole peak (as wide as the parent) plus smoothing on either side
+    int smoothingWindow = max(_mavenParameters->eic_smoothingWindow,
+                              _mavenParameters->baseline_smoothingWindow);
+    float margin = (parentPeak->rtmax - parentPeak->rtmin)
+                   + smoothingWindow * _mavenParameters->avgScanTime;
+
+    vector<mzSlice*> slices;
+    vector<unsigned int> sliceIsotopes;
+    for (unsigned int k = 0; k < masslist.size(); k++) {
+        float rt = isotopeRts[k];
+        if (rt == 0)
+            continue;
+
+        double isotopeMass = masslist[k].mass;
+        float mzmin = isotopeMass -_mavenParameters->compoundMassCutoffWindow->massCutoffValue(isotopeMass);
+        float mzmax = isotopeMass +_mavenParameters->compoundMassCutoffWindow->massCutoffValue(isotopeMass);
+        slices.push_back(new mzSlice(mzmin,
+                                     mzmax,
+                                     rt - maxRtDiff - margin,
+                                     rt + maxRtDiff + margin));
+        sliceIsotopes.push_back(k);
+    }
+    if (slices.empty())
+        return;
 
-            EIC * eic = sample->getEIC(mzmin, mzmax, sample->minRt,sample->maxRt, 1, _mavenParameters->eicType,
+    //all isotopologues of the parent are extracted in a single scan sweep
+    //TODO: decide how isotope children should even work in MS mode
+    vector<EIC*> eics = sample->getEICs(slices,
+                                        1,
+                                        _mavenParameters->eicType,
                                         _mavenParameters->filterline);
-            //actually last parameter should probably be deepest MS level?
-            //TODO: decide how isotope children should even work in MS mode
-
-            // smooth fond eic TODO: null check for found
-            eic->setSmootherType(
-                    (EIC::SmootherType)
-                    _mavenParameters->eic_smoothingAlgorithm);
-            eic->setBaselineSmoothingWindow(_mavenParameters->baseline_smoothingWindow);
-            eic->setBaselineDropTopX(_mavenParameters->baseline_dropTopX);
-            eic->setFilterSignalBaselineDiff(_mavenParameters->isotopicMinSignalBaselineDifference);
-            eic->getPeakPositions(_mavenParameters->eic_smoothingWindow);
-            //TODO: this needs be optimized to not bother finding peaks outside of
-            //maxIsotopeScanDiff window
-            allPeaks = eic->peaks;
-
-            //Set peak quality
-            if (_mavenParameters->clsf->hasModel()) {
-                for(Peak& peak: allPeaks)
-                    peak.quality = _mavenParameters->clsf->scorePeak(peak);
-            }
 
-            //filter isotopic peaks
-            bool isIsotope = true;
-			PeakFiltering peakFiltering(_mavenParameters, isIsotope);
-            peakFiltering.filter(allPeaks);                               
-
-            delete(eic);
-            // find nearest peak as long as it is within RT window
-            float maxRtDiff=_mavenParameters->maxIsotopeScanDiff * _mavenParameters->avgScanTime;
-            //why are we even doing this calculation, why not have the parameter be in units of RT?
-            Peak* nearestPeak = NULL;
-            float d = FLT_MAX;
-            for (unsigned int i = 0; i < allPeaks.size(); i++) {
-                Peak& x = allPeaks[i];
-                float dist = abs(x.rt - rt);
-                if (dist > maxRtDiff)
-                    continue;
-                if (dist < d) {
-                    d = dist;
-                    nearestPeak = &x;
-                }
-            }
+    for (unsigned int i = 0; i < eics.size(); i++) {
+        EIC* eic = eics[i];
+        unsigned int k = sliceIsotopes[i];
+        float rt = isotopeRts[k];
+
+        // smooth fond eic
+        eic->setSmootherType(
+                (EIC::SmootherType)
+                _mavenParameters->eic_smoothingAlgorithm);
+        eic->setBaselineSmoothingWindow(_mavenParameters->baseline_smoothingWindow);
+        eic->setBaselineDropTopX(_mavenParameters->baseline_dropTopX);
+        eic->setFilterSignalBaselineDiff(_mavenParameters->isotopicMinSignalBaselineDifference);
+        eic->getPeakPositions(_mavenParameters->eic_smoothingWindow);
+        vector<Peak> allPeaks = eic->peaks;
+
+        //Set peak quality
+        if (_mavenParameters->clsf->hasModel()) {
+            for(Peak& peak: allPeaks)
+                peak.quality = _mavenParameters->clsf->scorePeak(peak);
+        }
+
+        //filter isotopic peaks
+        bool isIsotope = true;
+        PeakFiltering peakFiltering(_mavenParameters, isIsotope);
+        peakFiltering.filter(allPeaks);
+
+        delete(eic);
 
-            //delete (nearestPeak);
-            if (nearestPeak) { //if nearest peak is present
-                if (isotopes.count(isotopeName) == 0) { //label the peak of isotope
-                    PeakGroup g;
-                    g.meanMz = isotopeMass; //This get's updated in groupStatistics function
-                    g.expectedMz = isotopeMass;
-                    g.tagString = isotopeName;
-                    g.expectedAbundance = expectedAbundance;
-                    g.isotopeC13count = x.C13;
-                    g.setSelectedSamples(parentgroup->samples);
-
-                    // create a slice for this group; RT will be updated later
-                    mzSlice childSlice(mzmin,
-                                       mzmax,
-                                       0.0f,
-                                       numeric_limits<float>::max());
-                    g.setSlice(childSlice);
-                    isotopes[isotopeName] = g;
-                }
-                isotopes[isotopeName].addPeak(*nearestPeak); //add nearestPeak to isotope peak list
+        Peak* nearest = NULL;
+        float d = FLT_MAX;
+        for (unsigned int j = 0; j < allPeaks.size(); j++) {
+            Peak& x = allPeaks[j];
+            float dist = abs(x.rt - rt);
+            if (dist > maxRtDiff)
+                continue;
+            if (dist < d) {
+                d = dist;
+                nearest = &x;
             }
-            vector<Peak>().swap(allPeaks);
+        }
+
+        if (nearest) {
+            nearestPeaks[k] = *nearest;
+            found[k] = true;
         }
     }
-    return isotopes;
+    delete_all(slices);
 }
 
 bool IsotopeDetection::filterIsotope(Isotope x, float isotopePeakIntensity, float parentPeakIntensity, mzSample* sample, PeakGroup* parentGroup)
@@ -260,6 +339,7 @@ std::pair<float, float> IsotopeDetection::getIntensity(Scan* scan, float mzmin,
             s = sample->getScan(index);
         }
 
+        ScanLoader::Pin pin(sample->scanLoader(), s);
         vector<int> matches = s->findMatchingMzs(mzmin, mzmax);
         for (auto pos : matches) {
             if (s->intensity[pos] > highestIntensity) {
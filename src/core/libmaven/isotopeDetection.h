@@ -6,6 +6,7 @@
 class Isotope;
 class MavenParameters;
 class mzSample;
+class Peak;
 class PeakGroup;
 class Scan;
 
@@ -49,6 +50,29 @@ class IsotopeDetection
 	MavenParameters *_mavenParameters;
 	IsotopeDetectionType _isoType;
 
+	/**
+	 * @brief check whether an isotope is observed next to the parent
+	 * group's peak in a sample and passes abundance and correlation checks
+	 * @return float. rt at which the isotope was observed, 0 if it was not
+	 **/
+	float findIsotopeRt(PeakGroup* parentgroup, mzSample* sample, Isotope& x);
+
+	/**
+	 * @brief find the peaks of the isotopes of a sample, closest to the
+	 * parent group's peak in that sample
+	 * @details EICs are pulled in a single sweep over the sample, each one
+	 * restricted to an RT window around the rt at which its isotope was
+	 * observed. Isotopes with an rt of 0 are skipped.
+	 * @param isotopeRts rt, as returned by `findIsotopeRt`, for every isotope
+	 * @param nearestPeaks set to the peak found for every isotope
+	 * @param found set to true for the isotopes for which a peak was found
+	 **/
+	void findNearestIsotopePeaks(PeakGroup* parentgroup,
+								 mzSample* sample,
+								 vector<Isotope>& masslist,
+								 const vector<float>& isotopeRts,
+								 vector<Peak>& nearestPeaks,
+								 vector<char>& found);
 	void addIsotopes(PeakGroup *parentgroup, map<string, PeakGroup> isotopes);
 	void childStatistics(PeakGroup* parentgroup, PeakGroup &child, string isotopeName);
 	bool filterLabel(string isotopeName);
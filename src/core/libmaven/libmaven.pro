@@ -110,7 +110,12 @@ SOURCES = base64.cpp \
           groupFeatures.cpp \
           svmPredictor.cpp \
           zlib.cpp \
-          adductdetection.cpp
+          adductdetection.cpp \
+          samplecache.cpp \
+          scanloader.cpp \
+          sliceindex.cpp \
+          stringpool.cpp \
+          xmlstreamreader.cpp
 
 HEADERS += constants.h \
            base64.h \
@@ -156,4 +161,9 @@ HEADERS += constants.h \
            groupClassifier.h \
            groupFeatures.h \
            svmPredictor.h \
-           adductdetection.h
+           adductdetection.h \
+           samplecache.h \
+           scanloader.h \
+           sliceindex.h \
+           stringpool.h \
+           xmlstreamreader.h
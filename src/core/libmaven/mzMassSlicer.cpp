@@ -14,13 +14,14 @@ using namespace mzUtils;
 MassSlices::MassSlices()
 {
     _maxSlices=INT_MAX;
+    _maxBufferedSlices=10000000;
     _minRt=FLT_MIN; _minMz=FLT_MIN; _minIntensity=FLT_MIN;
     _maxRt=FLT_MAX; _maxMz=FLT_MAX; _maxIntensity=FLT_MAX;
     _minCharge=0; _maxCharge=INT_MAX;
     massCutoff=NULL;
 }
 
-MassSlices::~MassSlices() { delete_all(slices); cache.clear(); }
+MassSlices::~MassSlices() { delete_all(slices); _sliceIndex.clear(); }
 
 void MassSlices::sendSignal(const string& progressText,
                 unsigned int completed_samples,
@@ -38,7 +39,7 @@ void MassSlices::algorithmA() {
     // clear cache
     delete_all(slices);
     slices.clear();
-    cache.clear();
+    _sliceIndex.clear();
     map< string, int> seen;
 
     //#pragma omp parallel for ordered
@@ -67,7 +68,7 @@ void MassSlices::stopSlicing() {
     if (slices.size() > 0) {
         delete_all(slices);
         slices.clear();
-        cache.clear();
+        _sliceIndex.clear();
     }
 }
 
@@ -76,7 +77,7 @@ void MassSlices::algorithmB(MassCutoff* massCutoff, int rtStep )
     // clear all previous data
     delete_all(slices);
     slices.clear();
-    cache.clear();
+    _sliceIndex.clear();
 
     float rtWindow = 2.0f;
     this->massCutoff = massCutoff;
@@ -103,101 +104,200 @@ void MassSlices::algorithmB(MassCutoff* massCutoff, int rtStep )
 
     sendSignal("Status", 0 , 1);
 
-    // #pragma omp parallel for ordered
-    // Looping over every sample
-    for (unsigned int i = 0; i < samples.size(); i++) {
-        if (slices.size() > _maxSlices) break;
+    // lambdas that decide whether a scan or an observation is to be sliced
+    auto useScan = [this](Scan* scan) {
+        if (scan->mslevel != 1)
+            return false;
+
+        // Checking if RT is in the given min to max RT range
+        if (_maxRt && !isBetweenInclusive(scan->rt, _minRt, _maxRt))
+            return false;
+        return true;
+    };
+    auto useObservation = [this](float mz, float intensity) {
+        // Checking if mz, intensity are within specified ranges
+        if (_maxMz && !isBetweenInclusive(mz, _minMz, _maxMz))
+            return false;
+        if (_maxIntensity && !isBetweenInclusive(intensity,
+                                                 _minIntensity,
+                                                 _maxIntensity)) {
+            return false;
+        }
+        return true;
+    };
+
+    // Every observation starts off as a slice of its own. Instead of creating
+    // all of them upfront, the observations are first counted per unit m/z
+    // and then sliced, sorted and reduced one m/z band at a time, such that
+    // no more than `_maxBufferedSlices` raw slices are held at once.
+    vector<size_t> observationsPerMz;
+    size_t totalObservations = 0;
+    unsigned int samplesToSlice = 0;
+    for (; samplesToSlice < samples.size(); samplesToSlice++) {
+        if (totalObservations > _maxSlices) break;
 
         // Check if Peak detection has been cancelled by the user
         if (mavenParameters->stop) {
             stopSlicing();
-            break;
+            return;
         }
 
         // updating progress on samples
         if (mavenParameters->showProgressFlag ) {
             string progressText = "Processing "
-                                  + to_string(i + 1)
+                                  + to_string(samplesToSlice + 1)
                                   + " out of "
                                   + to_string(mavenParameters->samples.size())
                                   + " sample(s)…";
             sendSignal(progressText, currentScans, totalScans);
         }
 
-        // #pragma omp cancel for
-        // for loop for iterating over every scan of a sample
-        for (auto scan : samples[i]->scans) {
-            // Check if Peak detection has been cancelled by the user
-            if (mavenParameters->stop) {
-                stopSlicing();
-                break;
+        for (auto scan : samples[samplesToSlice]->scans) {
+            currentScans++;
+            if (!useScan(scan))
+                continue;
+
+            ScanLoader::Pin pin(samples[samplesToSlice]->scanLoader(), scan);
+            for (unsigned int k = 0; k < scan->nobs(); k++) {
+                float mz = scan->mz[k];
+                if (!useObservation(mz, scan->intensity[k]))
+                    continue;
+
+                size_t bin = mz > 0.0f ? static_cast<size_t>(mz) : 0;
+                if (bin >= observationsPerMz.size())
+                    observationsPerMz.resize(bin + 1, 0);
+                observationsPerMz[bin]++;
+                totalObservations++;
             }
+        }
+    }
 
-            currentScans++;
+    cerr << "Found " << totalObservations << " slices" << endl;
 
-            if (scan->mslevel != 1)
-                continue;
+    // upper m/z bounds of the bands to be sliced
+    vector<size_t> bandLimits;
+    size_t bandSize = 0;
+    for (size_t bin = 0; bin < observationsPerMz.size(); bin++) {
+        if (bandSize > 0 && bandSize + observationsPerMz[bin] > _maxBufferedSlices) {
+            bandLimits.push_back(bin);
+            bandSize = 0;
+        }
+        bandSize += observationsPerMz[bin];
+    }
+    bandLimits.push_back(observationsPerMz.size());
 
-            // Checking if RT is in the given min to max RT range
-            if (_maxRt && !isBetweenInclusive(scan->rt, _minRt, _maxRt))
-                continue;
+    // position of the next unsliced observation, for each scan
+    vector<vector<unsigned int>> cursors(samplesToSlice);
+    for (unsigned int i = 0; i < samplesToSlice; i++)
+        cursors[i].resize(samples[i]->scans.size(), 0);
 
-            float rt = scan->rt;
+    vector<SliceRecord> buffer;
+    for (unsigned int band = 0; band < bandLimits.size(); band++) {
+        if (mavenParameters->stop) {
+            stopSlicing();
+            return;
+        }
 
-            for (unsigned int k = 0; k < scan->nobs(); k++) {
-                float mz = scan->mz[k];
-                float intensity = scan->intensity[k];
+        bool lastBand = (band == bandLimits.size() - 1);
+        float mzLimit = static_cast<float>(bandLimits[band]);
 
-                // Checking if mz, intensity are within specified ranges
-                if (_maxMz && !isBetweenInclusive(mz,
-                                                  _minMz,
-                                                  _maxMz)) {
+        size_t bandStart = buffer.size();
+        for (unsigned int i = 0; i < samplesToSlice; i++) {
+            auto& scans = samples[i]->scans;
+            for (unsigned int j = 0; j < scans.size(); j++) {
+                Scan* scan = scans[j];
+                if (!useScan(scan))
                     continue;
-                }
-                if (_maxIntensity && !isBetweenInclusive(intensity,
-                                                         _minIntensity,
-                                                         _maxIntensity)) {
-                    continue;
-                }
 
-                // create new slice with the given bounds
-                float cutoff = massCutoff->massCutoffValue(mz);
-                mzSlice* s = new mzSlice(mz - cutoff,
-                                         mz + cutoff,
-                                         rt - rtWindow,
-                                         rt + rtWindow);
-                s->ionCount = intensity;
-                s->rt = scan->rt;
-                s->mz = mz;
-                slices.push_back(s);
+                ScanLoader::Pin pin(samples[i]->scanLoader(), scan);
+                float rt = scan->rt;
+                unsigned int k = cursors[i][j];
+                for (; k < scan->nobs(); k++) {
+                    float mz = scan->mz[k];
+                    if (!lastBand && mz >= mzLimit)
+                        break;
+
+                    float intensity = scan->intensity[k];
+                    if (!useObservation(mz, intensity))
+                        continue;
+
+                    // create new slice with the given bounds
+                    float cutoff = massCutoff->massCutoffValue(mz);
+                    SliceRecord record;
+                    record.mzmin = mz - cutoff;
+                    record.mzmax = mz + cutoff;
+                    record.rtmin = rt - rtWindow;
+                    record.rtmax = rt + rtWindow;
+                    record.mz = mz;
+                    record.rt = rt;
+                    record.ionCount = intensity;
+                    buffer.push_back(record);
+                }
+                cursors[i][j] = k;
             }
+        }
 
-            // progress update 
-            if (mavenParameters->showProgressFlag ) {
-                string progressText = "Processing "
-                                      + to_string(i + 1)
-                                      + " out of "
-                                      + to_string(mavenParameters->samples.size())
-                                      + " sample(s)…\n"
-                                      + to_string(slices.size())
-                                      + " slices created";
-                sendSignal(progressText,currentScans,totalScans);
-            }
+        // before reduction sort by mz first then by rt; slices carried over
+        // from the previous band all precede the ones of this band
+        sort(begin(buffer) + bandStart,
+             end(buffer),
+             [](const SliceRecord& slice, const SliceRecord& compSlice) {
+                 if (slice.mz == compSlice.mz) {
+                     return slice.rt < compSlice.rt;
+                 }
+                 return slice.mz < compSlice.mz;
+             });
+
+        // split the buffer wherever a record lies beyond the reach of all
+        // records preceding it, the resulting segments can be reduced
+        // independently of each other
+        vector<size_t> segmentStarts = {0};
+        float reach = buffer.empty() ? 0.0f : buffer.front().mzmax;
+        for (size_t k = 1; k < buffer.size(); k++) {
+            if (reach < buffer[k].mzmin)
+                segmentStarts.push_back(k);
+            reach = max(reach, buffer[k].mzmax);
         }
-    }
+        segmentStarts.push_back(buffer.size());
+
+        // unless all records have been read, the trailing segment may still
+        // grow and is only reduced as far as unread records cannot reach
+        size_t completeSegments = segmentStarts.size() - 1;
+        if (!lastBand)
+            completeSegments--;
+
+        vector<vector<mzSlice*>> reducedSegments(completeSegments);
+#pragma omp parallel for schedule(dynamic)
+        for (size_t k = 0; k < completeSegments; k++) {
+            _reduceSlices(buffer.data() + segmentStarts[k],
+                          buffer.data() + segmentStarts[k + 1],
+                          numeric_limits<float>::max(),
+                          reducedSegments[k]);
+        }
+        for (auto& segment : reducedSegments)
+            slices.insert(slices.end(), segment.begin(), segment.end());
+
+        size_t reduced = segmentStarts[completeSegments];
+        if (!lastBand) {
+            // slices yet to be read all have an m/z of at least `mzLimit`
+            float reachLimit = mzLimit
+                               - 2.0f * massCutoff->massCutoffValue(mzLimit);
+            reduced += _reduceSlices(buffer.data() + reduced,
+                                     buffer.data() + buffer.size(),
+                                     reachLimit,
+                                     slices);
+        }
+        buffer.erase(begin(buffer), begin(buffer) + reduced);
 
-    cerr << "Found " << slices.size() << " slices" << endl;
+        sendSignal("Reducing redundant slices…", band + 1, bandLimits.size());
+    }
+    vector<SliceRecord>().swap(buffer);
+    vector<vector<unsigned int>>().swap(cursors);
 
-    // before reduction sort by mz first then by rt
-    sort(begin(slices),
-         end(slices),
-         [](const mzSlice* slice, const mzSlice* compSlice) {
-             if (slice->mz == compSlice->mz) {
-                 return slice->rt < compSlice->rt;
-             }
-             return slice->mz < compSlice->mz;
-         });
-    _reduceSlices();
+    if (mavenParameters->stop) {
+        stopSlicing();
+        return;
+    }
 
     cerr << "Reduced to " << slices.size() << " slices" << endl;
 
@@ -215,13 +315,21 @@ void MassSlices::algorithmB(MassCutoff* massCutoff, int rtStep )
 void MassSlices::algorithmC(float ppm, float minIntensity, float rtWindow) {
     delete_all(slices);
     slices.clear();
-    cache.clear();
+    _sliceIndex.clear();
+
+    // size index cells close to the largest slice that can be created here
+    float highestMz = 0.0f;
+    for (auto sample : samples)
+        highestMz = max(highestMz, sample->maxMz);
+    _sliceIndex.setCellSize(max(2.0f * highestMz / 1e6f * ppm, 0.001f),
+                            max(4.0f * rtWindow, 0.01f));
 
     for(unsigned int i=0; i < samples.size(); i++) {
         mzSample* s = samples[i];
         for(unsigned int j=0; j < s->scans.size(); j++) {
             Scan* scan = samples[i]->scans[j];
             if (scan->mslevel != 1 ) continue;
+            ScanLoader::Pin pin(s->scanLoader(), scan);
             vector<int> positions = scan->intensityOrderDesc();
             for(unsigned int k=0; k< positions.size() && k<10; k++ ) {
                 int pos = positions[k];
@@ -236,8 +344,7 @@ void MassSlices::algorithmC(float ppm, float minIntensity, float rtWindow) {
                     s->rt=scan->rt;
                     s->mz=mz;
                     slices.push_back(s);
-                    int mzRange = mz*10;
-                    cache.insert( pair<int,mzSlice*>(mzRange, s));
+                    _sliceIndex.insert(s);
                 }
             }
         }
@@ -254,16 +361,17 @@ mzSlice* MassSlices::sliceExists(float mzMinBound,
     float mz = (mzMinBound + mzMaxBound) / 2.0f;
     float rt = (rtMinBound + rtMaxBound) / 2.0f;
 
-    // putting all mz slices stored in cache within a particular range in ppp
-    auto subcache = cache.equal_range(int(mz * 10));
-    auto it = subcache.first;
+    // only slices overlapping with the given bounds can satisfy either of
+    // the conditions below
+    auto candidates = _sliceIndex.query(mzMinBound,
+                                        mzMaxBound,
+                                        rtMinBound,
+                                        rtMaxBound);
 
     float bestDist = FLT_MAX;
     mzSlice* best = nullptr;
 
-    // For loop to iterate till best MZ slice becomes second
-    for (; it != subcache.second; ++it) {
-        mzSlice* slice = (*it).second;
+    for (auto slice : candidates) {
         float sliceMzMin = slice->mzmin;
         float sliceMzMax = slice->mzmax;
         float sliceRtMin = slice->rtmin;
@@ -294,87 +402,156 @@ mzSlice* MassSlices::sliceExists(float mzMinBound,
     return best;
 }
 
-void MassSlices::_reduceSlices()
+size_t MassSlices::_reduceSlices(SliceRecord* recordsBegin,
+                                 SliceRecord* recordsEnd,
+                                 float reachLimit,
+                                 vector<mzSlice*>& reduced)
 {
-    for (auto first = begin(slices); first != end(slices); ++first) {
-        if (mavenParameters->stop) {
-            stopSlicing();
+    auto first = recordsBegin;
+    for (; first != recordsEnd; ++first) {
+        if (mavenParameters->stop)
+            break;
+
+        auto& firstSlice = *first;
+        if (firstSlice.mzmax >= reachLimit)
             break;
-        }
 
-        auto firstSlice = *first;
-        if (mzUtils::almostEqual(firstSlice->ionCount, -1.0f))
+        if (mzUtils::almostEqual(firstSlice.ionCount, -1.0f))
             continue;
 
         // we will use this to terminate large shifts in slices, where they
         // might end up losing their original information completely
-        auto originalMax = firstSlice->mzmax;
+        auto originalMax = firstSlice.mzmax;
 
-        for (auto second = next(first); second != end(slices); ++second) {
-            auto secondSlice = *second;
+        for (auto second = next(first); second != recordsEnd; ++second) {
+            auto& secondSlice = *second;
 
             // stop iterating if the rest of the slices are too far
-            if (originalMax < secondSlice->mzmin
-                || firstSlice->mzmax < secondSlice->mzmin)
+            if (originalMax < secondSlice.mzmin
+                || firstSlice.mzmax < secondSlice.mzmin)
                 break;
 
-            if (mzUtils::almostEqual(secondSlice->ionCount, -1.0f))
+            if (mzUtils::almostEqual(secondSlice.ionCount, -1.0f))
                 continue;
 
             // check if center of one of the slices lies in the other
-            if ((firstSlice->mz > secondSlice->mzmin
-                 && firstSlice->mz < secondSlice->mzmax
-                 && firstSlice->rt > secondSlice->rtmin
-                 && firstSlice->rt < secondSlice->rtmax)
+            if ((firstSlice.mz > secondSlice.mzmin
+                 && firstSlice.mz < secondSlice.mzmax
+                 && firstSlice.rt > secondSlice.rtmin
+                 && firstSlice.rt < secondSlice.rtmax)
                 ||
-                (secondSlice->mz > firstSlice->mzmin
-                 && secondSlice->mz < firstSlice->mzmax
-                 && secondSlice->rt > firstSlice->rtmin
-                 && secondSlice->rt < firstSlice->rtmax)) {
-                firstSlice->ionCount = std::max(firstSlice->ionCount,
-                                                secondSlice->ionCount);
-                firstSlice->rtmax = std::max(firstSlice->rtmax,
-                                             secondSlice->rtmax);
-                firstSlice->rtmin = std::min(firstSlice->rtmin,
-                                             secondSlice->rtmin);
-                firstSlice->mzmax = std::max(firstSlice->mzmax,
-                                             secondSlice->mzmax);
-                firstSlice->mzmin = std::min(firstSlice->mzmin,
-                                             secondSlice->mzmin);
-
-                firstSlice->mz = (firstSlice->mzmin + firstSlice->mzmax) / 2.0f;
-                firstSlice->rt = (firstSlice->rtmin + firstSlice->rtmax) / 2.0f;
-                float cutoff = massCutoff->massCutoffValue(firstSlice->mz);
+                (secondSlice.mz > firstSlice.mzmin
+                 && secondSlice.mz < firstSlice.mzmax
+                 && secondSlice.rt > firstSlice.rtmin
+                 && secondSlice.rt < firstSlice.rtmax)) {
+                firstSlice.ionCount = std::max(firstSlice.ionCount,
+                                               secondSlice.ionCount);
+                firstSlice.rtmax = std::max(firstSlice.rtmax,
+                                            secondSlice.rtmax);
+                firstSlice.rtmin = std::min(firstSlice.rtmin,
+                                            secondSlice.rtmin);
+                firstSlice.mzmax = std::max(firstSlice.mzmax,
+                                            secondSlice.mzmax);
+                firstSlice.mzmin = std::min(firstSlice.mzmin,
+                                            secondSlice.mzmin);
+
+                firstSlice.mz = (firstSlice.mzmin + firstSlice.mzmax) / 2.0f;
+                firstSlice.rt = (firstSlice.rtmin + firstSlice.rtmax) / 2.0f;
+                float cutoff = massCutoff->massCutoffValue(firstSlice.mz);
 
                 // make sure that mz window does not get out of control
-                if (firstSlice->mzmin < firstSlice->mz - cutoff)
-                    firstSlice->mzmin =  firstSlice->mz - cutoff;
-                if (firstSlice->mzmax > firstSlice->mz + cutoff)
-                    firstSlice->mzmax =  firstSlice->mz + cutoff;
+                if (firstSlice.mzmin < firstSlice.mz - cutoff)
+                    firstSlice.mzmin =  firstSlice.mz - cutoff;
+                if (firstSlice.mzmax > firstSlice.mz + cutoff)
+                    firstSlice.mzmax =  firstSlice.mz + cutoff;
 
                 // recalculate center mz in case bounds changed
-                firstSlice->mz = (firstSlice->mzmin + firstSlice->mzmax) / 2.0f;
+                firstSlice.mz = (firstSlice.mzmin + firstSlice.mzmax) / 2.0f;
 
                 // flag this slice as already merged, and ignore henceforth
-                secondSlice->ionCount = -1.0f;
+                secondSlice.ionCount = -1.0f;
             }
         }
-        sendSignal("Reducing redundant slices…",
-                   first - begin(slices),
-                   slices.size());
-    }
 
-    // remove merged slices
-    slices.erase(remove_if(slices.begin(),
-                           slices.end(),
-                           [](mzSlice* slice) {
-                               return (slice->ionCount == -1.0f);
-                           }),
-                 slices.end());
+        // a slice will not be modified once it has been compared with all
+        // its successors, so it can be materialized right away
+        mzSlice* slice = new mzSlice(firstSlice.mzmin,
+                                     firstSlice.mzmax,
+                                     firstSlice.rtmin,
+                                     firstSlice.rtmax);
+        slice->mz = firstSlice.mz;
+        slice->rt = firstSlice.rt;
+        slice->ionCount = firstSlice.ionCount;
+        reduced.push_back(slice);
+    }
+    return first - recordsBegin;
 }
 
 void MassSlices::_mergeSlices(const MassCutoff* massCutoff,
                               const float rtTolerance)
+{
+    if (slices.empty())
+        return;
+
+    // slices are only ever compared with neighbours that are close enough in
+    // m/z, and merged slices never grow beyond the bounds of the slices they
+    // were made of; the sorted slices can therefore be split wherever the
+    // bounds on either side are too far apart for any comparison to succeed
+    vector<float> lowestMzmin(slices.size());
+    lowestMzmin.back() = slices.back()->mzmin;
+    for (size_t i = slices.size() - 1; i > 0; --i)
+        lowestMzmin[i - 1] = min(lowestMzmin[i], slices[i - 1]->mzmin);
+
+    vector<vector<mzSlice*>> partitions(1);
+    float highestMzmax = 0.0f;
+    for (size_t i = 0; i < slices.size(); ++i) {
+        if (i > 0) {
+            float mzCenter = (highestMzmax + lowestMzmin[i]) / 2.0f;
+            float massTolerance = 10.0f * massCutoff->massCutoffValue(mzCenter);
+
+            // leave a margin for rounding errors in the comparison
+            if (lowestMzmin[i] - highestMzmax > 2.2f * massTolerance)
+                partitions.push_back({});
+        }
+        highestMzmax = max(highestMzmax, slices[i]->mzmax);
+        partitions.back().push_back(slices[i]);
+    }
+
+    size_t totalSlices = slices.size();
+    size_t processedSlices = 0;
+#pragma omp parallel for schedule(dynamic)
+    for (size_t i = 0; i < partitions.size(); ++i) {
+        if (mavenParameters->stop)
+            continue;
+
+        size_t partitionSize = partitions[i].size();
+        _mergeNeighbouringSlices(partitions[i],
+                                 massCutoff,
+                                 rtTolerance,
+                                 i == 0);
+
+#pragma omp atomic
+        processedSlices += partitionSize;
+
+        if (omp_get_thread_num() == 0) {
+            sendSignal("Merging adjacent slices…",
+                       processedSlices,
+                       totalSlices);
+        }
+    }
+
+    slices.clear();
+    for (auto& partition : partitions)
+        slices.insert(slices.end(), partition.begin(), partition.end());
+
+    if (mavenParameters->stop)
+        stopSlicing();
+}
+
+void MassSlices::_mergeNeighbouringSlices(vector<mzSlice*>& slices,
+                                          const MassCutoff* massCutoff,
+                                          const float rtTolerance,
+                                          const bool isLeading)
 {
     // lambda to help expand a given slice by merging a vector of slices into it
     auto expandSlice = [&](mzSlice* mergeInto, vector<mzSlice*> slices) {
@@ -403,24 +580,20 @@ void MassSlices::_mergeSlices(const MassCutoff* massCutoff,
         mergeInto->mz = (mergeInto->mzmin + mergeInto->mzmax) / 2.0f;
     };
 
-    for(auto it = begin(slices); it != end(slices); ++it) {
-        if (mavenParameters->stop) {
-            stopSlicing();
-            break;
-        }
+    // the backward search has never considered the very first slice, which
+    // is kept as is so that the results do not depend on partitioning
+    size_t lowestBehind = isLeading ? 1 : 0;
 
-        sendSignal("Merging adjacent slices…",
-                   it - begin(slices),
-                   slices.size());
+    for (size_t i = 0; i < slices.size(); ++i) {
+        if (mavenParameters->stop)
+            break;
 
-        auto slice = *it;
+        auto slice = slices[i];
         vector<mzSlice*> slicesToMerge;
 
         // search ahead
-        for (auto ahead = next(it);
-             ahead != end(slices) && it != end(slices);
-             ++ahead) {
-            auto comparisonSlice = *ahead;
+        for (size_t ahead = i + 1; ahead < slices.size(); ++ahead) {
+            auto comparisonSlice = slices[ahead];
             auto comparison = _compareSlices(samples,
                                              slice,
                                              comparisonSlice,
@@ -435,10 +608,8 @@ void MassSlices::_mergeSlices(const MassCutoff* massCutoff,
         }
 
         // search behind
-        for (auto behind = prev(it);
-             behind != begin(slices) && it != begin(slices);
-             --behind) {
-            auto comparisonSlice = *behind;
+        for (size_t behind = i; behind > lowestBehind;) {
+            auto comparisonSlice = slices[--behind];
             auto comparison = _compareSlices(samples,
                                              slice,
                                              comparisonSlice,
@@ -463,9 +634,7 @@ void MassSlices::_mergeSlices(const MassCutoff* massCutoff,
                          slices.end());
             delete merged;
         }
-        it = find_if(begin(slices),
-                     end(slices),
-                     [&](mzSlice* s) { return s == slice; });
+        i = find(begin(slices), end(slices), slice) - begin(slices);
     }
 }
 
@@ -596,12 +765,12 @@ pair<bool, bool> MassSlices::_compareSlices(vector<mzSample*>& samples,
 void MassSlices::adjustSlices()
 {
     size_t progressCount = 0;
-    for (auto slice : slices) {
-        if (mavenParameters->stop) {
-            stopSlicing();
-            break;
-        }
+#pragma omp parallel for schedule(dynamic)
+    for (size_t i = 0; i < slices.size(); ++i) {
+        if (mavenParameters->stop)
+            continue;
 
+        auto slice = slices[i];
         auto eics = PeakDetector::pullEICs(slice,
                                            mavenParameters->samples,
                                            mavenParameters);
@@ -624,7 +793,13 @@ void MassSlices::adjustSlices()
 
         delete_all(eics);
 
+#pragma omp atomic
         ++progressCount;
-        sendSignal("Adjusting slices…", progressCount, slices.size());
+
+        if (omp_get_thread_num() == 0)
+            sendSignal("Adjusting slices…", progressCount, slices.size());
     }
+
+    if (mavenParameters->stop)
+        stopSlicing();
 }
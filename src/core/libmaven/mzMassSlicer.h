@@ -7,6 +7,7 @@
 #include <boost/bind.hpp>
 
 #include "standardincludes.h"
+#include "sliceindex.h"
 
 class MassCutoff;
 class mzSample;
@@ -33,10 +34,10 @@ class MassSlices {
         vector<mzSlice*> slices;
 
         /**
-         * @brief This function finds the `mzSlice`, present in cache, whose area
+         * @brief This function finds the `mzSlice`, present in the slice index, whose area
          * overlaps with the given area (in mz-rt space) and either of the
          * centers of these areas is contained in the other.
-         * @details This function will pick a slice from cache if either of the
+         * @details This function will pick a slice from the index if either of the
          * following conditions are satisfied:
          *  1. If the center of an existing slice is contained within the given
          *     area.
@@ -94,6 +95,15 @@ class MassSlices {
          */
         void setMaxSlices( int x) { _maxSlices=x; }
 
+        /**
+         * @brief Set the maximum number of raw slices that `algorithmB` keeps
+         * in memory at any time.
+         * @details Observations are sliced one m/z band at a time. The bands
+         * are chosen such that each contains at most this many observations
+         * (unless a single unit of m/z holds more).
+         */
+        void setMaxBufferedSlices(size_t x) { _maxBufferedSlices = x; }
+
         /**
          * [setSamples ]
          * @method setSamples
@@ -115,6 +125,7 @@ class MassSlices {
 
     private:
         unsigned int _maxSlices;
+        size_t _maxBufferedSlices;
         float _minRt;
         float _maxRt;
         float _minMz;
@@ -126,7 +137,7 @@ class MassSlices {
         MassCutoff *massCutoff;
 
         vector<mzSample*> samples;
-        multimap<int,mzSlice*>cache;
+        SliceIndex _sliceIndex;
         MavenParameters* mavenParameters;
 
         /**
@@ -138,7 +149,9 @@ class MassSlices {
          * slices (positive and negative look-ahead) are checked until the
          * second value returned from a comparison call is found to be `false`,
          * signalling that further neighbours are not qualified for merging, by
-         * definition.
+         * definition. The slices are split into partitions that are too far
+         * apart in m/z to be merged with each other, and these partitions are
+         * processed in parallel.
          * @param massCutoff A `MassCutoff` object that decides the maximum
          * width of a slice in the m/z domain. Any merged slice that expands to
          * a size more than what this cutoff dictates, will be resized around
@@ -151,6 +164,24 @@ class MassSlices {
         void _mergeSlices(const MassCutoff* massCutoff,
                           const float rtTolerance);
 
+        /**
+         * @brief Merge related slices within a partition of the sorted
+         * slices, as described for `_mergeSlices`.
+         * @details Partitions are chosen such that slices of different
+         * partitions are too far apart in m/z to be merged, which allows them
+         * to be merged concurrently.
+         * @param slices The partition of slices to be merged. Slices merged
+         * into others are removed from this vector and freed.
+         * @param massCutoff Maximum width of a slice in the m/z domain.
+         * @param rtTolerance Maximum rt distance between the highest
+         * intensities of two slices that are to be merged.
+         * @param isLeading Whether this is the first of the partitions.
+         */
+        void _mergeNeighbouringSlices(vector<mzSlice*>& slices,
+                                      const MassCutoff* massCutoff,
+                                      const float rtTolerance,
+                                      const bool isLeading);
+
         /**
          * @brief A function that takes in a vector of `mzSample` objects, and
          * two pointers to the mzSlices that need to be compared.
@@ -178,9 +209,40 @@ class MassSlices {
                                         const float rtTolerance);
 
         /**
-         * @brief This method will reduce the internal slice vector by merging
+         * @brief Compact, plain representation of a slice that is used
+         * while raw observations are being sliced and reduced.
+         */
+        struct SliceRecord {
+            float mzmin;
+            float mzmax;
+            float rtmin;
+            float rtmax;
+            float mz;
+            float rt;
+            float ionCount;
+        };
+
+        /**
+         * @brief This method will reduce the given slice records by merging
          * and resizing them if they share a signifant region of interest.
+         * @details The records must be sorted by m/z and then by rt. Records
+         * are only ever merged into records preceding them, therefore each
+         * reduced slice is appended to `reduced` as soon as it has been
+         * compared with the records following it.
+         * @param recordsBegin Pointer to the first of the records.
+         * @param recordsEnd Pointer past the last of the records.
+         * @param reachLimit Reduction stops at the first record whose upper
+         * m/z bound is not below this limit, such that records that may still
+         * be merged with records not yet read are left untouched.
+         * @param reduced Vector to which reduced slices are appended. Records
+         * that have been merged into others are flagged with an ion count of
+         * -1 and skipped.
+         * @return The number of leading records that have been consumed and
+         * can be discarded.
          */
-        void _reduceSlices();
+        size_t _reduceSlices(SliceRecord* recordsBegin,
+                             SliceRecord* recordsEnd,
+                             float reachLimit,
+                             vector<mzSlice*>& reduced);
 };
 #endif
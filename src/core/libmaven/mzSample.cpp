@@ -10,21 +10,32 @@
 #include "Matrix.h"
 #include "EIC.h"
 #include "Scan.h"
+#include "samplecache.h"
+#include "xmlstreamreader.h"
+
+#include <omp.h>
 
 #include <MavenException.h>
 
 // global options
-int mzSample::filter_minIntensity = -1;
-bool mzSample::filter_centroidScans = false;
-int mzSample::filter_intensityQuantile = 0;
-int mzSample::filter_polarity = 0;
-int mzSample::filter_mslevel = 0;
+atomic<int> mzSample::filter_minIntensity(-1);
+atomic<bool> mzSample::filter_centroidScans(false);
+atomic<int> mzSample::filter_intensityQuantile(0);
+atomic<int> mzSample::filter_polarity(0);
+atomic<int> mzSample::filter_mslevel(0);
+atomic<bool> mzSample::use_sampleCache(false);
+atomic<bool> mzSample::lazy_loading(false);
+atomic<int> mzSample::lazy_scanCacheSize(256);
+atomic<bool> mzSample::compact_scans(false);
+atomic<int> mzSample::compact_scanCacheSize(32);
 
 mzSample::mzSample() : _setName(""), injectionOrder(0)
 {
     _id = -1;
     _numMS1Scans = 0;
     _numMS2Scans = 0;
+    _scanLoader = nullptr;
+    _precursorIndexScans = 0;
     maxMz = maxRt = 0;
     minMz = minRt = 0;
     isBlank = false;
@@ -45,10 +56,12 @@ mzSample::mzSample() : _setName(""), injectionOrder(0)
     // list.
     color[0] = color[1] = color[2] = 0;
     color[3] = 1.0;
+    captureScanFilters();
 }
 
 mzSample::~mzSample()
 {
+    delete _scanLoader;
     for (unsigned int i = 0; i < scans.size(); i++)
         if (scans[i] != NULL)
             delete (scans[i]);
@@ -60,33 +73,53 @@ void mzSample::addScan(Scan* s)
     if (!s)
         return;
 
+    if (prepareScan(s))
+        appendScan(s);
+}
+
+void mzSample::captureScanFilters()
+{
+    _scanFilters.minIntensity = mzSample::filter_minIntensity;
+    _scanFilters.centroidScans = mzSample::filter_centroidScans;
+    _scanFilters.intensityQuantile = mzSample::filter_intensityQuantile;
+    _scanFilters.mslevel = mzSample::filter_mslevel;
+    _scanFilters.polarity = mzSample::filter_polarity;
+}
+
+bool mzSample::prepareScan(Scan* s)
+{
     // skip scans that do not match mslevel
-    if (mzSample::filter_mslevel and s->mslevel != mzSample::filter_mslevel)
-        return;
+    if (_scanFilters.mslevel and s->mslevel != _scanFilters.mslevel)
+        return false;
     // skip scans that do not match polarity
-    if (mzSample::filter_polarity
-        and s->getPolarity() != mzSample::filter_polarity)
-        return;
+    if (_scanFilters.polarity
+        and s->getPolarity() != _scanFilters.polarity)
+        return false;
 
     // unsigned int sizeBefore = s->intensity.size();
-    if (mzSample::filter_centroidScans == true) {
+    if (_scanFilters.centroidScans == true) {
         s->simpleCentroid();
     }
 
     // unsigned int sizeAfter1 = s->intensity.size();
 
-    if (mzSample::filter_intensityQuantile > 0) {
-        s->quantileFilter(mzSample::filter_intensityQuantile);
+    if (_scanFilters.intensityQuantile > 0) {
+        s->quantileFilter(_scanFilters.intensityQuantile);
     }
     // unsigned int sizeAfter2 = s->intensity.size();
 
-    if (mzSample::filter_minIntensity > 0) {
-        s->intensityFilter(mzSample::filter_minIntensity);
+    if (_scanFilters.minIntensity > 0) {
+        s->intensityFilter(_scanFilters.minIntensity);
     }
     // unsigned int sizeAfter3 = s->intensity.size();
     // cerr << "addScan " << sizeBefore <<  " " << sizeAfter1 << " " <<
     // sizeAfter2 << " " << sizeAfter3 << endl;
 
+    return true;
+}
+
+void mzSample::appendScan(Scan* s)
+{
     if (s->mslevel == 1)
         ++_numMS1Scans;
     if (s->mslevel == 2)
@@ -94,6 +127,7 @@ void mzSample::addScan(Scan* s)
 
     scans.push_back(s);
     s->scannum = scans.size() - 1;
+    s->summarizePeaks();
 
     //recalculate precursorMz of MS2 scans
     if (s->mslevel == 2 && _numMS1Scans > 0) {
@@ -157,14 +191,37 @@ void mzSample::checkSampleBlank(const char* filename)
 
 void mzSample::loadSample(const char* filename)
 {
-    // Loading and Decoding the file
-    // catch any error while parsing
-    try {
-        loadAnySample(filename);
-    }
+    captureScanFilters();
+
+    // Reuse the scans decoded on an earlier load, if the raw file and the
+    // scan filters have not changed since
+    // if the sample is loaded lazily, its scans never hold all their data
+    bool useSampleCache = mzSample::use_sampleCache && !mzSample::lazy_loading;
+    bool loadedFromCache = useSampleCache && SampleCache::read(this, filename);
+
+    if (!loadedFromCache) {
+        // Loading and Decoding the file
+        // catch any error while parsing
+        bool parsed = true;
+        try {
+            loadAnySample(filename);
+        }
+
+        catch (MavenException& excp) {
+            cerr << endl << "Error: " << excp.what() << endl;
+            parsed = false;
+        }
+
+        if (useSampleCache && parsed && !scans.empty()
+            && !SampleCache::write(this, filename)) {
+            cerr << "Unable to write sample cache for " << filename << endl;
+        }
 
-    catch (MavenException& excp) {
-        cerr << endl << "Error: " << excp.what() << endl;
+        // formats and files without spectra are always loaded in full
+        if (_scanLoader != nullptr && _scanLoader->scanCount() == 0) {
+            delete _scanLoader;
+            _scanLoader = nullptr;
+        }
     }
 
     // getting the SRM scan type
@@ -178,77 +235,157 @@ void mzSample::loadSample(const char* filename)
 
     // Checking if a sample is blank or not
     checkSampleBlank(filename);
+
+    // Keeping the peak data compressed in memory, if requested
+    compactScans();
+
+    // Indexing fragmentation events by precursor
+    buildPrecursorIndex();
 }
 
 void mzSample::parseMzCSV(const char* filename)
 {
     // file structure:
     // scannum,rt,mz,intensity,mslevel,precursorMz,polarity,srmid
-    int lineNum = 0;
-
-    ifstream myfile(filename);
+    ifstream myfile(filename, ios::in | ios::binary);
     if (!myfile.is_open())
         throw(MavenException(ErrorMsg::FileNotFound));
 
-    std::stringstream ss;
-    std::string line;
-    std::string polarity;
-
+    int lineNum = 0;
     int lastScanNum = -1;
-    int scannum = 0;
-    float rt = 0;
-    float intensity = 0;
-    float mz = 0;
-    float precursorMz = 0;
-    int mslevel = 0;
-
-    Scan* scan = NULL;
     int newscannum = 0;
+    Scan* scan = NULL;
 
-    while (getline(myfile, line)) {
-        lineNum++;
-        vector<string> fields;
-        mzUtils::split(line, ',', fields);
-        if (fields.size() >= 5 && lineNum > 1) {
-            ss.clear();
-
-            ss << fields[0] << " " << fields[1] << " " << fields[2] << " "
-               << fields[3] << " " << fields[4] << " " << fields[5] << " "
-               << fields[6];
-
-            ss >> scannum >> rt >> mz >> intensity >> mslevel >> precursorMz
-                >> polarity;
-
-            if (scannum != lastScanNum) {
-                newscannum++;
-                if (mslevel <= 0)
-                    mslevel = 1;
-                int scanpolarity = 0;
-                if (polarity.empty() && fields.size() > 7)
-                    polarity = fields[7];
-                if (!polarity.empty() && polarity[0] == '+')
-                    scanpolarity = 1;
-                if (!polarity.empty() && polarity[0] == '-')
-                    scanpolarity = -1;
-                scan = new Scan(this,
-                                newscannum,
-                                mslevel,
-                                rt / 60,
-                                precursorMz,
-                                scanpolarity);
-                if (mslevel > 1)
-                    scan->productMz = mz;
-
-                addScan(scan);
-                if (fields.size() > 7)
-                    scan->filterLine = fields[7];  // last field is srmId
+    // Lines are parsed in place, field by field, from blocks read off the
+    // file. Only the first eight fields of a line are of interest.
+    const int maxFields = 8;
+    const char* fieldBegin[maxFields];
+    const char* fieldEnd[maxFields];
+    int fieldCount = 0;
+    string srmId;
+    // fields are not terminated, numbers are converted from a copy so that
+    // an empty field does not run into the next one
+    char value[64];
+    auto fieldValue = [&](int i) -> const char* {
+        if (i >= fieldCount)
+            return "";
+        size_t length = min(static_cast<size_t>(fieldEnd[i] - fieldBegin[i]),
+                            sizeof(value) - 1);
+        memcpy(value, fieldBegin[i], length);
+        value[length] = '\0';
+        return value;
+    };
+    auto intField = [&](int i) {
+        return static_cast<int>(strtol(fieldValue(i), NULL, 10));
+    };
+    auto floatField = [&](int i) { return strtof(fieldValue(i), NULL); };
+    auto firstChar = [&](int i) {
+        if (i >= fieldCount)
+            return '\0';
+        const char* c = fieldBegin[i];
+        while (c < fieldEnd[i] && isspace(*c))
+            c++;
+        return c < fieldEnd[i] ? *c : '\0';
+    };
+
+    auto parseLine = [&](const char* begin, const char* end) {
+        if (end > begin && *(end - 1) == '\r')
+            end--;
+
+        fieldCount = 0;
+        for (const char* field = begin;; fieldCount++) {
+            auto comma = static_cast<const char*>(
+                memchr(field, ',', end - field));
+            if (fieldCount < maxFields) {
+                fieldBegin[fieldCount] = field;
+                fieldEnd[fieldCount] = comma ? comma : end;
+            }
+            if (!comma)
+                break;
+            field = comma + 1;
+        }
+        fieldCount++;
+        if (fieldCount < 5)
+            return;
+
+        int scannum = intField(0);
+        float mz = floatField(2);
+        float intensity = floatField(3);
+
+        if (scannum != lastScanNum) {
+            // all observations of the previous scan have been read
+            if (scan)
+                scan->summarizePeaks();
+            newscannum++;
+            int mslevel = intField(4);
+            if (mslevel <= 0)
+                mslevel = 1;
+            char polarity = firstChar(6);
+            if (polarity == '\0')
+                polarity = firstChar(7);
+            int scanpolarity = 0;
+            if (polarity == '+')
+                scanpolarity = 1;
+            if (polarity == '-')
+                scanpolarity = -1;
+            scan = new Scan(this,
+                            newscannum,
+                            mslevel,
+                            floatField(1) / 60,
+                            floatField(5),
+                            scanpolarity);
+            if (mslevel > 1)
+                scan->productMz = mz;
+            if (fieldCount > 7) {
+                // last field is srmId
+                srmId.assign(fieldBegin[7], fieldEnd[7]);
+                scan->filterLine = _scanStrings.intern(srmId);
             }
 
+            if (prepareScan(scan)) {
+                appendScan(scan);
+            } else {
+                delete scan;
+                scan = NULL;
+            }
+        }
+
+        if (scan) {
             scan->mz.push_back(mz);
             scan->intensity.push_back(intensity);
-            lastScanNum = scannum;
         }
+        lastScanNum = scannum;
+    };
+
+    const size_t blockSize = 1 << 20;
+    string buffer;
+    size_t lineStart = 0;
+    bool lastLine = false;
+    while (!lastLine) {
+        size_t lineEnd = buffer.find('\n', lineStart);
+        if (lineEnd == string::npos) {
+            // keep the incomplete line and append the next block to it
+            buffer.erase(0, lineStart);
+            lineStart = 0;
+            size_t size = buffer.size();
+            buffer.resize(size + blockSize);
+            myfile.read(&buffer[size], blockSize);
+            buffer.resize(size + myfile.gcount());
+            if (myfile.gcount() > 0)
+                continue;
+            if (buffer.empty())
+                break;
+            lineEnd = buffer.size();
+            lastLine = true;
+        }
+
+        // the first line holds the column names
+        if (++lineNum > 1)
+            parseLine(buffer.data() + lineStart, buffer.data() + lineEnd);
+        lineStart = lineEnd + 1;
     }
+    if (scan)
+        scan->summarizePeaks();
 }
 
 // void mzSample::writeMzCSV(const char* filename) const {
@@ -257,24 +394,49 @@ void mzSample::writeMzCSV(const char* filename)
     // TODO naman unused function
 
     ofstream mzCSV;
-    mzCSV.open(filename);
+    mzCSV.open(filename, ios::out | ios::binary);
     if (!mzCSV.is_open()) {
         cerr << "Unable to write to a file" << filename;
         return;
     }
 
-    mzCSV << "scannum,rt,mz,intensity,mslevel,precursorMz,polarity,srmid"
-          << endl;
+    // lines are formatted into a buffer that is written out in large blocks,
+    // numbers are formatted as with the default precision of a stream; only
+    // m/z and intensity differ between the lines of a scan
+    const size_t blockSize = 1 << 20;
+    string buffer = "scannum,rt,mz,intensity,mslevel,precursorMz,polarity,srmid\n";
+    buffer.reserve(blockSize + 256);
+    char prefix[64];
+    char suffix[64];
+    char values[64];
     for (unsigned int i = 0; i < scans.size(); i++) {
         Scan* scan = scans[i];
+        ScanLoader::Pin pin(_scanLoader, scan);
+        snprintf(prefix, sizeof(prefix), "%d,%g,", scan->scannum + 1, scan->rt * 60);
+        snprintf(suffix,
+                 sizeof(suffix),
+                 ",%d,%g,%c,",
+                 scan->mslevel,
+                 scan->precursorMz,
+                 scan->getPolarity() > 0 ? '+' : '-');
         for (unsigned int j = 0; j < scan->nobs(); j++) {
-            mzCSV << scan->scannum + 1 << "," << scan->rt * 60 << ","
-                  << scan->mz[j] << "," << scan->intensity[j] << ","
-                  << scan->mslevel << "," << scan->precursorMz << ","
-                  << (scan->getPolarity() > 0 ? "+" : "-") << ","
-                  << scan->filterLine << endl;
+            snprintf(values,
+                     sizeof(values),
+                     "%g,%g",
+                     scan->mz[j],
+                     scan->intensity[j]);
+            buffer += prefix;
+            buffer += values;
+            buffer += suffix;
+            buffer += scan->filterLine;
+            buffer += '\n';
+            if (buffer.size() >= blockSize) {
+                mzCSV.write(buffer.data(), buffer.size());
+                buffer.clear();
+            }
         }
     }
+    mzCSV.write(buffer.data(), buffer.size());
 }
 
 int mzSample::getPolarity()
@@ -283,35 +445,137 @@ int mzSample::getPolarity()
         return scans[0]->getPolarity();
     return 0;
 }
-void mzSample::parseMzML(const char* filename)
+/**
+ * Parse a fragment of an XML file, as read by `XmlStreamReader`, into a
+ * document. The fragment is parsed in place and must outlive the document.
+ */
+static bool loadXmlFragment(xml_document& doc, string& fragment)
 {
-    xml_document doc;
+    if (fragment.empty())
+        return false;
+    xml_parse_result parseResult = doc.load_buffer_inplace(
+        &fragment[0], fragment.size(), parse_minimal);
+    return parseResult.status == status_ok && doc.first_child();
+}
 
-    const unsigned int parse_options = parse_minimal;
+/**
+ * Spectrum elements are decoded in batches of at most this many elements
+ * per thread, or this many bytes of raw text in total.
+ */
+static const size_t SCAN_BATCH_SIZE_PER_THREAD = 64;
+static const size_t SCAN_BATCH_BYTES = 64 << 20;
 
-    pugi::xml_parse_result parseResult = doc.load_file(filename, parse_options);
-    if (parseResult.status != pugi::xml_parse_status::status_ok) {
-        throw MavenException(ErrorMsg::ParsemzMl);
+static bool isScanBatchFull(const vector<string>& batch, size_t batchBytes)
+{
+    return batch.size() >= SCAN_BATCH_SIZE_PER_THREAD * omp_get_max_threads()
+           || batchBytes >= SCAN_BATCH_BYTES;
+}
+
+bool mzSample::decodeScans(vector<string>& elements,
+                           vector<ScanLoader::Location>& locations,
+                           Scan* (mzSample::*decode)(const xml_node&, int))
+{
+    int firstScannum = scans.size();
+    vector<Scan*> decodedScans(elements.size(), nullptr);
+    int failures = 0;
+
+#pragma omp parallel for schedule(dynamic) reduction(+:failures)
+    for (int i = 0; i < static_cast<int>(elements.size()); i++) {
+        xml_document doc;
+        if (!loadXmlFragment(doc, elements[i])) {
+            failures++;
+            continue;
+        }
+        Scan* scan = (this->*decode)(doc.first_child(), firstScannum + i);
+        if (scan && !prepareScan(scan)) {
+            delete scan;
+            scan = nullptr;
+        }
+        decodedScans[i] = scan;
+        string().swap(elements[i]);
     }
 
-    // Get injection time stamp
-    xml_node experimentRun =
-        doc.first_child().first_element_by_path("mzML/run");
-    if (!experimentRun.empty()) {
-        parseMzMLInjectionTimeStamp(experimentRun.attribute("startTimeStamp"));
+    // scans are registered in the order in which they appear in the file
+    for (unsigned int i = 0; i < decodedScans.size(); i++) {
+        Scan* scan = decodedScans[i];
+        if (!scan)
+            continue;
+        appendScan(scan);
+        if (_scanLoader != nullptr) {
+            extendMzIntensityRange(scan);
+            _scanLoader->add(scan, locations[i]);
+        }
     }
+    elements.clear();
+    locations.clear();
 
-    // Get a spectrumstore node
-    xml_node chromatogramList =
-        doc.first_child().first_element_by_path("mzML/run/chromatogramList");
-    xml_node spectrumList =
-        doc.first_child().first_element_by_path("mzML/run/spectrumList");
+    return failures == 0;
+}
 
-    if (!spectrumList.empty()) {
-        parseMzMLSpectrumList(spectrumList);
-    } else if (!chromatogramList.empty()) {
-        parseMzMLChromatogramList(chromatogramList);
+void mzSample::parseMzML(const char* filename)
+{
+    XmlStreamReader reader(filename);
+    if (!reader.isOpen()) {
+        throw MavenException(ErrorMsg::ParsemzMl);
     }
+
+    // Spectra are read one element at a time and handed over, in batches,
+    // to be decoded in parallel. Chromatograms are only used if the run has
+    // no spectrum list, which always precedes the chromatogram list.
+    bool hasSpectrumList = false;
+    bool hasChromatograms = false;
+    int scannum = 0;
+    createScanLoader(filename, &mzSample::decodeMzMLSpectrum, "</spectrum>");
+
+    XmlStreamReader::Tag tag;
+    string element;
+    xml_document doc;
+    vector<string> batch;
+    vector<ScanLoader::Location> locations;
+    size_t batchBytes = 0;
+    while (reader.nextTag(tag)) {
+        if (tag.isEnd)
+            continue;
+
+        if (tag.name == "run") {
+            // Get injection time stamp
+            element = reader.text(tag.begin, tag.end);
+            if (!tag.isEmpty)
+                element.insert(element.size() - 1, "/");
+            if (loadXmlFragment(doc, element)) {
+                parseMzMLInjectionTimeStamp(
+                    doc.first_child().attribute("startTimeStamp"));
+            }
+        } else if (tag.name == "spectrumList") {
+            hasSpectrumList = true;
+        } else if (tag.name == "spectrum") {
+            batch.emplace_back();
+            if (!reader.readElement(tag, batch.back()))
+                throw MavenException(ErrorMsg::ParsemzMl);
+            batchBytes += batch.back().size();
+            locations.push_back({tag.begin, batch.back().size(), false});
+            if (isScanBatchFull(batch, batchBytes)) {
+                if (!decodeScans(batch,
+                                 locations,
+                                 &mzSample::decodeMzMLSpectrum))
+                    throw MavenException(ErrorMsg::ParsemzMl);
+                batchBytes = 0;
+            }
+        } else if (tag.name == "chromatogram" && !hasSpectrumList) {
+            if (!reader.readElement(tag, element)
+                || !loadXmlFragment(doc, element)) {
+                throw MavenException(ErrorMsg::ParsemzMl);
+            }
+            parseMzMLChromatogram(doc.first_child(), scannum);
+            hasChromatograms = true;
+        }
+    }
+
+    if (!decodeScans(batch, locations, &mzSample::decodeMzMLSpectrum))
+        throw MavenException(ErrorMsg::ParsemzMl);
+
+    if (hasChromatograms)
+        sortScansByRt();
 }
 
 void mzSample::parseMzMLInjectionTimeStamp(
@@ -334,81 +598,14 @@ void mzSample::parseMzMLChromatogramList(const xml_node& chromatogramList)
     for (xml_node chromatogram = chromatogramList.child("chromatogram");
          chromatogram;
          chromatogram = chromatogram.next_sibling("chromatogram")) {
-        string chromatogramId = chromatogram.attribute("id").value();
-        int sampleNo = getSampleNoChromatogram(chromatogramId);
-
-        cleanFilterLine(chromatogramId);
-
-        vector<float> timeVector;
-        vector<float> intsVector;
-
-        xml_node binaryDataArrayList =
-            chromatogram.child("binaryDataArrayList");
-        string precursorMzStr =
-            chromatogram
-                .first_element_by_path("precursor/isolationWindow/cvParam")
-                .attribute("value")
-                .value();
-        string productMzStr =
-            chromatogram
-                .first_element_by_path("product/isolationWindow/cvParam")
-                .attribute("value")
-                .value();
-        float precursorMz = string2float(precursorMzStr);
-        float productMz = string2float(productMzStr);
-        // int mslevel=2;
-
-        for (xml_node binaryDataArray = binaryDataArrayList.child("binaryDataArray");
-             binaryDataArray;
-             binaryDataArray =
-                 binaryDataArray.next_sibling("binaryDataArray")) {
-
-            map<string, string> attr = mzML_cvParams(binaryDataArray);
-
-            int precision = 64;
-            if (attr.count("32-bit float"))
-                precision = 32;
-
-            bool decompress = false;
-            if(attr.count("zlib compression"))
-                decompress=true;
-
-            string binaryDataStr =
-                binaryDataArray.child("binary").child_value();
-            vector<float> binaryData = base64::decodeBase64(binaryDataStr,
-                                                             precision / 8,
-                                                             false,
-                                                             decompress);
-
-            if (attr.count("time array")) {
-                timeVector = binaryData;
-            }
-            if (attr.count("intensity array")) {
-                intsVector = binaryData;
-            }
-        }
-
-        //	cerr << chromatogramId << endl;
-        //	cerr << timeVector.size() << " ints=" << intsVector.size() <<
-        //endl; 	cerr << "pre: " << precursorMz << " prod=" << productMz << endl;
-
-        // if (precursorMz and precursorMz ) {
-        if (precursorMz) {  // naman Same expression on both sides of '&&'.
-            int mslevel =
-                2;  // naman The scope of the variable 'mslevel' can be reduced.
-            for (unsigned int i = 0; i < timeVector.size(); i++) {
-                Scan* scan = new Scan(
-                    this, scannum++, mslevel, timeVector[i], precursorMz, -1);
-                scan->productMz = productMz;
-                scan->mz.push_back(productMz);
-                scan->filterLine = chromatogramId;
-                sampleNumber = sampleNo;
-                scan->intensity.push_back(intsVector[i]);
-                addScan(scan);
-            }
-        }
+        parseMzMLChromatogram(chromatogram, scannum);
     }
 
+    sortScansByRt();
+}
+
+void mzSample::sortScansByRt()
+{
     // renumber scans based on retention time
     std::sort(scans.begin(), scans.end(), Scan::compRt);
     for (unsigned int i = 0; i < scans.size(); i++) {
@@ -416,6 +613,125 @@ void mzSample::parseMzMLChromatogramList(const xml_node& chromatogramList)
     }
 }
 
+void mzSample::createScanLoader(const char* filename,
+                                Scan* (mzSample::*decode)(const xml_node&,
+                                                          int),
+                                const string& endTag)
+{
+    delete _scanLoader;
+    _scanLoader = nullptr;
+    if (!mzSample::lazy_loading)
+        return;
+
+    size_t capacity = static_cast<size_t>(max(lazy_scanCacheSize.load(), 0))
+                      << 20;
+    _scanLoader = new ScanLoader(this, filename, decode, endTag, capacity);
+
+    // the range is extended as scans are decoded, since their peak data is
+    // not kept around
+    resetMzIntensityRange();
+}
+
+void mzSample::compactScans()
+{
+    if (!mzSample::compact_scans || _scanLoader != nullptr || scans.empty())
+        return;
+
+    size_t capacity =
+        static_cast<size_t>(max(compact_scanCacheSize.load(), 0)) << 20;
+    _scanLoader = new ScanLoader(this, capacity);
+
+#pragma omp parallel for schedule(dynamic)
+    for (int i = 0; i < static_cast<int>(scans.size()); i++)
+        _scanLoader->compress(scans[i]);
+
+    // none of the scans was worth compressing
+    if (_scanLoader->scanCount() == 0) {
+        delete _scanLoader;
+        _scanLoader = nullptr;
+    }
+}
+
+void mzSample::parseMzMLChromatogram(const xml_node& chromatogram,
+                                     int& scannum)
+{
+    string chromatogramId = chromatogram.attribute("id").value();
+    int sampleNo = getSampleNoChromatogram(chromatogramId);
+
+    cleanFilterLine(chromatogramId);
+
+    vector<float> timeVector;
+    vector<float> intsVector;
+
+    xml_node binaryDataArrayList =
+        chromatogram.child("binaryDataArrayList");
+    string precursorMzStr =
+        chromatogram
+            .first_element_by_path("precursor/isolationWindow/cvParam")
+            .attribute("value")
+            .value();
+    string productMzStr =
+        chromatogram
+            .first_element_by_path("product/isolationWindow/cvParam")
+            .attribute("value")
+            .value();
+    float precursorMz = string2float(precursorMzStr);
+    float productMz = string2float(productMzStr);
+    // int mslevel=2;
+
+    for (xml_node binaryDataArray = binaryDataArrayList.child("binaryDataArray");
+         binaryDataArray;
+         binaryDataArray =
+             binaryDataArray.next_sibling("binaryDataArray")) {
+
+        map<string, string> attr = mzML_cvParams(binaryDataArray);
+
+        int precision = 64;
+        if (attr.count("32-bit float"))
+            precision = 32;
+
+        bool decompress = false;
+        if(attr.count("zlib compression"))
+            decompress=true;
+
+        const char* binaryDataStr =
+            binaryDataArray.child("binary").child_value();
+        vector<float> binaryData = base64::decodeBase64(binaryDataStr,
+                                                         strlen(binaryDataStr),
+                                                         precision / 8,
+                                                         false,
+                                                         decompress);
+
+        if (attr.count("time array")) {
+            timeVector = binaryData;
+        }
+        if (attr.count("intensity array")) {
+            intsVector = binaryData;
+        }
+    }
+
+    //	cerr << chromatogramId << endl;
+    //	cerr << timeVector.size() << " ints=" << intsVector.size() <<
+    //endl; 	cerr << "pre: " << precursorMz << " prod=" << productMz << endl;
+
+    // if (precursorMz and precursorMz ) {
+    if (precursorMz) {  // naman Same expression on both sides of '&&'.
+        int mslevel =
+            2;  // naman The scope of the variable 'mslevel' can be reduced.
+        InternedString filterLine = _scanStrings.intern(chromatogramId);
+        for (unsigned int i = 0; i < timeVector.size(); i++) {
+            Scan* scan = new Scan(
+                this, scannum++, mslevel, timeVector[i], precursorMz, -1);
+            scan->productMz = productMz;
+            scan->mz.push_back(productMz);
+            scan->filterLine = filterLine;
+            sampleNumber = sampleNo;
+            scan->intensity.push_back(intsVector[i]);
+            addScan(scan);
+        }
+    }
+}
+
 int mzSample::getSampleNoChromatogram(const string& chromatogramId)
 {
     std::regex rxSampleNumber("sample\ *\=\ *([0-9]+)\ ");
@@ -452,123 +768,134 @@ void mzSample::parseMzMLSpectrumList(const xml_node& spectrumList)
 
     for (xml_node spectrum = spectrumList.child("spectrum"); spectrum;
          spectrum = spectrum.next_sibling("spectrum")) {
-        string spectrumId = spectrum.attribute("id").value();
+        Scan* scan = decodeMzMLSpectrum(spectrum, scannum);
+        if (scan) {
+            scannum++;
+            addScan(scan);
+        }
+    }
+}
 
-        if (spectrum.empty())
-            continue;
-        map<string, string> cvParams = mzML_cvParams(spectrum);
+Scan* mzSample::decodeMzMLSpectrum(const xml_node& spectrum, int scannum)
+{
+    string spectrumId = spectrum.attribute("id").value();
 
-        int mslevel = 1;
-        int scanpolarity = 0;
-        float rt = 0;
-        vector<float> mzVector;
-        vector<float> intsVector;
+    if (spectrum.empty())
+        return nullptr;
+    map<string, string> cvParams = mzML_cvParams(spectrum);
 
-        if (cvParams.count("ms level")) {
-            string msLevelStr = cvParams["ms level"];
-            mslevel = (int)string2float(msLevelStr);
-        }
+    int mslevel = 1;
+    int scanpolarity = 0;
+    float rt = 0;
+    vector<float> mzVector;
+    vector<float> intsVector;
 
-        if (cvParams.count("positive scan"))
-            scanpolarity = 1;
-        else if (cvParams.count("negative scan"))
-            scanpolarity = -1;
-        else
-            scanpolarity = 0;
-
-        xml_node scanNode = spectrum.first_element_by_path("scanList/scan");
-        map<string, string> scanAttr = mzML_cvParams(scanNode);
-        if (scanAttr.count("scan start time minute")) {
-            string rtStr = scanAttr["scan start time minute"];
-            rt = string2float(rtStr);
-        } else if (scanAttr.count("scan start time second")) {
-            string rtStr = scanAttr["scan start time second"];
-            rt = string2float(rtStr) / 60.0f;
-        }
+    if (cvParams.count("ms level")) {
+        string msLevelStr = cvParams["ms level"];
+        mslevel = (int)string2float(msLevelStr);
+    }
 
-        if (scanAttr.count("filter string")) {
-            spectrumId = scanAttr["filter string"];
-        }
-        cleanFilterLine(spectrumId);
+    if (cvParams.count("positive scan"))
+        scanpolarity = 1;
+    else if (cvParams.count("negative scan"))
+        scanpolarity = -1;
+    else
+        scanpolarity = 0;
 
-        map<string, string> isolationWindow =
-            mzML_cvParams(spectrum.first_element_by_path(
-                "precursorList/precursor/isolationWindow"));
-        string precursorMzStr = isolationWindow["isolation window target m/z"];
-        float precursorMz = 0;
-        if (string2float(precursorMzStr) > 0)
-            precursorMz = string2float(precursorMzStr);
-
-        string precursorIsolationStrLower =
-            isolationWindow["isolation window lower offset"];
-        string precursorIsolationStrUpper =
-            isolationWindow["isolation window upper offset"];
-
-        float precursorIsolationWindow = 0.0f;
-        if (string2float(precursorIsolationStrLower) > 0.0f)
-            precursorIsolationWindow +=
-                string2float(precursorIsolationStrLower);
-        if (string2float(precursorIsolationStrUpper) > 0.0f)
-            precursorIsolationWindow +=
-                string2float(precursorIsolationStrUpper);
-        if (precursorIsolationWindow <= 0.0f)
-            precursorIsolationWindow = 1.0f;
-
-        string productMzStr =
-            spectrum.first_element_by_path("product/isolationWindow/cvParam")
-                .attribute("value")
-                .value();
-        float productMz = 0;
-        if (string2float(productMzStr) > 0)
-            productMz = string2float(productMzStr);
-
-        xml_node binaryDataArrayList = spectrum.child("binaryDataArrayList");
-        if (!binaryDataArrayList or binaryDataArrayList.empty())
+    xml_node scanNode = spectrum.first_element_by_path("scanList/scan");
+    map<string, string> scanAttr = mzML_cvParams(scanNode);
+    if (scanAttr.count("scan start time minute")) {
+        string rtStr = scanAttr["scan start time minute"];
+        rt = string2float(rtStr);
+    } else if (scanAttr.count("scan start time second")) {
+        string rtStr = scanAttr["scan start time second"];
+        rt = string2float(rtStr) / 60.0f;
+    }
+
+    if (scanAttr.count("filter string")) {
+        spectrumId = scanAttr["filter string"];
+    }
+    cleanFilterLine(spectrumId);
+
+    map<string, string> isolationWindow =
+        mzML_cvParams(spectrum.first_element_by_path(
+            "precursorList/precursor/isolationWindow"));
+    string precursorMzStr = isolationWindow["isolation window target m/z"];
+    float precursorMz = 0;
+    if (string2float(precursorMzStr) > 0)
+        precursorMz = string2float(precursorMzStr);
+
+    string precursorIsolationStrLower =
+        isolationWindow["isolation window lower offset"];
+    string precursorIsolationStrUpper =
+        isolationWindow["isolation window upper offset"];
+
+    float precursorIsolationWindow = 0.0f;
+    if (string2float(precursorIsolationStrLower) > 0.0f)
+        precursorIsolationWindow +=
+            string2float(precursorIsolationStrLower);
+    if (string2float(precursorIsolationStrUpper) > 0.0f)
+        precursorIsolationWindow +=
+            string2float(precursorIsolationStrUpper);
+    if (precursorIsolationWindow <= 0.0f)
+        precursorIsolationWindow = 1.0f;
+
+    string productMzStr =
+        spectrum.first_element_by_path("product/isolationWindow/cvParam")
+            .attribute("value")
+            .value();
+    float productMz = 0;
+    if (string2float(productMzStr) > 0)
+        productMz = string2float(productMzStr);
+
+    xml_node binaryDataArrayList = spectrum.child("binaryDataArrayList");
+    if (!binaryDataArrayList or binaryDataArrayList.empty())
+        return nullptr;
+
+    for (xml_node binaryDataArray =
+             binaryDataArrayList.child("binaryDataArray");
+         binaryDataArray;
+         binaryDataArray =
+             binaryDataArray.next_sibling("binaryDataArray")) {
+        if (!binaryDataArray or binaryDataArray.empty())
             continue;
 
-        for (xml_node binaryDataArray =
-                 binaryDataArrayList.child("binaryDataArray");
-             binaryDataArray;
-             binaryDataArray =
-                 binaryDataArray.next_sibling("binaryDataArray")) {
-            if (!binaryDataArray or binaryDataArray.empty())
-                continue;
+        map<string, string> attr = mzML_cvParams(binaryDataArray);
 
-            map<string, string> attr = mzML_cvParams(binaryDataArray);
-
-            int precision = 64;
-            if (attr.count("32-bit float"))
-                precision = 32;
-
-            bool decompress = false;
-            if(attr.count("zlib compression"))
-                decompress=true;
-
-            string binaryDataStr =
-                binaryDataArray.child("binary").child_value();
-            if (!binaryDataStr.empty()) {
-                vector<float> binaryData = base64::decodeBase64(binaryDataStr,
-                                                                 precision / 8,
-                                                                 false,
-                                                                 decompress);
-                if (attr.count("m/z array")) {
-                    mzVector = binaryData;
-                }
-                if (attr.count("intensity array")) {
-                    intsVector = binaryData;
-                }
+        int precision = 64;
+        if (attr.count("32-bit float"))
+            precision = 32;
+
+        bool decompress = false;
+        if(attr.count("zlib compression"))
+            decompress=true;
+
+        const char* binaryDataStr =
+            binaryDataArray.child("binary").child_value();
+        size_t binaryDataLength = strlen(binaryDataStr);
+        if (binaryDataLength > 0) {
+            vector<float> binaryData = base64::decodeBase64(binaryDataStr,
+                                                             binaryDataLength,
+                                                             precision / 8,
+                                                             false,
+                                                             decompress);
+            if (attr.count("m/z array")) {
+                mzVector = binaryData;
+            }
+            if (attr.count("intensity array")) {
+                intsVector = binaryData;
             }
         }
-
-        Scan* scan =
-            new Scan(this, scannum++, mslevel, rt, precursorMz, scanpolarity);
-        scan->isolationWindow = precursorIsolationWindow;
-        scan->productMz = productMz;
-        scan->filterLine = spectrumId;
-        scan->intensity = intsVector;
-        scan->mz = mzVector;
-        addScan(scan);
     }
+
+    Scan* scan =
+        new Scan(this, scannum, mslevel, rt, precursorMz, scanpolarity);
+    scan->isolationWindow = precursorIsolationWindow;
+    scan->productMz = productMz;
+    scan->filterLine = _scanStrings.intern(spectrumId);
+    scan->intensity = intsVector;
+    scan->mz = mzVector;
+    return scan;
 }
 
 map<string, string> mzSample::mzML_cvParams(xml_node node)
@@ -656,7 +983,6 @@ void mzSample::parseMzData(const char* filename)
             mslevel = 1;
         Scan* scan =
             new Scan(this, scannum, mslevel, rt, precursorMz, scanpolarity);
-        addScan(scan);
 
         int precision1 = spectrum.child("intenArrayBinary")
                              .child("data")
@@ -677,48 +1003,10 @@ void mzSample::parseMzData(const char* filename)
         scan->mz = base64::decodeBase64(b64mz, precision2 / 8, false, false);
 
         // cout << "spectrum " << spectrum.attribute("title").value() << endl;
+        addScan(scan);
     }
 }
 
-xml_node mzSample::getmzXMLSpectrumData(xml_document& doc, const char* filename)
-{
-    // parse_minimal has all options turned off. This option mask means
-    // that pugixml does not add declaration nodes, document type declaration
-    // nodes, PI nodes, CDATA sections and comments to the resulting tree and
-    // does not perform any conversion for input data, so theoretically it is
-    // the fastest mode
-    bool loadok = doc.load_file(filename, pugi::parse_minimal);
-
-    // Checking if the file can be loaded if it can be loaded
-    if (!loadok) {
-        cerr << "Failed to load " << filename << endl;
-        // returning an empty node
-        return xml_node();
-    }
-
-    //"msRun" is the first child of the parent child "mzXML"
-    xml_node spectrumstore = doc.first_child().child("msRun");
-
-    // Checking if the node is empty which means that msRun is not there
-    // but then it might have scan which contain the data
-    if (spectrumstore.empty()) {
-        // Getting the first child named "scan"
-        xml_node scan = doc.first_child().child("scan");
-        // If scan is not present then there is no data
-        // which means that there is no information in the
-        // mzXML file
-        if (!scan.empty()) {
-            spectrumstore = doc.first_child();
-        } else {
-            // if the above condition is not satisfied return a empty
-            // spectrumstore
-            cerr << "parseMzXML: can't find <msRun> or <scan> section" << endl;
-            return xml_node();
-        }
-    }
-    return spectrumstore;
-}
-
 void mzSample::setInstrumentSettigs(xml_document& doc, xml_node spectrumstore)
 {
     // Getting the instrument related information
@@ -740,41 +1028,95 @@ void mzSample::setInstrumentSettigs(xml_document& doc, xml_node spectrumstore)
     }
 }
 
-void mzSample::parseMzXMLData(const xml_node& spectrumstore)
+void mzSample::parseMzXML(const char* filename)
 {
-    // Iterate through spectrums
-    int scannum = 0;
+    XmlStreamReader reader(filename);
+    if (!reader.isOpen()) {
+        cerr << "Failed to load " << filename << endl;
+        throw MavenException(ErrorMsg::ParsemzXml);
+    }
 
-    for (xml_node scan = spectrumstore.child("scan"); scan;
-         scan = scan.next_sibling("scan")) {
-        scannum++;
-        if (strncasecmp(scan.name(), "scan", 4) == 0) {
-            parseMzXMLScan(scan, scannum);
+    // Scans are read one at a time and handed over, in batches, to be
+    // decoded in parallel. Only scans at the top level of the run and their
+    // immediate children are parsed. The data of a scan precedes any scans
+    // nested within it, so a scan is complete either at its end tag or at
+    // the start tag of its first child scan.
+    int scanDepth = 0;
+    bool foundScans = false;
+    bool pendingTag = false;
+    createScanLoader(filename, &mzSample::decodeMzXMLScan, "</scan>");
+
+    XmlStreamReader::Tag tag;
+    string element;
+    xml_document doc;
+    vector<string> batch;
+    vector<ScanLoader::Location> locations;
+    size_t batchBytes = 0;
+    while (pendingTag || reader.nextTag(tag)) {
+        pendingTag = false;
+
+        if (tag.name == "msInstrument" && !tag.isEnd && !foundScans) {
+            // Setting the instrument related information
+            if (reader.readElement(tag, element)
+                && loadXmlFragment(doc, element)) {
+                setInstrumentSettigs(doc, doc);
+            }
+            continue;
         }
 
-        for (xml_node child = scan.first_child(); child;
-             child = child.next_sibling()) {
-            scannum++;
-            if (strncasecmp(child.name(), "scan", 4) == 0) {
-                parseMzXMLScan(child, scannum);
+        if (tag.name != "scan")
+            continue;
+        if (tag.isEnd) {
+            scanDepth--;
+            continue;
+        }
+        foundScans = true;
+
+        XmlStreamReader::Tag scanTag = tag;
+        size_t scanEnd = scanTag.end;
+        bool hasChildScans = false;
+        if (!scanTag.isEmpty) {
+            reader.retain(scanTag.begin);
+            bool found = false;
+            while ((found = reader.nextTag(tag)) && tag.name != "scan")
+                ;
+            if (!found)
+                throw MavenException(ErrorMsg::ParsemzXml);
+            hasChildScans = !tag.isEnd;
+            scanEnd = hasChildScans ? tag.begin : tag.end;
+        }
+        element = reader.text(scanTag.begin, scanEnd);
+        reader.release();
+        if (hasChildScans)
+            element += "</scan>";
+
+        if (scanDepth < 2) {
+            batchBytes += element.size();
+            batch.push_back(std::move(element));
+            locations.push_back(
+                {scanTag.begin, scanEnd - scanTag.begin, hasChildScans});
+            if (isScanBatchFull(batch, batchBytes)) {
+                if (!decodeScans(batch,
+                                 locations,
+                                 &mzSample::decodeMzXMLScan))
+                    throw MavenException(ErrorMsg::ParsemzXml);
+                batchBytes = 0;
             }
         }
-    }
-}
 
-void mzSample::parseMzXML(const char* filename)
-{
-    xml_document doc;
+        if (hasChildScans) {
+            scanDepth++;
+            pendingTag = true;
+        }
+    }
 
-    xml_node spectrumstore = getmzXMLSpectrumData(doc, filename);
+    if (!decodeScans(batch, locations, &mzSample::decodeMzXMLScan))
+        throw MavenException(ErrorMsg::ParsemzXml);
 
-    if (!spectrumstore.empty()) {
-        // Setting the instrument related information
-        setInstrumentSettigs(doc, spectrumstore);
-        // parse mzXML information from the scan
-        parseMzXMLData(spectrumstore);
-    } else
+    if (!foundScans) {
+        cerr << "parseMzXML: can't find <msRun> or <scan> section" << endl;
         throw MavenException(ErrorMsg::ParsemzXml);
+    }
 }
 
 /**
@@ -836,10 +1178,11 @@ vector<float> mzSample::parsePeaksFromMzXML(const xml_node& scan)
     vector<float> mzint;
 
     if (!peaks.empty()) {
-        string b64String(peaks.child_value());
+        const char* b64String = peaks.child_value();
+        size_t b64Length = strlen(b64String);
 
         // no m/z intensity values
-        if (b64String.empty())
+        if (b64Length == 0)
             return mzint;
 
         // if the data is been compressed in zlib format this part will
@@ -870,7 +1213,7 @@ vector<float> mzSample::parsePeaksFromMzXML(const xml_node& scan)
         //    << " prec=" << precision << endl;
 
         mzint = base64::decodeBase64(
-            b64String, precision / 8, networkorder, decompress);
+            b64String, b64Length, precision / 8, networkorder, decompress);
 
         return mzint;
     }
@@ -904,17 +1247,22 @@ void mzSample::populateMzAndIntensity(const vector<float>& mzint, Scan* _scan)
 void mzSample::populateFilterline(const string& filterLine, Scan* _scan)
 {
     if (!filterLine.empty())
-        _scan->filterLine = filterLine;
+        _scan->filterLine = _scanStrings.intern(filterLine);
 
     // TODO: why is this logic like this is
     if (filterLine.empty() && _scan->precursorMz > 0) {
-        _scan->filterLine = _scan->scanType + ":"
-                            + float2string(_scan->precursorMz, 4) + " ["
-                            + float2string(_scan->productMz, 4) + "]";
+        _scan->filterLine = _scanStrings.intern(
+            _scan->scanType.str() + ":" + float2string(_scan->precursorMz, 4)
+            + " [" + float2string(_scan->productMz, 4) + "]");
     }
 }
 
 void mzSample::parseMzXMLScan(const xml_node& scan, const int& scannum)
+{
+    addScan(decodeMzXMLScan(scan, scannum));
+}
+
+Scan* mzSample::decodeMzXMLScan(const xml_node& scan, int scannum)
 {
     float rt = 0.0, precursorMz = 0.0f, productMz = 0, collisionEnergy = 0;
     int scanpolarity = 0, msLevel = 1;
@@ -964,7 +1312,7 @@ void mzSample::parseMzXMLScan(const xml_node& scan, const int& scannum)
     // no m/z intensity values
     mzint = parsePeaksFromMzXML(scan);
     if (mzint.empty()) {
-        return;
+        return nullptr;
     }
 
     Scan* _scan =
@@ -989,7 +1337,7 @@ void mzSample::parseMzXMLScan(const xml_node& scan, const int& scannum)
     }
 
     if (!scanType.empty())
-        _scan->scanType = scanType;
+        _scan->scanType = _scanStrings.intern(scanType);
 
     _scan->productMz = productMz;
 
@@ -999,7 +1347,7 @@ void mzSample::parseMzXMLScan(const xml_node& scan, const int& scannum)
 
     populateFilterline(filterLine, _scan);
 
-    addScan(_scan);
+    return _scan;
 }
 
 void mzSample::summary()
@@ -1019,32 +1367,14 @@ void mzSample::calculateMzRtRange()
 
     minRt = scans[0]->rt;
     maxRt = scans[scans.size() - 1]->rt;
-    minMz = FLT_MAX;
-    maxMz = 0;
-    minIntensity = FLT_MAX;
-    maxIntensity = 0;
-    totalIntensity = 0;
-    int nobs = 0;
-
-    unsigned int numOfScans = scans.size();
-    for (unsigned int j = 0; j < numOfScans; j++) {
-        Scan* currentScan = scans[j];
-        unsigned int mzSize = currentScan->mz.size();
-        for (unsigned int i = 0; i < mzSize; i++) {
-            float intensity = currentScan->intensity[i];
-            float mz = currentScan->mz[i];
-            totalIntensity += intensity;
-            if (mz < minMz && mz > 0)
-                minMz = mz; //sanity check must be greater > 0
-            if (mz > maxMz && mz < 1e9)
-                maxMz = mz; //sanity check m/z over a billion
-            if (intensity < minIntensity)
-                minIntensity = intensity;
-            if (intensity > maxIntensity)
-                maxIntensity = intensity;
-            nobs++;
-        }
+
+    // lazily loaded samples have had their range extended while parsing
+    if (_scanLoader == nullptr) {
+        resetMzIntensityRange();
+        for (auto scan : scans)
+            extendMzIntensityRange(scan);
     }
+
     //sanity check
     if (minRt <= 0)
         minRt = 0;
@@ -1052,6 +1382,33 @@ void mzSample::calculateMzRtRange()
         maxRt = 1e4;
 }
 
+void mzSample::resetMzIntensityRange()
+{
+    minMz = FLT_MAX;
+    maxMz = 0;
+    minIntensity = FLT_MAX;
+    maxIntensity = 0;
+    totalIntensity = 0;
+}
+
+void mzSample::extendMzIntensityRange(const Scan* scan)
+{
+    unsigned int mzSize = scan->mz.size();
+    for (unsigned int i = 0; i < mzSize; i++) {
+        float intensity = scan->intensity[i];
+        float mz = scan->mz[i];
+        totalIntensity += intensity;
+        if (mz < minMz && mz > 0)
+            minMz = mz; //sanity check must be greater > 0
+        if (mz > maxMz && mz < 1e9)
+            maxMz = mz; //sanity check m/z over a billion
+        if (intensity < minIntensity)
+            minIntensity = intensity;
+        if (intensity > maxIntensity)
+            maxIntensity = intensity;
+    }
+}
+
 float mzSample::getMaxRt(const vector<mzSample*>& samples)
 {
     // TODO naman unused function
@@ -1139,6 +1496,8 @@ EIC* mzSample::getEIC(float precursorMz,
         // if (collisionEnergy && abs(scan->collisionEnergy-collisionEnergy) >
         // 0.5) continue;
 
+        ScanLoader::Pin pin(_scanLoader, scan);
+
         float eicMz = 0;
         float eicIntensity = 0;
 
@@ -1255,6 +1614,7 @@ EIC* mzSample::getEIC(string srm, int eicType)
         vector<int> srmscans = srmScans[srm];
         for (unsigned int i = 0; i < srmscans.size(); i++) {
             Scan* scan = scans[srmscans[i]];
+            ScanLoader::Pin pin(_scanLoader, scan);
             float eicMz = 0;
             float eicIntensity = 0;
 
@@ -1391,6 +1751,168 @@ EIC* mzSample::getEIC(float mzmin,
     return (e);
 }
 
+vector<EIC*> mzSample::getEICs(const vector<mzSlice*>& slices,
+                               int mslevel,
+                               int eicType,
+                               string filterline)
+{
+    vector<EIC*> eics;
+    vector<pair<float, float>> rtRanges;
+    eics.reserve(slices.size());
+    rtRanges.reserve(slices.size());
+    for (auto slice : slices) {
+        // same range adjustments as for a single EIC
+        float rtmin = slice->rtmin;
+        float rtmax = slice->rtmax;
+        float mzmin = slice->mzmin;
+        float mzmax = slice->mzmax;
+        if (rtmin < this->minRt)
+            rtmin = this->minRt;
+        if (rtmax > this->maxRt && this->maxRt > rtmin)
+            rtmax = this->maxRt;
+        if (mzmin < this->minMz)
+            mzmin = this->minMz;
+        if (mzmax > this->maxMz && this->maxMz > mzmin)
+            mzmax = this->maxMz;
+
+        EIC* e = new EIC();
+        e->sampleName = sampleName;
+        e->sample = this;
+        e->mzmin = mzmin;
+        e->mzmax = mzmax;
+        e->totalIntensity = 0;
+        e->maxIntensity = 0;
+        eics.push_back(e);
+        rtRanges.push_back(make_pair(rtmin, rtmax));
+
+        if (this->maxRt - this->minRt > 0 && rtmax > rtmin) {
+            float rtFraction = (rtmax - rtmin) / (this->maxRt - this->minRt);
+            int estimatedScans = min(1.0f, rtFraction) * scans.size() + 10;
+            e->scannum.reserve(estimatedScans);
+            e->rt.reserve(estimatedScans);
+            e->intensity.reserve(estimatedScans);
+            e->mz.reserve(estimatedScans);
+        }
+    }
+
+    if (eics.empty() || scans.empty())
+        return eics;
+
+    // slices become active in the order of their lower RT bounds
+    vector<unsigned int> byRt(eics.size());
+    for (unsigned int i = 0; i < byRt.size(); i++)
+        byRt[i] = i;
+    stable_sort(byRt.begin(),
+                byRt.end(),
+                [&rtRanges](unsigned int a, unsigned int b) {
+                    return rtRanges[a].first < rtRanges[b].first;
+                });
+
+    // active slices are kept sorted by their lower m/z bound so that each
+    // slice can start its search where the previous one left off
+    struct ActiveSlice {
+        float mzmin;
+        float mzmax;
+        float rtmax;
+        EIC* eic;
+    };
+    auto compMzmin = [](const ActiveSlice& a, const ActiveSlice& b) {
+        return a.mzmin < b.mzmin;
+    };
+    vector<ActiveSlice> active;
+    float nextExpiry = numeric_limits<float>::max();
+    unsigned int nextSlice = 0;
+
+    auto compRt = [](const Scan* scan, float rt) { return scan->rt < rt; };
+
+    for (unsigned int i = 0; i < scans.size(); i++) {
+        if (active.empty()) {
+            if (nextSlice == byRt.size())
+                break;
+
+            // skip over scans that precede the next slice
+            float rt = rtRanges[byRt[nextSlice]].first;
+            i = lower_bound(scans.begin() + i, scans.end(), rt, compRt)
+                - scans.begin();
+            if (i == scans.size())
+                break;
+        }
+
+        Scan* scan = scans[i];
+        if (scan->mslevel != mslevel)
+            continue;
+        if (!(filterline.empty() || scan->filterLine == filterline))
+            continue;
+
+        float scanRt = scan->rt;
+        while (nextSlice < byRt.size()
+               && rtRanges[byRt[nextSlice]].first <= scanRt) {
+            unsigned int index = byRt[nextSlice++];
+            EIC* e = eics[index];
+            ActiveSlice entry = {e->mzmin, e->mzmax, rtRanges[index].second, e};
+            active.insert(upper_bound(active.begin(),
+                                      active.end(),
+                                      entry,
+                                      compMzmin),
+                          entry);
+            nextExpiry = min(nextExpiry, entry.rtmax);
+        }
+
+        // slices stop at the first matching scan beyond their RT window
+        if (scanRt > nextExpiry) {
+            active.erase(remove_if(active.begin(),
+                                   active.end(),
+                                   [scanRt](const ActiveSlice& entry) {
+                                       return scanRt > entry.rtmax;
+                                   }),
+                         active.end());
+            nextExpiry = numeric_limits<float>::max();
+            for (const auto& entry : active)
+                nextExpiry = min(nextExpiry, entry.rtmax);
+        }
+        if (active.empty())
+            continue;
+
+        ScanLoader::Pin pin(_scanLoader, scan);
+        const float* mzs = scan->mz.data();
+        const float* intensities = scan->intensity.data();
+        unsigned int nobs = scan->nobs();
+
+        unsigned int start = 0;
+        for (const auto& entry : active) {
+            // gallop forward from the previous slice's position, since
+            // neighbouring slices usually start close to each other
+            unsigned int step = 1;
+            unsigned int end = start;
+            while (end < nobs && mzs[end] < entry.mzmin) {
+                start = end + 1;
+                end += step;
+                step *= 2;
+            }
+            start = lower_bound(mzs + start, mzs + min(end, nobs), entry.mzmin)
+                    - mzs;
+
+            float eicMz = 0, eicIntensity = 0;
+            EIC::reduceMzRange(mzs + start,
+                               intensities + start,
+                               nobs - start,
+                               entry.mzmin,
+                               entry.mzmax,
+                               eicType,
+                               eicMz,
+                               eicIntensity);
+            entry.eic->addScanObservation(i, scanRt, eicMz, eicIntensity);
+        }
+    }
+
+    float scale = getNormalizationConstant();
+    for (auto e : eics) {
+        e->getRTMinMaxPerScan();
+        e->normalizeIntensityPerScan(scale);
+    }
+    return eics;
+}
+
 EIC* mzSample::getTIC(float rtmin, float rtmax, int mslevel)
 {
     // TODO naman unused function
@@ -1419,6 +1941,9 @@ EIC* mzSample::getTIC(float rtmin, float rtmax, int mslevel)
     for (int i = 0; i < scanCount; i++) {
         if (scans[i]->mslevel == mslevel) {
             Scan* scan = scans[i];
+            // the summary of a scan makes loading its peak data unnecessary
+            ScanLoader::Pin pin(scan->hasPeakSummary() ? nullptr : _scanLoader,
+                                scan);
             float y = scan->totalIntensity();
             e->mz.push_back(0);
             e->scannum.push_back(i);
@@ -1466,14 +1991,10 @@ EIC* mzSample::getBIC(float rtmin, float rtmax, int mslevel)
     for (int i = 0; i < scanCount; i++) {
         if (scans[i]->mslevel == mslevel) {
             Scan* scan = scans[i];
-            float maxMz = 0;
-            float maxIntensity = 0;
-            for (unsigned int i = 0; i < scan->intensity.size(); i++) {
-                if (scan->intensity[i] > maxIntensity) {
-                    maxIntensity = scan->intensity[i];
-                    maxMz = scan->mz[i];
-                }
-            }
+            ScanLoader::Pin pin(scan->hasPeakSummary() ? nullptr : _scanLoader,
+                                scan);
+            float maxMz = scan->basePeakMz();
+            float maxIntensity = scan->maxIntensity();
             e->mz.push_back(maxMz);
             e->scannum.push_back(i);
             e->rt.push_back(scan->rt);
@@ -1758,6 +2279,7 @@ Scan* mzSample::getAverageScan(float rtmin,
             continue;
 
         Scan* scan = scans[s];
+        ScanLoader::Pin pin(_scanLoader, scan);
         scanCount++;
         for (unsigned int i = 0; i < scan->mz.size(); i++) {
             float bin = FLOATROUND(scan->mz[i], sd);
@@ -1806,21 +2328,61 @@ void mzSample::restorePreviousRetentionTimes()
     }
 }
 
+void mzSample::buildPrecursorIndex()
+{
+    lock_guard<mutex> lock(_precursorIndexMutex);
+    indexPrecursors();
+}
+
+void mzSample::indexPrecursors()
+{
+    _precursorIndex.clear();
+    for (auto scan : scans) {
+        if (scan->mslevel == 2)  // ms2 + scans only
+            _precursorIndex.push_back({scan->precursorMz, scan});
+    }
+    sort(_precursorIndex.begin(),
+         _precursorIndex.end(),
+         [](const PrecursorEntry& a, const PrecursorEntry& b) {
+             if (a.precursorMz != b.precursorMz)
+                 return a.precursorMz < b.precursorMz;
+             if (a.scan->rt != b.scan->rt)
+                 return a.scan->rt < b.scan->rt;
+             return a.scan->scannum < b.scan->scannum;
+         });
+    _precursorIndex.shrink_to_fit();
+    _precursorIndexScans = scans.size();
+}
+
 vector<Scan*> mzSample::getFragmentationEvents(mzSlice* slice)
 {
+    if (_precursorIndexScans != scans.size()) {
+        lock_guard<mutex> lock(_precursorIndexMutex);
+        if (_precursorIndexScans != scans.size())
+            indexPrecursors();
+    }
+
+    // retention times may have changed through alignment since the index
+    // was built, so they are checked on the scans themselves
     vector<Scan*> matchedScans;
-    for (auto scan : scans) {
-        if (scan->mslevel != 2)
-            continue;  // ms2 + scans only
-        if (scan->rt < slice->rtmin)
-            continue;
-        if (scan->rt > slice->rtmax)
+    auto entry = lower_bound(_precursorIndex.begin(),
+                             _precursorIndex.end(),
+                             slice->mzmin,
+                             [](const PrecursorEntry& e, float mz) {
+                                 return e.precursorMz < mz;
+                             });
+    for (; entry != _precursorIndex.end(); ++entry) {
+        if (entry->precursorMz > slice->mzmax)
             break;
-        if (scan->precursorMz >= slice->mzmin
-            && scan->precursorMz <= slice->mzmax) {
-            matchedScans.push_back(scan);
-        }
+        Scan* scan = entry->scan;
+        if (scan->rt < slice->rtmin || scan->rt > slice->rtmax)
+            continue;
+        matchedScans.push_back(scan);
     }
+
+    sort(matchedScans.begin(), matchedScans.end(), [](Scan* a, Scan* b) {
+        return a->scannum < b->scannum;
+    });
     return matchedScans;
 }
 
@@ -1832,6 +2394,7 @@ vector<float> mzSample::getIntensityDistribution(int mslevel)
         if (scan->mslevel != mslevel)
             continue;
 
+        ScanLoader::Pin pin(_scanLoader, scan);
         for (unsigned int i = 0; i < scan->mz.size(); i++) {
             allintensities.push_back(scan->intensity[i]);
         }
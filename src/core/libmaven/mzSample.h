@@ -4,10 +4,14 @@
 #include <chrono_io.h>
 #include <date.h>
 
+#include <atomic>
+
 #include "assert.h"
 #include "mzUtils.h"
 #include "pugixml.hpp"
+#include "scanloader.h"
 #include "standardincludes.h"
+#include "stringpool.h"
 
 #ifdef ZLIB
 #include <zlib.h>
@@ -183,6 +187,18 @@ class mzSample
 {
 
   public:
+    /**
+     * @brief Values of the global scan filters, taken when a sample starts
+     * loading, so that all its scans are filtered alike.
+     */
+    struct ScanFilters {
+        int minIntensity;
+        bool centroidScans;
+        int intensityQuantile;
+        int mslevel;
+        int polarity;
+    };
+
     /**
     * @brief Constructor for class mzSample
     */
@@ -264,6 +280,14 @@ class mzSample
     */
     void parseMzMLChromatogramList(const xml_node&);
 
+    /**
+    * @brief Parse a single mzML chromatogram into SRM scans
+    * @param chromatogram xml_node object of pugixml library
+    * @param scannum scan number of the next scan, advanced for every scan
+    * created
+    */
+    void parseMzMLChromatogram(const xml_node& chromatogram, int& scannum);
+
 
     int getSampleNoChromatogram(const string &chromatogramId);
 
@@ -337,6 +361,10 @@ class mzSample
 
     /**
     * @brief Get scan for a given scan number
+    * @details If the sample is loaded lazily or keeps its scans compact, the
+    * peak data of the scan may not be in memory. Code that reads the m/z or
+    * intensity values of the scan has to pin it while doing so (see
+    * `ScanLoader::Pin`).
     * @param scanNum Scan number
     * @return Scan class object
     * @see Scan
@@ -368,6 +396,24 @@ class mzSample
     */
     EIC *getEIC(float mzmin, float mzmax, float rtmin, float rtmax, int mslevel, int eicType, string filterline);
 
+    /**
+    * @brief Get EICs for a batch of slices in a single pass over the scans
+    * @details Slices are ordered by their retention time and m/z bounds and
+    * every scan of the sample is visited only once, contributing a point to
+    * all slices whose RT window contains it. The resulting EICs are identical
+    * to the ones that would be obtained by calling `getEIC` for each slice.
+    * @param slices Slices for which EICs are required
+    * @param mslevel MS Level. MS Level is 1 for MS data and 2 for MS/MS data
+    * @param eicType Type of EIC (max or sum)
+    * @param filterline selected filterline
+    * @return vector of EIC objects, in the same order as the given slices
+    * @see EIC
+    */
+    vector<EIC*> getEICs(const vector<mzSlice*>& slices,
+                         int mslevel,
+                         int eicType,
+                         string filterline);
+
     /**
     * @brief Get EIC based on srmId
     * @param srmId Filterline
@@ -538,12 +584,30 @@ class mzSample
                           */
     static float getMaxRt(const vector<mzSample *> &samples);
 
+    /**
+     * @brief Obtain the loader that decodes the peak data of scans on demand.
+     * @return Pointer to a ScanLoader object if the sample has been loaded
+     * lazily or its scans are stored compactly, otherwise a null pointer.
+     */
+    inline ScanLoader* scanLoader() const { return _scanLoader; }
+
     /**
      * @brief find all MS2 scans within the slice
-     * @return vector of all matching MS2 scans
+     * @details Candidates are looked up in the precursor index of the
+     * sample, so only MS2 scans whose precursor m/z falls within the slice
+     * are visited. As for `getScan`, the peak data of the scans has to be
+     * pinned before it is read.
+     * @return vector of all matching MS2 scans, in scan order
      */
     vector<Scan*> getFragmentationEvents(mzSlice* slice);
 
+    /**
+     * @brief Index the MS2 scans of the sample by precursor m/z and rt.
+     * @details Done once a sample has been loaded. Queries rebuild the
+     * index by themselves if scans were added since.
+     */
+    void buildPrecursorIndex();
+
     /**
                           * [C13Labeled?]
                           * @method C13Labeled
@@ -620,6 +684,79 @@ class mzSample
                           */
     static void setFilter_polarity(int x) { filter_polarity = x; }
 
+    /**
+     * @brief Set whether samples should be cached after being parsed.
+     * @details When enabled, the decoded scans of a sample are written to a
+     * binary cache next to its raw file, and later loads of the same file
+     * read the scans from that cache instead, as long as neither the file
+     * nor the scan filters have changed. See `SampleCache`.
+     * @param x true to read and write sample caches, false otherwise.
+     */
+    static void setUseSampleCache(bool x) { use_sampleCache = x; }
+
+    /**
+     * @brief Whether samples are read from and written to sample caches.
+     */
+    static bool getUseSampleCache() { return use_sampleCache; }
+
+    /**
+     * @brief Set whether mzML and mzXML samples are loaded lazily.
+     * @details A lazily loaded sample keeps the metadata of all its scans in
+     * memory, but decodes their peak data only when it is needed, from byte
+     * offsets recorded while the file was read. Only the peak data of the
+     * scans used most recently is kept, up to `getLazyScanCacheSize`
+     * megabytes per sample. Lazy samples are never read from or written to
+     * sample caches. See `ScanLoader`.
+     * @param x true to load samples lazily, false otherwise.
+     */
+    static void setLazyLoading(bool x) { lazy_loading = x; }
+
+    /**
+     * @brief Whether mzML and mzXML samples are loaded lazily.
+     */
+    static bool getLazyLoading() { return lazy_loading; }
+
+    /**
+     * @brief Set whether the peak data of samples that are not loaded lazily
+     * is kept compressed in memory.
+     * @details Once a sample has been loaded in full, a compressed copy of
+     * the peak data of each scan is made, and only the peak data of the
+     * scans used most recently is kept uncompressed, up to
+     * `getCompactScanCacheSize` megabytes per sample. The other scans are
+     * decompressed again when they are needed. See `ScanLoader`.
+     * @param x true to store scans compactly, false otherwise.
+     */
+    static void setCompactScans(bool x) { compact_scans = x; }
+
+    /**
+     * @brief Whether the peak data of samples is kept compressed in memory.
+     */
+    static bool getCompactScans() { return compact_scans; }
+
+    /**
+     * @brief Set the amount of uncompressed peak data, in megabytes, that a
+     * compact sample keeps in memory.
+     */
+    static void setCompactScanCacheSize(int x) { compact_scanCacheSize = x; }
+
+    /**
+     * @brief Amount of uncompressed peak data, in megabytes, that a compact
+     * sample keeps in memory.
+     */
+    static int getCompactScanCacheSize() { return compact_scanCacheSize; }
+
+    /**
+     * @brief Set the amount of decoded peak data, in megabytes, that a
+     * lazily loaded sample keeps in memory.
+     */
+    static void setLazyScanCacheSize(int x) { lazy_scanCacheSize = x; }
+
+    /**
+     * @brief Amount of decoded peak data, in megabytes, that a lazily loaded
+     * sample keeps in memory.
+     */
+    static int getLazyScanCacheSize() { return lazy_scanCacheSize; }
+
     /**
                           * [getFilter_minIntensity ]
                           * @method getFilter_minIntensity
@@ -655,6 +792,11 @@ class mzSample
                           */
     static int getFilter_polarity() { return filter_polarity; }
 
+    /**
+     * @brief Scan filters that were applied to the scans of this sample.
+     */
+    inline const ScanFilters& scanFilters() const { return _scanFilters; }
+
     vector<float> getIntensityDistribution(int mslevel);
 
     deque<Scan *> scans;
@@ -701,18 +843,107 @@ class mzSample
     vector<double> polynomialAlignmentTransformation; //parameters for polynomial transform
 
   private:
+    friend class SampleCache;
+    friend class ScanLoader;
+
     int _id;
     unsigned int _numMS1Scans;
     unsigned int _numMS2Scans;
+    ScanLoader* _scanLoader;
+    StringPool _scanStrings;  // filter lines and scan types of the scans
+
+    /**
+     * @brief MS2 scan in the precursor index, with the precursor m/z it had
+     * when the index was built.
+     */
+    struct PrecursorEntry {
+        float precursorMz;
+        Scan* scan;
+    };
+    vector<PrecursorEntry> _precursorIndex;  // by precursor m/z, then rt
+    atomic<size_t> _precursorIndexScans;  // size of `scans` when built
+    mutex _precursorIndexMutex;
 
     void sampleNaming(const char *filename);
     void checkSampleBlank(const char *filename);
 
     void setInstrumentSettigs(xml_document &doc, xml_node spectrumstore);
 
-    void parseMzXMLData(const xml_node& spectrumstore);
+    /**
+     * @brief Sort scans by retention time and renumber them in that order.
+     */
+    void sortScansByRt();
+
+    /**
+     * @brief Start loading the scans of the given file lazily, if lazy
+     * loading is enabled.
+     */
+    void createScanLoader(const char* filename,
+                          Scan* (mzSample::*decode)(const xml_node&, int),
+                          const string& endTag);
 
-    xml_node getmzXMLSpectrumData(xml_document &doc, const char *filename);
+    /**
+     * @brief Rebuild the precursor index. The caller holds its mutex.
+     */
+    void indexPrecursors();
+
+    /**
+     * @brief Keep the peak data of all scans compressed in memory, if
+     * compact scans are enabled and the sample is not loaded lazily.
+     */
+    void compactScans();
+
+    /**
+     * @brief Reset the m/z and intensity range of the sample, before it is
+     * extended by each of its scans.
+     */
+    void resetMzIntensityRange();
+
+    /**
+     * @brief Extend the m/z and intensity range of the sample by the peak
+     * data of a scan.
+     */
+    void extendMzIntensityRange(const Scan* scan);
+
+    /**
+     * @brief Apply the global scan filters to a scan that is yet to be
+     * added to the sample.
+     * @details Only the scan itself is modified, so scans may be prepared
+     * concurrently.
+     * @return False if the scan should not be part of the sample.
+     */
+    bool prepareScan(Scan* s);
+
+    /**
+     * @brief Add a prepared scan to the end of the scan list.
+     */
+    void appendScan(Scan* s);
+
+    /**
+     * @brief Decode raw spectrum elements in parallel and add the resulting
+     * scans to the sample, in the order of the elements.
+     * @param elements Raw text of the elements, cleared once decoded.
+     * @param locations Byte ranges of the elements within the file, for
+     * lazily loaded samples.
+     * @param decode Member function that creates a scan from the parsed
+     * element, or returns a nullptr if it holds no data.
+     * @return False if any of the elements could not be parsed.
+     */
+    bool decodeScans(vector<string>& elements,
+                     vector<ScanLoader::Location>& locations,
+                     Scan* (mzSample::*decode)(const xml_node&, int));
+
+    /**
+     * @brief Create a scan from an mzML spectrum, without adding it to the
+     * sample.
+     */
+    Scan* decodeMzMLSpectrum(const xml_node& spectrum, int scannum);
+
+    /**
+     * @brief Create a scan from an mzXML scan, without adding it to the
+     * sample.
+     */
+    Scan* decodeMzXMLScan(const xml_node& scan, int scannum);
 
     float parseRTFromMzXML(xml_attribute &attr);
 
@@ -730,11 +961,24 @@ class mzSample
 
     //TODO: This should be moved
     static string getFileName(const string &filename);
-    static int filter_minIntensity;
-    static bool filter_centroidScans;
-    static int filter_intensityQuantile;
-    static int filter_mslevel;
-    static int filter_polarity;
+    // global options, which may be changed while samples are being loaded
+    static atomic<int> filter_minIntensity;
+    static atomic<bool> filter_centroidScans;
+    static atomic<int> filter_intensityQuantile;
+    static atomic<int> filter_mslevel;
+    static atomic<int> filter_polarity;
+    static atomic<bool> use_sampleCache;
+    static atomic<bool> lazy_loading;
+    static atomic<int> lazy_scanCacheSize;
+    static atomic<bool> compact_scans;
+    static atomic<int> compact_scanCacheSize;
+    ScanFilters _scanFilters;
+
+    /**
+     * @brief Take the current values of the global scan filters for this
+     * sample.
+     */
+    void captureScanFilters();
 
     vector<string> filterChromatogram {
         "sample", 
@@ -4,9 +4,6 @@
 #include "csvparser.h"
 #include "masscutofftype.h"
 #include "RealFirFilter.h"
-#include <boost/iostreams/copy.hpp>
-#include <boost/iostreams/filter/zlib.hpp>
-#include <boost/iostreams/filtering_streambuf.hpp>
 
 /**
  * random collection of useful functions 
@@ -943,16 +940,41 @@ Series:  Prentice-Hall Series in Automatic Computation
     std::string decompressString(const std::string& str)
     {
         string outstring;
+        inflateBytes(str.data(), str.size(), outstring);
+        return outstring;
+    }
+
+    bool inflateBytes(const char* data, size_t size, std::string& output)
+    {
 #ifdef ZLIB
-        stringstream compressed(str);
-        stringstream decompressed;
-        boost::iostreams::filtering_streambuf<boost::iostreams::input> in;
-        in.push(boost::iostreams::zlib_decompressor());
-        in.push(compressed);
-        boost::iostreams::copy(in, decompressed);
-        outstring = decompressed.str();
+        z_stream strm;
+        strm.zalloc = Z_NULL;
+        strm.zfree = Z_NULL;
+        strm.opaque = Z_NULL;
+        strm.next_in = (Bytef*) data;
+        strm.avail_in = size;
+        if (inflateInit(&strm) != Z_OK)
+            return false;
+
+        // numeric arrays usually compress to less than a third of their size
+        size_t start = output.size();
+        size_t capacity = max(size * 4, size_t(1024));
+        int err = Z_OK;
+        while (err == Z_OK) {
+            output.resize(start + capacity);
+            strm.next_out = (Bytef*) &output[start + strm.total_out];
+            strm.avail_out = capacity - strm.total_out;
+            err = inflate(&strm, Z_NO_FLUSH);
+            if (err == Z_OK && strm.avail_out > 0 && strm.avail_in == 0)
+                err = Z_BUF_ERROR;  // truncated stream
+            capacity *= 2;
+        }
+        output.resize(start + strm.total_out);
+        inflateEnd(&strm);
+        return err == Z_STREAM_END;
+#else
+        return false;
 #endif
-        return outstring;
     }
 
     bool gzipInflate( const std::string& compressedBytes, std::string& uncompressedBytes ) {
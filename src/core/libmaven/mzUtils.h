@@ -423,13 +423,23 @@ namespace mzUtils {
             std::string& uncompressedBytes);
 
     /**
-     * @method Decompress an STL string using zlib (deflate) filter of Boost
-     * Iostream library and return uncompressed data.
+     * @method Decompress an STL string containing zlib (deflate) data and
+     * return uncompressed data.
      * @param str A STL string containing compressed zlib binary data.
      * @return An STL string containing uncompressed data.
      */
     std::string decompressString(const std::string& str);
 
+    /**
+     * @brief Inflate a buffer of zlib (deflate) data using zlib directly.
+     * @param data Pointer to the compressed data.
+     * @param size Size of the compressed data in bytes.
+     * @param output String to which the uncompressed data is appended.
+     * @return False if the data is not a complete zlib stream. Whatever could
+     * be inflated is appended to the output nonetheless.
+     */
+    bool inflateBytes(const char* data, size_t size, std::string& output);
+
     /* rounding and ppm functions */
     /**
      * [ppmDist ]
@@ -0,0 +1,369 @@
+#include <sys/stat.h>
+
+#include "samplecache.h"
+#include "mzSample.h"
+#include "Scan.h"
+
+namespace {
+    const char CACHE_MAGIC[8] = {'E', 'M', 'C', 'A', 'C', 'H', 'E', '\0'};
+    const uint32_t CACHE_VERSION = 1;
+    const uint32_t CACHE_BYTE_ORDER = 0x01020304;
+
+    // number of bytes hashed at either end of the raw file
+    const uint64_t FINGERPRINT_BYTES = 1 << 20;
+
+    struct CacheHeader {
+        char magic[8];
+        uint32_t version;
+        uint32_t byteOrder;
+        uint64_t sourceSize;
+        int64_t sourceModified;
+        uint64_t sourceHash;
+        int32_t filterMinIntensity;
+        int32_t filterCentroidScans;
+        int32_t filterIntensityQuantile;
+        int32_t filterPolarity;
+        int32_t filterMslevel;
+        int32_t sampleNumber;
+        uint64_t injectionTime;
+        uint64_t stringCount;
+        uint64_t stringBytes;
+        uint64_t infoCount;
+        uint64_t scanCount;
+        uint64_t observationCount;
+    };
+
+    struct ScanRecord {
+        int32_t mslevel;
+        int32_t centroided;
+        int32_t scannum;
+        int32_t precursorCharge;
+        int32_t precursorScanNum;
+        int32_t polarity;
+        float rt;
+        float originalRt;
+        float precursorMz;
+        float precursorIntensity;
+        float isolationWindow;
+        float productMz;
+        float collisionEnergy;
+        uint32_t filterLine;
+        uint32_t scanType;
+        uint32_t nobs;
+        uint64_t offset;
+    };
+
+    uint64_t padding(uint64_t size) { return (8 - size % 8) % 8; }
+
+    void setFilters(CacheHeader& header, const mzSample* sample)
+    {
+        const mzSample::ScanFilters& filters = sample->scanFilters();
+        header.filterMinIntensity = filters.minIntensity;
+        header.filterCentroidScans = filters.centroidScans;
+        header.filterIntensityQuantile = filters.intensityQuantile;
+        header.filterPolarity = filters.polarity;
+        header.filterMslevel = filters.mslevel;
+    }
+
+
+    uint64_t fnv1a(const char* data, size_t size, uint64_t hash)
+    {
+        for (size_t i = 0; i < size; i++) {
+            hash ^= static_cast<unsigned char>(data[i]);
+            hash *= 1099511628211ULL;
+        }
+        return hash;
+    }
+
+    /**
+     * Assigns consecutive indices to distinct strings, in order of first
+     * appearance.
+     */
+    class StringTable
+    {
+    public:
+        uint32_t index(const string& s)
+        {
+            auto it = _indices.find(s);
+            if (it != _indices.end())
+                return it->second;
+            uint32_t i = _strings.size();
+            _indices[s] = i;
+            _strings.push_back(s);
+            return i;
+        }
+
+        const vector<string>& strings() const { return _strings; }
+
+    private:
+        map<string, uint32_t> _indices;
+        vector<string> _strings;
+    };
+}
+
+string SampleCache::cachePath(const string& sourcePath)
+{
+    return sourcePath + ".emcache";
+}
+
+bool SampleCache::_fingerprint(const string& path, Fingerprint& fingerprint)
+{
+    struct stat fileInfo;
+    if (stat(path.c_str(), &fileInfo) != 0)
+        return false;
+
+    ifstream file(path, ios::in | ios::binary);
+    if (!file.is_open())
+        return false;
+
+    fingerprint.size = fileInfo.st_size;
+    fingerprint.modified = fileInfo.st_mtime;
+
+    // hashing the whole file would take about as long as parsing it
+    uint64_t head = min(fingerprint.size, FINGERPRINT_BYTES);
+    uint64_t tail = min(fingerprint.size - head, FINGERPRINT_BYTES);
+    vector<char> buffer(head + tail);
+    file.read(buffer.data(), head);
+    if (tail > 0) {
+        file.seekg(fingerprint.size - tail);
+        file.read(buffer.data() + head, tail);
+    }
+    if (!file)
+        return false;
+    fingerprint.hash = fnv1a(buffer.data(), buffer.size(), 14695981039346656037ULL);
+    return true;
+}
+
+bool SampleCache::write(const mzSample* sample, const string& sourcePath)
+{
+    Fingerprint source;
+    if (!_fingerprint(sourcePath, source))
+        return false;
+
+    StringTable strings;
+    vector<ScanRecord> records;
+    records.reserve(sample->scans.size());
+    uint64_t observationCount = 0;
+    for (auto scan : sample->scans) {
+        ScanRecord record;
+        record.mslevel = scan->mslevel;
+        record.centroided = scan->centroided;
+        record.scannum = scan->scannum;
+        record.precursorCharge = scan->precursorCharge;
+        record.precursorScanNum = scan->precursorScanNum;
+        record.polarity = scan->polarity;
+        record.rt = scan->rt;
+        record.originalRt = scan->originalRt;
+        record.precursorMz = scan->precursorMz;
+        record.precursorIntensity = scan->precursorIntensity;
+        record.isolationWindow = scan->isolationWindow;
+        record.productMz = scan->productMz;
+        record.collisionEnergy = scan->collisionEnergy;
+        record.filterLine = strings.index(scan->filterLine);
+        record.scanType = strings.index(scan->scanType);
+        record.nobs = scan->nobs();
+        record.offset = observationCount;
+        observationCount += record.nobs;
+        records.push_back(record);
+    }
+
+    vector<uint32_t> info;
+    for (const auto& entry : sample->instrumentInfo) {
+        info.push_back(strings.index(entry.first));
+        info.push_back(strings.index(entry.second));
+    }
+
+    uint64_t stringBytes = 0;
+    for (const auto& s : strings.strings())
+        stringBytes += sizeof(uint32_t) + s.size();
+
+    CacheHeader header;
+    memset(&header, 0, sizeof(header));
+    memcpy(header.magic, CACHE_MAGIC, sizeof(CACHE_MAGIC));
+    header.version = CACHE_VERSION;
+    header.byteOrder = CACHE_BYTE_ORDER;
+    header.sourceSize = source.size;
+    header.sourceModified = source.modified;
+    header.sourceHash = source.hash;
+    setFilters(header, sample);
+    header.sampleNumber = sample->sampleNumber;
+    header.injectionTime = sample->injectionTime;
+    header.stringCount = strings.strings().size();
+    header.stringBytes = stringBytes;
+    header.infoCount = sample->instrumentInfo.size();
+    header.scanCount = records.size();
+    header.observationCount = observationCount;
+
+    string cacheFile = cachePath(sourcePath);
+    string temporaryFile = cacheFile + ".tmp";
+    ofstream file(temporaryFile, ios::out | ios::binary | ios::trunc);
+    if (!file.is_open())
+        return false;
+
+    const char zeros[8] = {0};
+    file.write(reinterpret_cast<const char*>(&header), sizeof(header));
+    for (const auto& s : strings.strings()) {
+        uint32_t length = s.size();
+        file.write(reinterpret_cast<const char*>(&length), sizeof(length));
+        file.write(s.data(), length);
+    }
+    file.write(zeros, padding(stringBytes));
+    file.write(reinterpret_cast<const char*>(info.data()),
+               info.size() * sizeof(uint32_t));
+    file.write(zeros, padding(info.size() * sizeof(uint32_t)));
+    file.write(reinterpret_cast<const char*>(records.data()),
+               records.size() * sizeof(ScanRecord));
+    for (auto scan : sample->scans) {
+        file.write(reinterpret_cast<const char*>(scan->mz.data()),
+                   scan->mz.size() * sizeof(float));
+    }
+    file.write(zeros, padding(observationCount * sizeof(float)));
+    for (auto scan : sample->scans) {
+        file.write(reinterpret_cast<const char*>(scan->intensity.data()),
+                   scan->intensity.size() * sizeof(float));
+    }
+    file.close();
+
+    if (!file) {
+        remove(temporaryFile.c_str());
+        return false;
+    }
+
+    remove(cacheFile.c_str());
+    if (rename(temporaryFile.c_str(), cacheFile.c_str()) != 0) {
+        remove(temporaryFile.c_str());
+        return false;
+    }
+    return true;
+}
+
+bool SampleCache::read(mzSample* sample, const string& sourcePath)
+{
+    string cacheFile = cachePath(sourcePath);
+    struct stat cacheInfo;
+    if (stat(cacheFile.c_str(), &cacheInfo) != 0)
+        return false;
+
+    Fingerprint source;
+    if (!_fingerprint(sourcePath, source))
+        return false;
+
+    ifstream file(cacheFile, ios::in | ios::binary);
+    CacheHeader header;
+    if (!file.read(reinterpret_cast<char*>(&header), sizeof(header)))
+        return false;
+
+    CacheHeader current;
+    setFilters(current, sample);
+    if (memcmp(header.magic, CACHE_MAGIC, sizeof(CACHE_MAGIC)) != 0
+        || header.version != CACHE_VERSION
+        || header.byteOrder != CACHE_BYTE_ORDER
+        || header.sourceSize != source.size
+        || header.sourceModified != source.modified
+        || header.sourceHash != source.hash
+        || header.filterMinIntensity != current.filterMinIntensity
+        || header.filterCentroidScans != current.filterCentroidScans
+        || header.filterIntensityQuantile != current.filterIntensityQuantile
+        || header.filterPolarity != current.filterPolarity
+        || header.filterMslevel != current.filterMslevel) {
+        return false;
+    }
+
+    uint64_t infoBytes = header.infoCount * 2 * sizeof(uint32_t);
+    uint64_t observationBytes = header.observationCount * sizeof(float);
+    uint64_t expectedSize = sizeof(header)
+                            + header.stringBytes + padding(header.stringBytes)
+                            + infoBytes + padding(infoBytes)
+                            + header.scanCount * sizeof(ScanRecord)
+                            + observationBytes + padding(observationBytes)
+                            + observationBytes;
+    if (static_cast<uint64_t>(cacheInfo.st_size) != expectedSize)
+        return false;
+
+    vector<string> strings(header.stringCount);
+    for (auto& s : strings) {
+        uint32_t length = 0;
+        file.read(reinterpret_cast<char*>(&length), sizeof(length));
+        if (!file || length > header.stringBytes)
+            return false;
+        s.resize(length);
+        file.read(&s[0], length);
+    }
+    file.ignore(padding(header.stringBytes));
+
+    vector<uint32_t> info(header.infoCount * 2);
+    file.read(reinterpret_cast<char*>(info.data()), infoBytes);
+    file.ignore(padding(infoBytes));
+
+    vector<ScanRecord> records(header.scanCount);
+    file.read(reinterpret_cast<char*>(records.data()),
+              records.size() * sizeof(ScanRecord));
+    if (!file)
+        return false;
+
+    for (auto index : info) {
+        if (index >= strings.size())
+            return false;
+    }
+    uint64_t observations = 0;
+    for (const auto& record : records) {
+        if (record.filterLine >= strings.size()
+            || record.scanType >= strings.size()
+            || record.offset != observations)
+            return false;
+        observations += record.nobs;
+    }
+    if (observations != header.observationCount)
+        return false;
+
+    vector<Scan*> scans;
+    scans.reserve(records.size());
+    for (const auto& record : records) {
+        Scan* scan = new Scan(sample,
+                              record.scannum,
+                              record.mslevel,
+                              record.rt,
+                              record.precursorMz,
+                              record.polarity);
+        scan->centroided = record.centroided;
+        scan->originalRt = record.originalRt;
+        scan->precursorIntensity = record.precursorIntensity;
+        scan->precursorCharge = record.precursorCharge;
+        scan->precursorScanNum = record.precursorScanNum;
+        scan->isolationWindow = record.isolationWindow;
+        scan->productMz = record.productMz;
+        scan->collisionEnergy = record.collisionEnergy;
+        scan->filterLine = sample->_scanStrings.intern(strings[record.filterLine]);
+        scan->scanType = sample->_scanStrings.intern(strings[record.scanType]);
+        scan->mz.resize(record.nobs);
+        scan->intensity.resize(record.nobs);
+        file.read(reinterpret_cast<char*>(scan->mz.data()),
+                  record.nobs * sizeof(float));
+        scans.push_back(scan);
+    }
+    file.ignore(padding(observationBytes));
+    for (auto scan : scans) {
+        file.read(reinterpret_cast<char*>(scan->intensity.data()),
+                  scan->intensity.size() * sizeof(float));
+    }
+
+    if (!file) {
+        for (auto scan : scans)
+            delete scan;
+        return false;
+    }
+
+    for (auto scan : scans) {
+        scan->summarizePeaks();
+        sample->scans.push_back(scan);
+        if (scan->mslevel == 1)
+            ++sample->_numMS1Scans;
+        if (scan->mslevel == 2)
+            ++sample->_numMS2Scans;
+    }
+    for (size_t i = 0; i + 1 < info.size(); i += 2)
+        sample->instrumentInfo[strings[info[i]]] = strings[info[i + 1]];
+    sample->sampleNumber = header.sampleNumber;
+    sample->injectionTime = header.injectionTime;
+    return true;
+}
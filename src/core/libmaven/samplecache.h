@@ -0,0 +1,70 @@
+#ifndef SAMPLECACHE_H
+#define SAMPLECACHE_H
+
+#include <cstdint>
+
+#include "standardincludes.h"
+
+class mzSample;
+
+using namespace std;
+
+/**
+ * @class SampleCache
+ * @ingroup libmaven
+ * @brief Binary sidecar file that holds the decoded scans of a sample.
+ * @details Parsing large mzML or mzXML files is dominated by XML parsing,
+ * base64 decoding and decompression. Once a sample has been parsed, its scans
+ * can be written to a cache file next to the raw file (with an ".emcache"
+ * extension appended to its name), from which they are read back with a few
+ * sequential reads on later loads.
+ *
+ * A cache file consists of a header, a table of unique strings (filter lines
+ * and scan types), a table of fixed-size scan records, and finally the m/z
+ * and intensity values of all scans, each stored as one contiguous array.
+ * All sections are 8-byte aligned, so the file could equally be memory
+ * mapped. The header records the size, modification time and a hash of the
+ * head and tail of the raw file, as well as the global scan filters that
+ * were in effect when the sample was parsed. A cache whose raw file or scan
+ * filters have changed since is ignored (and eventually overwritten).
+ */
+class SampleCache
+{
+public:
+    /**
+     * @brief Path of the cache file for a raw sample file.
+     */
+    static string cachePath(const string& sourcePath);
+
+    /**
+     * @brief Load the scans and instrument information of a sample from the
+     * cache of its raw file.
+     * @details The sample is left untouched if no valid cache exists.
+     * @param sample Sample without any scans.
+     * @param sourcePath Path of the raw file.
+     * @return True if the sample was loaded from the cache.
+     */
+    static bool read(mzSample* sample, const string& sourcePath);
+
+    /**
+     * @brief Write the scans and instrument information of a sample, freshly
+     * parsed from a raw file, to the cache of that file.
+     * @details The cache is written to a temporary file first, which then
+     * replaces any previous cache.
+     * @param sample Sample parsed from the raw file.
+     * @param sourcePath Path of the raw file.
+     * @return True if the cache was written.
+     */
+    static bool write(const mzSample* sample, const string& sourcePath);
+
+private:
+    struct Fingerprint {
+        uint64_t size;
+        int64_t modified;
+        uint64_t hash;
+    };
+
+    static bool _fingerprint(const string& path, Fingerprint& fingerprint);
+};
+
+#endif // SAMPLECACHE_H
@@ -0,0 +1,307 @@
+#include <zlib.h>
+
+#include "scanloader.h"
+#include "mzSample.h"
+#include "Scan.h"
+
+namespace {
+    // number of values and size of the uncompressed data
+    const size_t PACKED_HEADER_SIZE = 2 * sizeof(uint32_t);
+}
+
+ScanLoader::ScanLoader(mzSample* sample,
+                       const string& filename,
+                       Decoder decode,
+                       const string& endTag,
+                       size_t capacity)
+    : _sample(sample),
+      _decode(decode),
+      _endTag(endTag),
+      _capacity(capacity),
+      _residentBytes(0),
+      _compressedBytes(0),
+      _file(filename, ios::in | ios::binary)
+{
+}
+
+ScanLoader::ScanLoader(mzSample* sample, size_t capacity)
+    : _sample(sample),
+      _decode(nullptr),
+      _capacity(capacity),
+      _residentBytes(0),
+      _compressedBytes(0)
+{
+}
+
+void ScanLoader::add(Scan* scan, const Location& location)
+{
+    lock_guard<mutex> lock(_mutex);
+    Entry& entry = _entries[scan];
+    entry.location = location;
+    entry.pins = 0;
+    _register(scan, entry);
+}
+
+bool ScanLoader::compress(Scan* scan)
+{
+    // scans with only a handful of points do not compress
+    string packed;
+    pack(scan->mz, scan->intensity, packed);
+    if (packed.size()
+        >= (scan->mz.size() + scan->intensity.size()) * sizeof(float)) {
+        return false;
+    }
+
+    lock_guard<mutex> lock(_mutex);
+    Entry& entry = _entries[scan];
+    entry.packed.swap(packed);
+    entry.pins = 0;
+    _compressedBytes += entry.packed.size();
+    _register(scan, entry);
+    return true;
+}
+
+bool ScanLoader::acquire(Scan* scan)
+{
+    return _load(scan, true);
+}
+
+void ScanLoader::release(Scan* scan)
+{
+    lock_guard<mutex> lock(_mutex);
+    auto it = _entries.find(scan);
+    if (it == _entries.end() || it->second.pins == 0)
+        return;
+    if (--it->second.pins == 0)
+        _evict();
+}
+
+size_t ScanLoader::residentBytes() const
+{
+    lock_guard<mutex> lock(_mutex);
+    return _residentBytes;
+}
+
+size_t ScanLoader::compressedBytes() const
+{
+    lock_guard<mutex> lock(_mutex);
+    return _compressedBytes;
+}
+
+size_t ScanLoader::scanCount() const
+{
+    lock_guard<mutex> lock(_mutex);
+    return _entries.size();
+}
+
+bool ScanLoader::_load(Scan* scan, bool pin)
+{
+    Location location;
+    const string* packed = nullptr;
+    {
+        lock_guard<mutex> lock(_mutex);
+        auto it = _entries.find(scan);
+        if (it == _entries.end())
+            return true;
+
+        Entry& entry = it->second;
+        if (pin)
+            entry.pins++;
+        if (entry.loaded) {
+            _recent.splice(_recent.begin(), _recent, entry.position);
+            return true;
+        }
+        location = entry.location;
+        if (!entry.packed.empty())
+            packed = &entry.packed;
+    }
+
+    // decoding is the expensive part and happens without holding the lock;
+    // if another thread loads the same scan meanwhile, its copy is kept.
+    // The compressed copy of a scan is never modified once it was made.
+    vector<float> mz;
+    vector<float> intensity;
+    bool decoded = packed != nullptr ? unpack(*packed, mz, intensity)
+                                     : _decodeElement(location, mz, intensity);
+
+    lock_guard<mutex> lock(_mutex);
+    Entry& entry = _entries[scan];
+    if (entry.loaded) {
+        _recent.splice(_recent.begin(), _recent, entry.position);
+        return true;
+    }
+    if (!decoded)
+        return false;
+
+    scan->mz.swap(mz);
+    scan->intensity.swap(intensity);
+    _register(scan, entry);
+    return true;
+}
+
+void ScanLoader::_register(Scan* scan, Entry& entry)
+{
+    entry.loaded = true;
+    entry.bytes = (scan->mz.capacity() + scan->intensity.capacity())
+                  * sizeof(float);
+    _recent.push_front(scan);
+    entry.position = _recent.begin();
+    _residentBytes += entry.bytes;
+    _evict();
+}
+
+bool ScanLoader::_decodeElement(const Location& location,
+                                vector<float>& mz,
+                                vector<float>& intensity)
+{
+    string element(location.length, '\0');
+    {
+        lock_guard<mutex> lock(_fileMutex);
+        _file.clear();
+        _file.seekg(location.offset);
+        _file.read(&element[0], location.length);
+        if (!_file)
+            return false;
+    }
+    if (location.closeElement)
+        element += _endTag;
+
+    pugi::xml_document doc;
+    pugi::xml_parse_result parseResult = doc.load_buffer_inplace(
+        &element[0], element.size(), pugi::parse_minimal);
+    if (parseResult.status != pugi::status_ok || !doc.first_child())
+        return false;
+
+    // the same filters apply as when the scan was first decoded
+    Scan* scan = (_sample->*_decode)(doc.first_child(), 0);
+    if (scan == nullptr)
+        return false;
+    bool accepted = _sample->prepareScan(scan);
+    if (accepted) {
+        mz.swap(scan->mz);
+        intensity.swap(scan->intensity);
+    }
+    delete scan;
+    return accepted;
+}
+
+void ScanLoader::_evict()
+{
+    // walk from the least recently used scan, skipping pinned ones; the
+    // scan used last is always kept, even if it exceeds the capacity alone
+    auto it = _recent.end();
+    while (_residentBytes > _capacity && it != _recent.begin()) {
+        --it;
+        if (it == _recent.begin())
+            break;
+        Scan* scan = *it;
+        Entry& entry = _entries[scan];
+        if (entry.pins > 0)
+            continue;
+
+        vector<float>().swap(scan->mz);
+        vector<float>().swap(scan->intensity);
+        entry.loaded = false;
+        _residentBytes -= entry.bytes;
+        entry.bytes = 0;
+        it = _recent.erase(it);
+    }
+}
+
+void ScanLoader::pack(const vector<float>& mz,
+                      const vector<float>& intensity,
+                      string& packed)
+{
+    uint32_t count = mz.size();
+    string raw;
+    raw.reserve(count * (2 + sizeof(float)));
+
+    // m/z values, as zigzag-encoded differences between the bit patterns of
+    // successive values; positive floats order like their bit patterns
+    uint32_t previous = 0;
+    for (uint32_t i = 0; i < count; i++) {
+        uint32_t bits;
+        memcpy(&bits, &mz[i], sizeof(bits));
+        uint32_t delta = bits - previous;
+        uint32_t zigzag = (delta << 1) ^ (0 - (delta >> 31));
+        previous = bits;
+        while (zigzag >= 0x80) {
+            raw.push_back(static_cast<char>(zigzag | 0x80));
+            zigzag >>= 7;
+        }
+        raw.push_back(static_cast<char>(zigzag));
+    }
+
+    // intensities, with the bytes of equal significance next to each other
+    // so that the slowly varying exponent bytes compress well
+    size_t offset = raw.size();
+    raw.resize(offset + count * sizeof(float));
+    const char* bytes = reinterpret_cast<const char*>(intensity.data());
+    for (size_t b = 0; b < sizeof(float); b++) {
+        char* plane = &raw[offset + b * count];
+        for (uint32_t i = 0; i < count; i++)
+            plane[i] = bytes[i * sizeof(float) + b];
+    }
+
+    uint32_t header[2] = {count, static_cast<uint32_t>(raw.size())};
+    uLongf size = compressBound(raw.size());
+    packed.resize(PACKED_HEADER_SIZE + size);
+    memcpy(&packed[0], header, PACKED_HEADER_SIZE);
+    compress2(reinterpret_cast<Bytef*>(&packed[PACKED_HEADER_SIZE]),
+              &size,
+              reinterpret_cast<const Bytef*>(raw.data()),
+              raw.size(),
+              Z_BEST_SPEED);
+    packed.resize(PACKED_HEADER_SIZE + size);
+    packed.shrink_to_fit();
+}
+
+bool ScanLoader::unpack(const string& packed,
+                        vector<float>& mz,
+                        vector<float>& intensity)
+{
+    if (packed.size() < PACKED_HEADER_SIZE)
+        return false;
+    uint32_t header[2];
+    memcpy(header, packed.data(), PACKED_HEADER_SIZE);
+    uint32_t count = header[0];
+
+    string raw(header[1], '\0');
+    uLongf size = raw.size();
+    int status = uncompress(
+        reinterpret_cast<Bytef*>(&raw[0]),
+        &size,
+        reinterpret_cast<const Bytef*>(packed.data() + PACKED_HEADER_SIZE),
+        packed.size() - PACKED_HEADER_SIZE);
+    if (status != Z_OK || size != raw.size()
+        || raw.size() < count * sizeof(float)) {
+        return false;
+    }
+
+    mz.resize(count);
+    const unsigned char* in = reinterpret_cast<const unsigned char*>(raw.data());
+    const unsigned char* deltasEnd = in + raw.size() - count * sizeof(float);
+    uint32_t previous = 0;
+    for (uint32_t i = 0; i < count; i++) {
+        uint32_t zigzag = 0;
+        for (int shift = 0; in < deltasEnd && shift < 32; shift += 7) {
+            unsigned char byte = *in++;
+            zigzag |= static_cast<uint32_t>(byte & 0x7f) << shift;
+            if (!(byte & 0x80))
+                break;
+        }
+        previous += (zigzag >> 1) ^ (0 - (zigzag & 1));
+        memcpy(&mz[i], &previous, sizeof(previous));
+    }
+    if (in != deltasEnd)
+        return false;
+
+    intensity.resize(count);
+    char* bytes = reinterpret_cast<char*>(intensity.data());
+    for (size_t b = 0; b < sizeof(float); b++) {
+        const unsigned char* plane = deltasEnd + b * count;
+        for (uint32_t i = 0; i < count; i++)
+            bytes[i * sizeof(float) + b] = plane[i];
+    }
+    return true;
+}
@@ -0,0 +1,203 @@
+#ifndef SCANLOADER_H
+#define SCANLOADER_H
+
+#include <cstdint>
+#include <list>
+#include <mutex>
+#include <unordered_map>
+
+#include "pugixml.hpp"
+#include "standardincludes.h"
+
+class mzSample;
+class Scan;
+
+using namespace std;
+
+/**
+ * @class ScanLoader
+ * @ingroup libmaven
+ * @brief Decodes the peak data of the scans of a sample on demand.
+ * @details When samples are loaded lazily, a scan keeps its metadata (rt,
+ * mslevel, precursor, filter line, ...) in memory at all times, while its m/z
+ * and intensity arrays are only held for the scans that have been used most
+ * recently. The arrays of all other scans are dropped and decoded again from
+ * the raw element of the scan, whose byte range in the file was recorded
+ * while the file was being parsed.
+ *
+ * Alternatively, the loader can keep the peak data of every scan in memory,
+ * compressed, and decompress it again instead of going back to the file.
+ * The m/z values are stored as variable-length deltas between the bit
+ * patterns of neighbouring values, which are small since m/z values are
+ * sorted, and the intensities with their bytes grouped by significance;
+ * both are then deflated together. The encoding is lossless.
+ *
+ * Code that reads the peak data of a scan should hold a `Pin` on it for as
+ * long as it does so. Pinned scans are never evicted, even while other
+ * threads load further scans. Scans that have not been registered with the
+ * loader (for example, chromatogram-based SRM scans) are always resident.
+ */
+class ScanLoader
+{
+public:
+    /**
+     * @brief Byte range of the raw element of a scan within its file.
+     * @details An mzXML scan with nested scans ends at its first child scan,
+     * and has to be closed explicitly before it can be parsed.
+     */
+    struct Location {
+        uint64_t offset;
+        uint64_t length;
+        bool closeElement;
+    };
+
+    typedef Scan* (mzSample::*Decoder)(const pugi::xml_node&, int);
+
+    /**
+     * @brief Create a loader for the scans of a sample.
+     * @param sample Sample that owns the scans.
+     * @param filename Path of the raw file of the sample.
+     * @param decode Member function of the sample that decodes a raw element
+     * into a new scan.
+     * @param endTag Tag used to close elements with `closeElement` set.
+     * @param capacity Number of bytes of peak data kept in memory. Pinned
+     * scans and the scan used last are kept even beyond this limit.
+     */
+    ScanLoader(mzSample* sample,
+               const string& filename,
+               Decoder decode,
+               const string& endTag,
+               size_t capacity);
+
+    /**
+     * @brief Create a loader that keeps the peak data of the scans of a
+     * sample compressed in memory. Scans are managed through `compress`.
+     * @param sample Sample that owns the scans.
+     * @param capacity Number of bytes of uncompressed peak data kept in
+     * memory.
+     */
+    ScanLoader(mzSample* sample, size_t capacity);
+
+    /**
+     * @brief Start managing the peak data of a freshly decoded scan.
+     * @details The scan counts as recently used and may be evicted right
+     * away if the loader is over its capacity.
+     */
+    void add(Scan* scan, const Location& location);
+
+    /**
+     * @brief Start managing the peak data of a scan by keeping a compressed
+     * copy of it. Compression happens outside the lock of the loader, so
+     * scans can be added from several threads at once.
+     * @return False if compressing the scan would not save any memory, in
+     * which case the scan is left alone and always stays resident.
+     */
+    bool compress(Scan* scan);
+
+    /**
+     * @brief Load a scan and keep it in memory until `release` is called.
+     */
+    bool acquire(Scan* scan);
+
+    /**
+     * @brief Undo one call to `acquire`.
+     */
+    void release(Scan* scan);
+
+    /**
+     * @brief Number of bytes of peak data currently held by managed scans.
+     */
+    size_t residentBytes() const;
+
+    /**
+     * @brief Number of bytes held by the compressed copies of peak data.
+     */
+    size_t compressedBytes() const;
+
+    /**
+     * @brief Number of scans managed by the loader.
+     */
+    size_t scanCount() const;
+
+    /**
+     * @brief Compress peak data into the format used for compact scans.
+     * @details Packed data is also written to project files, so the format
+     * must stay readable by `unpack` once released.
+     * @param mz m/z values, best sorted in increasing order.
+     * @param intensity Intensities, one for each m/z value.
+     * @param packed String that receives the packed data.
+     */
+    static void pack(const vector<float>& mz,
+                     const vector<float>& intensity,
+                     string& packed);
+
+    /**
+     * @brief Decompress peak data created by `pack`.
+     * @param packed The packed data.
+     * @param mz Vector that receives the m/z values.
+     * @param intensity Vector that receives the intensities.
+     * @return False if the data is corrupt.
+     */
+    static bool unpack(const string& packed,
+                       vector<float>& mz,
+                       vector<float>& intensity);
+
+    /**
+     * @brief Keeps a scan loaded for the lifetime of the object. Does nothing
+     * if no loader is given.
+     */
+    class Pin
+    {
+    public:
+        Pin(ScanLoader* loader, Scan* scan) : _loader(loader), _scan(scan)
+        {
+            if (_loader)
+                _loader->acquire(_scan);
+        }
+        ~Pin()
+        {
+            if (_loader)
+                _loader->release(_scan);
+        }
+        Pin(const Pin&) = delete;
+        Pin& operator=(const Pin&) = delete;
+
+    private:
+        ScanLoader* _loader;
+        Scan* _scan;
+    };
+
+private:
+    struct Entry {
+        Location location;
+        string packed;  // compressed peak data, if not read from the file
+        bool loaded;
+        int pins;
+        size_t bytes;
+        list<Scan*>::iterator position;
+    };
+
+    mzSample* _sample;
+    Decoder _decode;
+    string _endTag;
+    size_t _capacity;
+
+    mutable mutex _mutex;
+    unordered_map<Scan*, Entry> _entries;
+    list<Scan*> _recent;  // loaded scans, most recently used first
+    size_t _residentBytes;
+    size_t _compressedBytes;
+
+    mutex _fileMutex;
+    ifstream _file;
+
+    bool _load(Scan* scan, bool pin);
+    void _register(Scan* scan, Entry& entry);
+    bool _decodeElement(const Location& location,
+                        vector<float>& mz,
+                        vector<float>& intensity);
+    void _evict();
+
+};
+
+#endif  // SCANLOADER_H
@@ -0,0 +1,98 @@
+#include "sliceindex.h"
+#include "datastructures/mzSlice.h"
+
+SliceIndex::SliceIndex(float mzCellSize, float rtCellSize)
+    : _mzCellSize(mzCellSize), _rtCellSize(rtCellSize)
+{
+}
+
+void SliceIndex::setCellSize(float mzCellSize, float rtCellSize)
+{
+    if (mzCellSize <= 0.0f || rtCellSize <= 0.0f)
+        return;
+    if (mzCellSize == _mzCellSize && rtCellSize == _rtCellSize)
+        return;
+
+    _mzCellSize = mzCellSize;
+    _rtCellSize = rtCellSize;
+    _cells.clear();
+    for (auto slice : _slices)
+        _register(slice);
+}
+
+void SliceIndex::insert(mzSlice* slice)
+{
+    _slices.push_back(slice);
+    _register(slice);
+}
+
+void SliceIndex::clear()
+{
+    _slices.clear();
+    _cells.clear();
+}
+
+vector<mzSlice*> SliceIndex::query(float mzmin,
+                                   float mzmax,
+                                   float rtmin,
+                                   float rtmax) const
+{
+    vector<mzSlice*> found;
+    if (_slices.empty() || mzmax < mzmin || rtmax < rtmin)
+        return found;
+
+    int mzFirst = _mzCell(mzmin);
+    int mzLast = _mzCell(mzmax);
+    int rtFirst = _rtCell(rtmin);
+    int rtLast = _rtCell(rtmax);
+    for (int i = mzFirst; i <= mzLast; ++i) {
+        for (int j = rtFirst; j <= rtLast; ++j) {
+            auto cell = _cells.find(_key(i, j));
+            if (cell == _cells.end())
+                continue;
+
+            for (auto slice : cell->second) {
+                if (slice->mzmax < mzmin || slice->mzmin > mzmax
+                    || slice->rtmax < rtmin || slice->rtmin > rtmax) {
+                    continue;
+                }
+
+                // a slice spanning several of the visited cells is only
+                // reported from the first cell shared by it and the query
+                if (i != max(mzFirst, _mzCell(slice->mzmin))
+                    || j != max(rtFirst, _rtCell(slice->rtmin))) {
+                    continue;
+                }
+                found.push_back(slice);
+            }
+        }
+    }
+    return found;
+}
+
+int SliceIndex::_mzCell(float mz) const
+{
+    return static_cast<int>(floor(mz / _mzCellSize));
+}
+
+int SliceIndex::_rtCell(float rt) const
+{
+    return static_cast<int>(floor(rt / _rtCellSize));
+}
+
+uint64_t SliceIndex::_key(int mzCell, int rtCell)
+{
+    return (static_cast<uint64_t>(static_cast<uint32_t>(mzCell)) << 32)
+           | static_cast<uint32_t>(rtCell);
+}
+
+void SliceIndex::_register(mzSlice* slice)
+{
+    int mzFirst = _mzCell(slice->mzmin);
+    int mzLast = _mzCell(slice->mzmax);
+    int rtFirst = _rtCell(slice->rtmin);
+    int rtLast = _rtCell(slice->rtmax);
+    for (int i = mzFirst; i <= mzLast; ++i)
+        for (int j = rtFirst; j <= rtLast; ++j)
+            _cells[_key(i, j)].push_back(slice);
+}
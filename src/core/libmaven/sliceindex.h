@@ -0,0 +1,86 @@
+#ifndef SLICEINDEX_H
+#define SLICEINDEX_H
+
+#include <cstdint>
+#include <unordered_map>
+
+#include "standardincludes.h"
+
+class mzSlice;
+
+using namespace std;
+
+/**
+ * @class SliceIndex
+ * @ingroup libmaven
+ * @brief Spatial index over the m/z-rt bounds of slices.
+ * @details The m/z-rt plane is divided into a uniform grid of cells and every
+ * slice is registered with each cell that its bounds overlap. Finding the
+ * slices around a given area then only requires visiting the few cells that
+ * the area overlaps, regardless of how densely populated other regions of the
+ * plane are. Cell sizes are best chosen close to the typical extent of the
+ * indexed slices.
+ *
+ * Slices are referenced, not owned, and their bounds must not change while
+ * they are part of the index.
+ */
+class SliceIndex
+{
+public:
+    /**
+     * @brief Create an empty index.
+     * @param mzCellSize Width of a grid cell along the m/z axis.
+     * @param rtCellSize Width of a grid cell along the rt axis.
+     */
+    SliceIndex(float mzCellSize = 0.1f, float rtCellSize = 1.0f);
+
+    /**
+     * @brief Change the dimensions of the grid cells.
+     * @details Slices already present in the index are re-registered
+     * according to the new grid.
+     */
+    void setCellSize(float mzCellSize, float rtCellSize);
+
+    /**
+     * @brief Add a slice to the index.
+     */
+    void insert(mzSlice* slice);
+
+    /**
+     * @brief Remove all slices from the index.
+     */
+    void clear();
+
+    /**
+     * @brief Number of slices in the index.
+     */
+    size_t size() const { return _slices.size(); }
+
+    /**
+     * @brief Find all slices whose bounds overlap with the given area.
+     * @details Each slice is reported once. Slices are ordered by the grid
+     * cell in which they were found and, within a cell, by insertion order.
+     * @param mzmin Lower m/z bound of the area.
+     * @param mzmax Upper m/z bound of the area.
+     * @param rtmin Lower rt bound of the area.
+     * @param rtmax Upper rt bound of the area.
+     * @return A vector of overlapping slices.
+     */
+    vector<mzSlice*> query(float mzmin,
+                           float mzmax,
+                           float rtmin,
+                           float rtmax) const;
+
+private:
+    float _mzCellSize;
+    float _rtCellSize;
+    vector<mzSlice*> _slices;
+    unordered_map<uint64_t, vector<mzSlice*>> _cells;
+
+    int _mzCell(float mz) const;
+    int _rtCell(float rt) const;
+    static uint64_t _key(int mzCell, int rtCell);
+    void _register(mzSlice* slice);
+};
+
+#endif // SLICEINDEX_H
@@ -0,0 +1,35 @@
+#include "stringpool.h"
+
+const string& InternedString::_empty()
+{
+    static const string empty;
+    return empty;
+}
+
+InternedString StringPool::intern(const string& s)
+{
+    if (s.empty())
+        return InternedString();
+
+    // a non-owning pointer is enough to look the string up, which saves an
+    // allocation for every string that is already in the pool
+    shared_ptr<const string> key(shared_ptr<const string>(), &s);
+
+    lock_guard<mutex> lock(_mutex);
+    auto found = _strings.find(key);
+    if (found == _strings.end())
+        found = _strings.insert(make_shared<const string>(s)).first;
+    return InternedString(*found);
+}
+
+size_t StringPool::size() const
+{
+    lock_guard<mutex> lock(_mutex);
+    return _strings.size();
+}
+
+void StringPool::clear()
+{
+    lock_guard<mutex> lock(_mutex);
+    _strings.clear();
+}
@@ -0,0 +1,139 @@
+#ifndef STRINGPOOL_H
+#define STRINGPOOL_H
+
+#include <memory>
+#include <mutex>
+#include <unordered_set>
+
+#include "standardincludes.h"
+
+using namespace std;
+
+/**
+ * @class InternedString
+ * @ingroup libmaven
+ * @brief Immutable string whose storage is shared between all copies and,
+ * when it was obtained from a `StringPool`, between all equal strings
+ * interned in that pool.
+ * @details Behaves like a `const string` for reading: it converts implicitly
+ * to `const string&` and offers the accessors used on scan metadata. Strings
+ * assigned directly, rather than through a pool, are simply not shared with
+ * equal ones. The storage outlives the pool, so copies stay valid after the
+ * sample that interned them has been deleted.
+ */
+class InternedString
+{
+public:
+    InternedString() {}
+    InternedString(const string& s)
+        : _value(s.empty() ? nullptr : make_shared<const string>(s))
+    {
+    }
+    InternedString(const char* s) : InternedString(string(s)) {}
+
+    inline const string& str() const { return _value ? *_value : _empty(); }
+    inline operator const string&() const { return str(); }
+
+    inline const char* c_str() const { return str().c_str(); }
+    inline bool empty() const { return !_value; }
+    inline size_t size() const { return str().size(); }
+    inline size_t length() const { return str().length(); }
+    inline int compare(const string& s) const { return str().compare(s); }
+
+private:
+    friend class StringPool;
+
+    shared_ptr<const string> _value;
+
+    explicit InternedString(const shared_ptr<const string>& value)
+        : _value(value)
+    {
+    }
+
+    static const string& _empty();
+};
+
+inline bool operator==(const InternedString& a, const InternedString& b)
+{
+    return a.str() == b.str();
+}
+inline bool operator==(const InternedString& a, const string& b)
+{
+    return a.str() == b;
+}
+inline bool operator==(const string& a, const InternedString& b)
+{
+    return a == b.str();
+}
+inline bool operator==(const InternedString& a, const char* b)
+{
+    return a.str() == b;
+}
+inline bool operator!=(const InternedString& a, const InternedString& b)
+{
+    return !(a == b);
+}
+inline bool operator!=(const InternedString& a, const string& b)
+{
+    return !(a == b);
+}
+inline bool operator!=(const string& a, const InternedString& b)
+{
+    return !(a == b);
+}
+inline bool operator!=(const InternedString& a, const char* b)
+{
+    return !(a == b);
+}
+inline ostream& operator<<(ostream& out, const InternedString& s)
+{
+    return out << s.str();
+}
+
+/**
+ * @class StringPool
+ * @ingroup libmaven
+ * @brief Set of distinct strings handed out as `InternedString`s, so that
+ * metadata repeated across the scans of a sample (filter lines, scan types)
+ * is stored only once. Safe to use from several threads at once.
+ */
+class StringPool
+{
+public:
+    /**
+     * @brief Return the pooled copy of a string, adding it to the pool if
+     * no equal string has been interned before.
+     */
+    InternedString intern(const string& s);
+
+    /**
+     * @brief Number of distinct strings in the pool.
+     */
+    size_t size() const;
+
+    /**
+     * @brief Drop all strings from the pool. Strings handed out before
+     * remain valid, but are no longer shared with strings interned later.
+     */
+    void clear();
+
+private:
+    struct Hash {
+        size_t operator()(const shared_ptr<const string>& s) const
+        {
+            return hash<string>()(*s);
+        }
+    };
+    struct Equal {
+        bool operator()(const shared_ptr<const string>& a,
+                        const shared_ptr<const string>& b) const
+        {
+            return *a == *b;
+        }
+    };
+
+    mutable mutex _mutex;
+    unordered_set<shared_ptr<const string>, Hash, Equal> _strings;
+};
+
+#endif  // STRINGPOOL_H
@@ -0,0 +1,170 @@
+#include "xmlstreamreader.h"
+
+XmlStreamReader::XmlStreamReader(const char* filename, size_t chunkSize)
+    : _file(filename, ios::in | ios::binary),
+      _chunkSize(max(chunkSize, size_t(64))),
+      _bufferOffset(0),
+      _position(0),
+      _retainFrom(0),
+      _retaining(false)
+{
+}
+
+bool XmlStreamReader::nextTag(Tag& tag)
+{
+    while (true) {
+        size_t lt = _buffer.find('<', _position - _bufferOffset);
+        if (lt == string::npos) {
+            _position = _bufferOffset + _buffer.size();
+            if (!_fill(_position))
+                return false;
+            continue;
+        }
+        _position = _bufferOffset + lt;
+
+        size_t gt = 0;
+        if (!_findMarkupEnd(lt, gt)) {
+            if (!_fill(_position))
+                return false;
+            continue;
+        }
+        _position = _bufferOffset + gt + 1;
+
+        char first = _buffer[lt + 1];
+        if (first == '!' || first == '?')
+            continue;
+
+        tag.isEnd = (first == '/');
+        tag.isEmpty = !tag.isEnd && _buffer[gt - 1] == '/';
+        size_t nameBegin = tag.isEnd ? lt + 2 : lt + 1;
+        size_t nameEnd = _buffer.find_first_of(" \t\r\n/>", nameBegin);
+        tag.name.assign(_buffer, nameBegin, nameEnd - nameBegin);
+        tag.begin = _bufferOffset + lt;
+        tag.end = _position;
+        return true;
+    }
+}
+
+bool XmlStreamReader::readElement(const Tag& start, string& element)
+{
+    if (start.isEmpty) {
+        element = text(start.begin, start.end);
+        return true;
+    }
+
+    bool wasRetaining = _retaining;
+    size_t retainFrom = _retainFrom;
+    retain(start.begin);
+
+    int depth = 1;
+    Tag tag;
+    bool closed = false;
+    while (!closed && nextTag(tag)) {
+        if (tag.isEmpty || tag.name != start.name)
+            continue;
+        depth += tag.isEnd ? -1 : 1;
+        closed = (depth == 0);
+    }
+    if (closed)
+        element = text(start.begin, tag.end);
+
+    _retaining = wasRetaining;
+    _retainFrom = retainFrom;
+    return closed;
+}
+
+string XmlStreamReader::text(size_t begin, size_t end) const
+{
+    return _buffer.substr(begin - _bufferOffset, end - begin);
+}
+
+void XmlStreamReader::retain(size_t offset)
+{
+    _retainFrom = offset;
+    _retaining = true;
+}
+
+bool XmlStreamReader::_fill(size_t keepFrom)
+{
+    if (_retaining)
+        keepFrom = min(keepFrom, _retainFrom);
+
+    // drop text that is no longer needed before growing the buffer
+    if (keepFrom > _bufferOffset) {
+        _buffer.erase(0, keepFrom - _bufferOffset);
+        _bufferOffset = keepFrom;
+    }
+
+    if (!_file.is_open() || !_file.good())
+        return false;
+
+    size_t size = _buffer.size();
+    _buffer.resize(size + _chunkSize);
+    _file.read(&_buffer[size], _chunkSize);
+    _buffer.resize(size + _file.gcount());
+    return _buffer.size() > size;
+}
+
+bool XmlStreamReader::_findMarkupEnd(size_t begin, size_t& end) const
+{
+    // returns false if the markup does not end within the buffer
+    auto startsWith = [&](const char* prefix, size_t length) {
+        return _buffer.compare(begin, length, prefix) == 0;
+    };
+    size_t available = _buffer.size() - begin;
+
+    if (available < 2)
+        return false;
+
+    if (_buffer[begin + 1] == '!') {
+        if (available < 4)
+            return false;
+        if (available < 9
+            && _buffer.compare(begin, available, "<![CDATA[", available) == 0)
+            return false;
+        if (startsWith("<!--", 4)) {
+            end = _buffer.find("-->", begin + 4);
+            if (end == string::npos)
+                return false;
+            end += 2;
+            return true;
+        }
+        if (startsWith("<![CDATA[", 9)) {
+            end = _buffer.find("]]>", begin + 9);
+            if (end == string::npos)
+                return false;
+            end += 2;
+            return true;
+        }
+    }
+
+    if (_buffer[begin + 1] == '?') {
+        end = _buffer.find("?>", begin + 2);
+        if (end == string::npos)
+            return false;
+        end += 1;
+        return true;
+    }
+
+    // attribute values may contain '>', and a document type declaration may
+    // contain an internal subset in brackets
+    char quote = 0;
+    int brackets = 0;
+    for (size_t i = begin + 1; i < _buffer.size(); i++) {
+        char c = _buffer[i];
+        if (quote) {
+            if (c == quote)
+                quote = 0;
+        } else if (c == '"' || c == '\'') {
+            quote = c;
+        } else if (c == '[') {
+            brackets++;
+        } else if (c == ']') {
+            brackets--;
+        } else if (c == '>' && brackets <= 0) {
+            end = i;
+            return true;
+        }
+    }
+    return false;
+}
@@ -0,0 +1,97 @@
+#ifndef XMLSTREAMREADER_H
+#define XMLSTREAMREADER_H
+
+#include "standardincludes.h"
+
+using namespace std;
+
+/**
+ * @class XmlStreamReader
+ * @ingroup libmaven
+ * @brief Incremental reader that walks over the tags of an XML file.
+ * @details The file is read in chunks of fixed size and only the part that
+ * has not been consumed yet is kept in memory, unless the caller asks for a
+ * region to be retained (for example, to hand a complete element over to a
+ * DOM parser). Comments, processing instructions, CDATA sections and
+ * document type declarations are skipped. Character data is not reported, but
+ * can be recovered from the offsets of the surrounding tags.
+ */
+class XmlStreamReader
+{
+public:
+    /**
+     * @brief A start, end or empty-element tag, as found in the file.
+     */
+    struct Tag {
+        string name;
+        bool isEnd;
+        bool isEmpty;
+        size_t begin;  // file offset of the opening '<'
+        size_t end;    // file offset just past the closing '>'
+    };
+
+    /**
+     * @brief Open a file for reading.
+     * @param filename Path of the XML file.
+     * @param chunkSize Number of bytes read from the file at a time.
+     */
+    XmlStreamReader(const char* filename, size_t chunkSize = 1 << 20);
+
+    /**
+     * @brief Whether the file could be opened.
+     */
+    bool isOpen() const { return _file.is_open(); }
+
+    /**
+     * @brief Advance to the next tag in the file.
+     * @param tag Filled with the tag that was found.
+     * @return False if the end of the file was reached before another
+     * complete tag could be read.
+     */
+    bool nextTag(Tag& tag);
+
+    /**
+     * @brief Read the remainder of an element whose start tag has just been
+     * returned by `nextTag`.
+     * @details Elements of the same name nested within it are accounted for.
+     * The reader is left positioned after the end tag of the element.
+     * @param start The start tag of the element.
+     * @param element Filled with the raw text of the element, from its start
+     * tag to its end tag, inclusive.
+     * @return False if the file ended before the element was closed.
+     */
+    bool readElement(const Tag& start, string& element);
+
+    /**
+     * @brief Raw text between two file offsets.
+     * @details The text must still be held in memory, i.e., it should either
+     * span the last tag returned or lie after an offset passed to `retain`.
+     */
+    string text(size_t begin, size_t end) const;
+
+    /**
+     * @brief Keep all text from the given file offset onwards in memory
+     * until `release` is called.
+     * @param offset A file offset not before the last tag returned.
+     */
+    void retain(size_t offset);
+
+    /**
+     * @brief Allow text that has already been read to be discarded again.
+     */
+    void release() { _retaining = false; }
+
+private:
+    ifstream _file;
+    size_t _chunkSize;
+    string _buffer;
+    size_t _bufferOffset;
+    size_t _position;
+    size_t _retainFrom;
+    bool _retaining;
+
+    bool _fill(size_t keepFrom);
+    bool _findMarkupEnd(size_t begin, size_t& end) const;
+};
+
+#endif // XMLSTREAMREADER_H
@@ -2258,31 +2258,29 @@ void EicWidget::addMS2Events(float mzmin, float mzmax)
     mw->fragPanel->clearTree();
 
     int count = 0;
+    mzSlice precursorSlice(mzmin, mzmax, -FLT_MAX, FLT_MAX);
     for (auto const& sample : samples) {
         if (sample->ms1ScanCount() == 0) continue;
-        for (auto const& scan : sample->scans) {
-            if (scan->mslevel == 2 && scan->precursorMz >= mzmin
-                && scan->precursorMz <= mzmax) {
-                mw->fragPanel->addScanItem(scan);
-                if (scan->rt < eicParameters->_slice.rtmin
-                    || scan->rt > eicParameters->_slice.rtmax) {
-                    continue;
-                }
-
-                QColor color = QColor::fromRgbF(
-                    sample->color[0], sample->color[1], sample->color[2], 1);
-                EicPoint* p =
-                    new EicPoint(toX(scan->rt), toY(10), NULL, getMainWindow());
-                p->setPointShape(EicPoint::TRIANGLE_UP);
-                p->forceFillColor(true);
-                p->setScan(scan);
-                p->setSize(30);
-                p->setColor(color);
-                p->setZValue(1000);
-                p->setPeakGroup(NULL);
-                scene()->addItem(p);
-                count++;
+        for (auto const& scan : sample->getFragmentationEvents(&precursorSlice)) {
+            mw->fragPanel->addScanItem(scan);
+            if (scan->rt < eicParameters->_slice.rtmin
+                || scan->rt > eicParameters->_slice.rtmax) {
+                continue;
             }
+
+            QColor color = QColor::fromRgbF(
+                sample->color[0], sample->color[1], sample->color[2], 1);
+            EicPoint* p =
+                new EicPoint(toX(scan->rt), toY(10), NULL, getMainWindow());
+            p->setPointShape(EicPoint::TRIANGLE_UP);
+            p->forceFillColor(true);
+            p->setScan(scan);
+            p->setSize(30);
+            p->setColor(color);
+            p->setZValue(1000);
+            p->setPeakGroup(NULL);
+            scene()->addItem(p);
+            count++;
         }
     }
 
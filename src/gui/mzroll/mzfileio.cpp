@@ -814,17 +814,29 @@ bool mzFileIO::writeSQLiteProject(QString filename)
     }
 
     if (_currentProject) {
-        _currentProject->deleteAll();  // this is crazy
+        // peak groups saved earlier through the open project are updated in
+        // place, only the (much smaller) remaining tables are rewritten
+        auto incremental = projectIsAlreadyOpen
+                           && _currentProject->canSaveIncrementally();
+        if (incremental) {
+            qDebug() << "updating changed groups only…";
+            _currentProject->deleteAllSamples();
+            _currentProject->deleteAllCompounds();
+            _currentProject->deleteSettings();
+        } else {
+            _currentProject->deleteAll();
+        }
         _currentProject->saveSettings(_settingsMap);
         _currentProject->saveSamples(sampleSet);
         _currentProject->saveAlignment(sampleSet);
 
-        vector<PeakGroup*> groupVector;
+        vector<pair<string, vector<PeakGroup*>>> groupTables;
         set<Compound*> compoundSet;
         int topLevelGroupCount = 0;
         auto allTablesList = _mainwindow->getPeakTableList();
         allTablesList.push_back(_mainwindow->bookmarkedPeaks);
         for (const auto& peakTable : allTablesList) {
+            vector<PeakGroup*> groupVector;
             for (PeakGroup* group : peakTable->getGroups()) {
                 topLevelGroupCount++;
                 groupVector.push_back(group);
@@ -833,8 +845,13 @@ bool mzFileIO::writeSQLiteProject(QString filename)
             }
             string tableName = peakTable->titlePeakTable
                                         ->text().toStdString();
-            _currentProject->saveGroups(groupVector, tableName);
-            groupVector.clear();
+            groupTables.push_back(make_pair(tableName, groupVector));
+        }
+        if (incremental) {
+            _currentProject->updateGroups(groupTables);
+        } else {
+            for (const auto& table : groupTables)
+                _currentProject->saveGroups(table.second, table.first);
         }
         _currentProject->saveCompounds(compoundSet);
         qDebug() << "finished writing to project" << filename;
@@ -842,7 +859,10 @@ bool mzFileIO::writeSQLiteProject(QString filename)
             Q_EMIT(updateStatusString(
                 QString("Project successfully saved to %1").arg(filename)
             ));
-        _currentProject->vacuum();
+
+        // repacking the whole file would cost more than the update itself
+        if (!incremental)
+            _currentProject->vacuum();
         return true;
     }
     qDebug() << "cannot write to closed project" << filename;
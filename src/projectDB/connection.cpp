@@ -57,6 +57,14 @@ bool Connection::vacuum()
 
 Cursor* Connection::prepare(const std::string& query)
 {
+    auto& preparedCursors = _preparedCursors[query];
+    for (auto cursor : preparedCursors) {
+        if (!cursor->_isBusy()) {
+            cursor->_reset();
+            return cursor;
+        }
+    }
+
     sqlite3_stmt* statement;
     int status = sqlite3_prepare_v2(_database,
                                     query.c_str(),
@@ -65,6 +73,10 @@ Cursor* Connection::prepare(const std::string& query)
                                     nullptr);
     auto cursor = new Cursor(statement);
     _cursors.push_back(cursor);
+
+    // a failed statement might compile later on, e.g. once a table exists
+    if (status == SQLITE_OK && statement != nullptr)
+        preparedCursors.push_back(cursor);
     return cursor;
 }
 
@@ -74,6 +86,11 @@ int Connection::lastInsertId()
     return static_cast<int>(lastRowId);
 }
 
+int Connection::totalChanges()
+{
+    return sqlite3_total_changes(_database);
+}
+
 std::string Connection::dbPath()
 {
     return _dbPath;
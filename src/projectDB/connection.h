@@ -2,6 +2,7 @@
 #define CONNECTION_H
 
 #include <iostream>
+#include <unordered_map>
 #include <vector>
 #include <sqlite3.h>
 
@@ -109,6 +110,11 @@ public:
     /**
      * @brief Prepare a SQL statement and return a Cursor ready to be
      * executed. See documentation of Cursor class for details.
+     * @details Statements are compiled only once per connection. If a Cursor
+     * for the same query was prepared earlier and is not in the middle of
+     * iterating over a result set, it is reset (clearing its bindings) and
+     * returned again. Callers therefore should not hold on to a Cursor while
+     * preparing the same query for another purpose.
      * @param query A SQL query as a standard string.
      * @return Pointer to a Cursor object that has to be executed/iterated upon.
      */
@@ -124,6 +130,13 @@ public:
      */
     int lastInsertId();
 
+    /**
+     * @brief Obtain the number of rows inserted, modified or deleted through
+     * this connection since it was opened.
+     * @return Total count of changed rows.
+     */
+    int totalChanges();
+
     /**
      * @brief Obtain the absolute path to the connected database.
      * @return Path as a string.
@@ -147,6 +160,12 @@ private:
      * connection and therefore should be deleted when this object is destroyed.
      */
     std::vector<Cursor*> _cursors;
+
+    /**
+     * @brief Cursors created for each prepared query, so that statements
+     * executed repeatedly do not have to be compiled (and stored) again.
+     */
+    std::unordered_map<std::string, std::vector<Cursor*>> _preparedCursors;
 };
 
 #endif // CONNECTION_H
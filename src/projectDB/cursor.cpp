@@ -22,20 +22,38 @@ bool Cursor::execute()
 bool Cursor::next()
 {
     int status = sqlite3_step(_statement);
-    _extractValues();
     return status == SQLITE_ROW;
 }
 
+int Cursor::parameterIndex(const std::string& param)
+{
+    if (_parameterIndices.empty()) {
+        int parameterCount = sqlite3_bind_parameter_count(_statement);
+        // parameter indexing goes from 1 to parameterCount
+        for (int i = 1; i <= parameterCount; ++i) {
+            auto name = sqlite3_bind_parameter_name(_statement, i);
+            // nameless parameters cannot be bound by name
+            if (!name)
+                continue;
+
+            _parameterIndices.insert(std::make_pair(std::string(name), i));
+        }
+    }
+
+    auto found = _parameterIndices.find(param);
+    if (found == _parameterIndices.end())
+        return 0;
+    return found->second;
+}
+
 bool Cursor::bind(const std::string& param, int value)
 {
-    int index = sqlite3_bind_parameter_index(_statement, param.c_str());
-    return sqlite3_bind_int(_statement, index, value) == SQLITE_OK;
+    return bind(parameterIndex(param), value);
 }
 
 bool Cursor::bind(const std::string& param, double value)
 {
-    int index = sqlite3_bind_parameter_index(_statement, param.c_str());
-    return sqlite3_bind_double(_statement, index, value) == SQLITE_OK;
+    return bind(parameterIndex(param), value);
 }
 
 bool Cursor::bind(const std::string& param, float value)
@@ -46,7 +64,27 @@ bool Cursor::bind(const std::string& param, float value)
 
 bool Cursor::bind(const std::string& param, const std::string value)
 {
-    int index = sqlite3_bind_parameter_index(_statement, param.c_str());
+    return bind(parameterIndex(param), value);
+}
+
+bool Cursor::bind(int index, int value)
+{
+    return sqlite3_bind_int(_statement, index, value) == SQLITE_OK;
+}
+
+bool Cursor::bind(int index, double value)
+{
+    return sqlite3_bind_double(_statement, index, value) == SQLITE_OK;
+}
+
+bool Cursor::bind(int index, float value)
+{
+    auto dval = static_cast<double>(value);
+    return this->bind(index, dval);
+}
+
+bool Cursor::bind(int index, const std::string& value)
+{
     return sqlite3_bind_text(_statement,
                              index,
                              value.c_str(),
@@ -54,56 +92,131 @@ bool Cursor::bind(const std::string& param, const std::string value)
                              SQLITE_TRANSIENT) == SQLITE_OK;
 }
 
+bool Cursor::bindBlob(const std::string& param, const std::string& value)
+{
+    return bindBlob(parameterIndex(param), value);
+}
+
+bool Cursor::bindBlob(int index, const std::string& value)
+{
+    return sqlite3_bind_blob(_statement,
+                             index,
+                             value.data(),
+                             static_cast<int>(value.size()),
+                             SQLITE_TRANSIENT) == SQLITE_OK;
+}
+
+int Cursor::columnIndex(const std::string& column)
+{
+    if (_columnIndices.empty()) {
+        int columnCount = sqlite3_column_count(_statement);
+        for (int i = 0; i < columnCount; ++i) {
+            auto name = sqlite3_column_name(_statement, i);
+            // if name was pointing to NULL
+            if (!name)
+                name = "";
+
+            // for repeated names, the first column is the one referred to
+            _columnIndices.insert(std::make_pair(std::string(name), i));
+        }
+    }
+
+    auto found = _columnIndices.find(column);
+    if (found == _columnIndices.end())
+        return -1;
+    return found->second;
+}
+
 int Cursor::integerValue(const std::string& param)
 {
-    auto val = _currentResult[param];
-    if (val.empty())
-        return 0;
-    return std::stoi(val);
+    return integerValue(columnIndex(param));
 }
 
 double Cursor::doubleValue(const std::string& param)
 {
-    auto val = _currentResult[param];
-    if (val.empty())
-        return 0.0;
-    return std::stod(_currentResult[param]);
+    return doubleValue(columnIndex(param));
 }
 
 float Cursor::floatValue(const std::string& param)
 {
-    double dval = doubleValue(param);
-    return static_cast<float>(dval);
+    return floatValue(columnIndex(param));
 }
 
 std::string Cursor::stringValue(const std::string& param)
 {
-    return _currentResult[param];
+    return stringValue(columnIndex(param));
 }
 
-void Cursor::_extractValues()
+std::string Cursor::blobValue(const std::string& param)
 {
-    _currentResult.clear();
-    int valueCount = sqlite3_data_count(_statement);
+    return blobValue(columnIndex(param));
+}
 
-    while (valueCount) {
-        // column indexing goes from 0 to (valueCount - 1), so decrement first
-        --valueCount;
+int Cursor::integerValue(int column)
+{
+    if (!_hasColumn(column))
+        return 0;
+    return sqlite3_column_int(_statement, column);
+}
 
-        auto param =
-            reinterpret_cast<const char*>(sqlite3_column_name(_statement,
-                                                              valueCount));
-        // if param was pointing to NULL
-        if (!param)
-            param = "";
+double Cursor::doubleValue(int column)
+{
+    if (!_hasColumn(column))
+        return 0.0;
+    return sqlite3_column_double(_statement, column);
+}
+
+float Cursor::floatValue(int column)
+{
+    double dval = doubleValue(column);
+    return static_cast<float>(dval);
+}
 
-        auto value =
-            reinterpret_cast<const char*>(sqlite3_column_text(_statement,
-                                                              valueCount));
-        // if value was pointing to NULL
-        if (!value)
-            value = "";
+std::string Cursor::stringValue(int column)
+{
+    if (!_hasColumn(column))
+        return "";
 
-        _currentResult[param] = value;
-    }
+    auto value =
+        reinterpret_cast<const char*>(sqlite3_column_text(_statement, column));
+    // if value was pointing to NULL
+    if (!value)
+        return "";
+
+    // the text is owned by the statement, so it is copied exactly once
+    return std::string(value, sqlite3_column_bytes(_statement, column));
+}
+
+std::string Cursor::blobValue(int column)
+{
+    if (!_hasColumn(column))
+        return "";
+
+    auto value = static_cast<const char*>(sqlite3_column_blob(_statement,
+                                                              column));
+    if (!value)
+        return "";
+
+    return std::string(value, sqlite3_column_bytes(_statement, column));
+}
+
+bool Cursor::_hasColumn(int column)
+{
+    // no values are available unless the statement stopped at a row
+    return column >= 0 && column < sqlite3_data_count(_statement);
+}
+
+bool Cursor::_isBusy()
+{
+    return sqlite3_stmt_busy(_statement) != 0;
+}
+
+void Cursor::_reset()
+{
+    sqlite3_reset(_statement);
+    sqlite3_clear_bindings(_statement);
+
+    // a statement is compiled again if the schema changed, possibly with
+    // different result columns
+    _columnIndices.clear();
 }
@@ -2,7 +2,7 @@
 #define CURSOR_H
 
 #include <iostream>
-#include <map>
+#include <unordered_map>
 #include <sqlite3.h>
 
 class Connection;
@@ -40,12 +40,24 @@ public:
      * @details While this method, like `execute` also uses the "step" SQLite
      * function, its semantically meant to be used for iterating over rows
      * returned from a suitable SQL operation (most commonly SELECT statements).
-     * Moreover, the `_extracValues` method is called to extract values stored
-     * in current row of the result set.
+     * Values of the current row are read directly from the statement, in
+     * their native SQLite types, when any of the value methods is called.
      * @return True if the `next` method can be further called upon this Cursor.
      */
     bool next();
 
+    /**
+     * @brief Obtain the index of a named parameter, to be used with the bind
+     * methods that take a parameter index.
+     * @details Parameter names are looked up once per statement, so binding
+     * by name is cheap as well. Binding by index additionally saves that
+     * lookup when a statement is executed for many rows.
+     * @param param Name of the parameter (including its prefix, e.g. ':').
+     * @return Index of the parameter, or 0 if the statement has no parameter
+     * with this name.
+     */
+    int parameterIndex(const std::string& param);
+
     /**
      * @brief Bind integer value for statement with named parameter.
      * @param param Name of the parameter to be bound.
@@ -78,6 +90,65 @@ public:
      */
     bool bind(const std::string& param, const std::string value);
 
+    /**
+     * @brief Bind integer value for the parameter at the given index.
+     * @param index Index of the parameter, as returned by `parameterIndex`.
+     * @param value Value as an integer to be bound for the parameter.
+     * @return True if value was successfully bound.
+     */
+    bool bind(int index, int value);
+
+    /**
+     * @brief Bind double precision value for the parameter at the given index.
+     * @param index Index of the parameter, as returned by `parameterIndex`.
+     * @param value Value as a double to be bound for the parameter.
+     * @return True if value was successfully bound.
+     */
+    bool bind(int index, double value);
+
+    /**
+     * @brief Bind floating point value for the parameter at the given index.
+     * @param index Index of the parameter, as returned by `parameterIndex`.
+     * @param value Value as a floating point to be bound for the parameter.
+     * @return True if value was successfully bound.
+     */
+    bool bind(int index, float value);
+
+    /**
+     * @brief Bind string value for the parameter at the given index.
+     * @param index Index of the parameter, as returned by `parameterIndex`.
+     * @param value String value to be bound for the parameter.
+     * @return True if value was successfully bound.
+     */
+    bool bind(int index, const std::string& value);
+
+    /**
+     * @brief Bind binary data for statement with given named parameter.
+     * @param param Name of the parameter to be bound.
+     * @param value Bytes to be bound for the parameter, as a BLOB.
+     * @return True if value was successfully bound.
+     */
+    bool bindBlob(const std::string& param, const std::string& value);
+
+    /**
+     * @brief Bind binary data for the parameter at the given index.
+     * @param index Index of the parameter, as returned by `parameterIndex`.
+     * @param value Bytes to be bound for the parameter, as a BLOB.
+     * @return True if value was successfully bound.
+     */
+    bool bindBlob(int index, const std::string& value);
+
+    /**
+     * @brief Obtain the index of a result column, to be used with the value
+     * methods that take a column index.
+     * @details Column names are looked up once per statement. Resolving the
+     * indices of all needed columns before iterating over a large result set
+     * saves a name lookup for every value read.
+     * @param column Name of the column (or its alias in the query).
+     * @return Index of the column, or -1 if the result has no such column.
+     */
+    int columnIndex(const std::string& column);
+
     /**
      * @brief Obtain values for integers in the form of a int type.
      * @param param Name of parameter whose value is needed.
@@ -106,6 +177,53 @@ public:
      */
     std::string stringValue(const std::string& param);
 
+    /**
+     * @brief Obtain binary values in the form of a string of bytes.
+     * @param param Name of parameter whose value is needed.
+     * @return Bytes of the value, which may contain null characters.
+     */
+    std::string blobValue(const std::string& param);
+
+    /**
+     * @brief Obtain the value of a column of the current row as an integer.
+     * @param column Index of the column, as returned by `columnIndex`.
+     * @return Value of the column converted to integer, 0 if it is NULL or
+     * the index is invalid.
+     */
+    int integerValue(int column);
+
+    /**
+     * @brief Obtain the value of a column of the current row as a double.
+     * @param column Index of the column, as returned by `columnIndex`.
+     * @return Value of the column converted to double, 0 if it is NULL or
+     * the index is invalid.
+     */
+    double doubleValue(int column);
+
+    /**
+     * @brief Obtain the value of a column of the current row as a float.
+     * @param column Index of the column, as returned by `columnIndex`.
+     * @return Value of the column converted to float, 0 if it is NULL or
+     * the index is invalid.
+     */
+    float floatValue(int column);
+
+    /**
+     * @brief Obtain the value of a column of the current row as a string.
+     * @param column Index of the column, as returned by `columnIndex`.
+     * @return Value of the column converted to string, empty if it is NULL
+     * or the index is invalid.
+     */
+    std::string stringValue(int column);
+
+    /**
+     * @brief Obtain the value of a column of the current row as raw bytes.
+     * @param column Index of the column, as returned by `columnIndex`.
+     * @return Bytes of the value, empty if it is NULL or the index is
+     * invalid.
+     */
+    std::string blobValue(int column);
+
 private:
     /**
      * @brief A pointer to the sqlite3_stmt construct represented by the class.
@@ -113,10 +231,16 @@ private:
     sqlite3_stmt* _statement;
 
     /**
-     * @brief A map storing values for the current result, in case the query
-     * is of a row returning type (i.e., "SELECT" statements).
+     * @brief Indices of the result columns, keyed by column name. Filled on
+     * the first lookup of a column name.
      */
-    std::map<std::string, std::string> _currentResult;
+    std::unordered_map<std::string, int> _columnIndices;
+
+    /**
+     * @brief Indices of the statement parameters, keyed by parameter name.
+     * Filled on the first lookup of a parameter name.
+     */
+    std::unordered_map<std::string, int> _parameterIndices;
 
     /**
      * @brief Constructor that can only be accessed by friend classes.
@@ -138,13 +262,22 @@ private:
     ~Cursor();
 
     /**
-     * @brief Extract values from the current iteration of result set and store
-     * it in `_currentResult` as a mapping of parameter names to their values
-     * as strings. These values are converted to the corresponding type when
-     * any of the `integerValue`, `doubleValue`, `floatValue` or `stringValue`
-     * methods are called.
+     * @brief Check whether the given index refers to a column of the current
+     * row of the result set.
+     */
+    bool _hasColumn(int column);
+
+    /**
+     * @brief Check whether the statement is in the middle of returning rows
+     * and therefore cannot be reused yet.
+     */
+    bool _isBusy();
+
+    /**
+     * @brief Reset the statement and clear its bindings, so that it can be
+     * executed again as if it had just been prepared.
      */
-    void _extractValues();
+    void _reset();
 };
 
 #endif // CURSOR_H
@@ -107,26 +107,40 @@ void MzrollDbConverter::copySamples(Connection &mzrollDb, Connection &emDb)
 
 void MzrollDbConverter::copyScans(Connection &mzrollDb, Connection &emDb)
 {
-    if(!emDb.prepare(CREATE_SCANS_TABLE)->execute()) {
+    // converted files are stamped with DB version 1, whose scans table holds
+    // text, as mzroll scan data does
+    if(!emDb.prepare(CREATE_SCANS_TABLE_V4)->execute()) {
         cerr << "Error: failed to create scans table" << endl;
         return;
     }
 
     auto writeQuery = emDb.prepare(
-        "INSERT INTO scans               \
-              VALUES ( :sample_id        \
-                     , :scan             \
-                     , :file_seek_start  \
-                     , :file_seek_end    \
-                     , :mslevel          \
-                     , :rt               \
-                     , :precursor_mz     \
-                     , :precursor_charge \
-                     , :precursor_ic     \
-                     , :precursor_purity \
-                     , :minmz            \
-                     , :maxmz            \
-                     , :data             )");
+        "INSERT INTO scans ( sample_id        \
+                           , scan             \
+                           , file_seek_start  \
+                           , file_seek_end    \
+                           , mslevel          \
+                           , rt               \
+                           , precursor_mz     \
+                           , precursor_charge \
+                           , precursor_ic     \
+                           , precursor_purity \
+                           , minmz            \
+                           , maxmz            \
+                           , data             )\
+                    VALUES ( :sample_id        \
+                           , :scan             \
+                           , :file_seek_start  \
+                           , :file_seek_end    \
+                           , :mslevel          \
+                           , :rt               \
+                           , :precursor_mz     \
+                           , :precursor_charge \
+                           , :precursor_ic     \
+                           , :precursor_purity \
+                           , :minmz            \
+                           , :maxmz            \
+                           , :data             )");
 
     auto readQuery = mzrollDb.prepare("SELECT *     \
                                          FROM scans ");
@@ -8,6 +8,8 @@ TARGET = projectDB
 CONFIG += xml console staticlib warn_off
 
 QMAKE_CXXFLAGS += -std=c++11
+QMAKE_CXXFLAGS += -DOMP_PARALLEL
+QMAKE_CXXFLAGS += -fopenmp
 
 INCLUDEPATH += $$top_srcdir/src/core/libmaven \
                $$top_srcdir/3rdparty/obiwarp   \
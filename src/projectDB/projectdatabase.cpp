@@ -1,6 +1,10 @@
+#include <chrono>
+#include <memory>
 #include <sstream>
 #include <unordered_map>
+#include <unordered_set>
 #include <boost/filesystem.hpp>
+#include <boost/functional/hash.hpp>
 #include "projectdatabase.h"
 #include "Compound.h"
 #include "connection.h"
@@ -11,6 +15,7 @@
 #include "mzSample.h"
 #include "projectversioning.h"
 #include "Scan.h"
+#include "scanloader.h"
 #include "schema.h"
 
 #define BINT(x) boost::get<int>(x)
@@ -22,6 +27,7 @@ ProjectDatabase::ProjectDatabase(const string& dbFilename,
                                  const string& version)
 {
     _connection = new Connection(dbFilename);
+    _savedRevision = -1;
 
     // figure out whether this database needs upgrade
     using namespace ProjectVersioning;
@@ -133,17 +139,54 @@ void ProjectDatabase::saveSamples(const vector<mzSample*>& samples)
 void ProjectDatabase::saveGroups(const vector<PeakGroup*>& groups,
                                  const string& tableName)
 {
+    if (!_createGroupTables())
+        return;
+
+    auto startTime = chrono::steady_clock::now();
+    int changesBefore = _connection->totalChanges();
+
     _connection->begin();
 
     for (const auto group : groups)
-        saveGroupAndPeaks(group, 0, tableName);
+        _saveAndTrackGroup(group, tableName);
 
+    int rowCount = _connection->totalChanges() - changesBefore;
+    _commitRevision();
     _connection->commit();
+
+    chrono::duration<double> elapsed = chrono::steady_clock::now() - startTime;
+    cerr << "Debug: Saved "
+         << rowCount
+         << " group and peak rows in "
+         << elapsed.count()
+         << "s ("
+         << static_cast<int>(rowCount / max(elapsed.count(), 1e-6))
+         << " rows/sec)"
+         << endl;
 }
 
 int ProjectDatabase::saveGroupAndPeaks(PeakGroup* group,
                                        const int parentGroupId,
                                        const string& tableName)
+{
+    if (!_createGroupTables())
+        return -1;
+
+    if (parentGroupId != 0) {
+        // the saved state of the parent group is no longer known
+        _forgetSavedGroups();
+        return _saveGroupAndPeaks(group, parentGroupId, tableName);
+    }
+
+    int databaseId = _saveAndTrackGroup(group, tableName);
+    _commitRevision();
+    return databaseId;
+}
+
+int ProjectDatabase::_saveGroupAndPeaks(PeakGroup* group,
+                                        const int parentGroupId,
+                                        const string& tableName,
+                                        vector<int>* databaseIds)
 {
     if (!group)
         return -1;
@@ -152,11 +195,6 @@ int ProjectDatabase::saveGroupAndPeaks(PeakGroup* group,
     if (group->deletedFlag)
         return -1;
 
-    if (!_connection->prepare(CREATE_PEAK_GROUPS_TABLE)->execute()) {
-        cerr << "Error: failed to create peakgroups table" << endl;
-        return -1;
-    }
-
     auto groupsQuery = _connection->prepare(
         "INSERT INTO peakgroups                            \
               VALUES ( :group_id                           \
@@ -265,10 +303,16 @@ int ProjectDatabase::saveGroupAndPeaks(PeakGroup* group,
         cerr << "Error: failed to save peak group" << endl;
 
     int lastInsertedGroupId = _connection->lastInsertId();
-    saveGroupPeaks(group, lastInsertedGroupId);
-
-    for (auto child: group->children)
-        saveGroupAndPeaks(&child, lastInsertedGroupId, tableName);
+    if (databaseIds)
+        databaseIds->push_back(lastInsertedGroupId);
+    _saveGroupPeaks(group, lastInsertedGroupId);
+
+    for (auto& child: group->children) {
+        _saveGroupAndPeaks(&child,
+                           lastInsertedGroupId,
+                           tableName,
+                           databaseIds);
+    }
 
     return lastInsertedGroupId;
 }
@@ -280,6 +324,13 @@ void ProjectDatabase::saveGroupPeaks(PeakGroup* group, const int databaseId)
         return;
     }
 
+    // the saved state of this group is no longer known
+    _forgetSavedGroups();
+    _saveGroupPeaks(group, databaseId);
+}
+
+void ProjectDatabase::_saveGroupPeaks(PeakGroup* group, const int databaseId)
+{
     auto peaksQuery = _connection->prepare(
         "INSERT INTO peaks                      \
               VALUES ( :peak_id                 \
@@ -322,51 +373,160 @@ void ProjectDatabase::saveGroupPeaks(PeakGroup* group, const int databaseId)
                      , :label                   \
                      , :peak_spline_area        )");
 
-    for (Peak p : group->peaks) {
-        peaksQuery->bind(":group_id", databaseId);
-        peaksQuery->bind(":sample_id", p.getSample()->getSampleId());
-        peaksQuery->bind(":pos", static_cast<int>(p.pos));
-        peaksQuery->bind(":minpos", static_cast<int>(p.minpos));
-        peaksQuery->bind(":maxpos", static_cast<int>(p.maxpos));
-        peaksQuery->bind(":rt", p.rt);
-        peaksQuery->bind(":rtmin", p.rtmin);
-        peaksQuery->bind(":rtmax", p.rtmax);
-        peaksQuery->bind(":mzmin", p.mzmin);
-        peaksQuery->bind(":mzmax", p.mzmax);
-        peaksQuery->bind(":scan", static_cast<int>(p.scan));
-        peaksQuery->bind(":minscan", static_cast<int>(p.minscan));
-        peaksQuery->bind(":maxscan", static_cast<int>(p.maxscan));
-        peaksQuery->bind(":peak_area", p.peakArea);
-        peaksQuery->bind(":peak_spline_area", p.peakSplineArea);
-        peaksQuery->bind(":peak_area_corrected", p.peakAreaCorrected);
-        peaksQuery->bind(":peak_area_top", p.peakAreaTop);
-        peaksQuery->bind(":peak_area_top_corrected", p.peakAreaTopCorrected);
-        peaksQuery->bind(":peak_area_fractional", p.peakAreaFractional);
-        peaksQuery->bind(":peak_rank", p.peakRank);
-        peaksQuery->bind(":peak_intensity", p.peakIntensity);
-        peaksQuery->bind(":peak_baseline_level", p.peakBaseLineLevel);
-        peaksQuery->bind(":peak_mz", p.peakMz);
-        peaksQuery->bind(":median_mz", p.medianMz);
-        peaksQuery->bind(":base_mz", p.baseMz);
-        peaksQuery->bind(":quality", p.quality);
-        peaksQuery->bind(":width", static_cast<int>(p.width));
-        peaksQuery->bind(":gauss_fit_sigma", p.gaussFitSigma);
-        peaksQuery->bind(":gauss_fit_r2", p.gaussFitR2);
-        peaksQuery->bind(":no_noise_obs", static_cast<int>(p.noNoiseObs));
-        peaksQuery->bind(":no_noise_fraction", p.noNoiseFraction);
-        peaksQuery->bind(":symmetry", p.symmetry);
-        peaksQuery->bind(":signal_baseline_ratio", p.signalBaselineRatio);
-        peaksQuery->bind(":group_overlap", p.groupOverlap);
-        peaksQuery->bind(":group_overlap_frac", p.groupOverlapFrac);
-        peaksQuery->bind(":local_max_flag", p.localMaxFlag);
-        peaksQuery->bind(":from_blank_sample", p.fromBlankSample);
-        peaksQuery->bind(":label", string(1, p.label));
+    // the statement is executed for every peak, so bind by index
+    const int groupIdParam = peaksQuery->parameterIndex(":group_id");
+    const int sampleIdParam = peaksQuery->parameterIndex(":sample_id");
+    const int posParam = peaksQuery->parameterIndex(":pos");
+    const int minposParam = peaksQuery->parameterIndex(":minpos");
+    const int maxposParam = peaksQuery->parameterIndex(":maxpos");
+    const int rtParam = peaksQuery->parameterIndex(":rt");
+    const int rtminParam = peaksQuery->parameterIndex(":rtmin");
+    const int rtmaxParam = peaksQuery->parameterIndex(":rtmax");
+    const int mzminParam = peaksQuery->parameterIndex(":mzmin");
+    const int mzmaxParam = peaksQuery->parameterIndex(":mzmax");
+    const int scanParam = peaksQuery->parameterIndex(":scan");
+    const int minscanParam = peaksQuery->parameterIndex(":minscan");
+    const int maxscanParam = peaksQuery->parameterIndex(":maxscan");
+    const int peakAreaParam = peaksQuery->parameterIndex(":peak_area");
+    const int peakSplineAreaParam =
+        peaksQuery->parameterIndex(":peak_spline_area");
+    const int peakAreaCorrectedParam =
+        peaksQuery->parameterIndex(":peak_area_corrected");
+    const int peakAreaTopParam = peaksQuery->parameterIndex(":peak_area_top");
+    const int peakAreaTopCorrectedParam =
+        peaksQuery->parameterIndex(":peak_area_top_corrected");
+    const int peakAreaFractionalParam =
+        peaksQuery->parameterIndex(":peak_area_fractional");
+    const int peakRankParam = peaksQuery->parameterIndex(":peak_rank");
+    const int peakIntensityParam =
+        peaksQuery->parameterIndex(":peak_intensity");
+    const int peakBaselineLevelParam =
+        peaksQuery->parameterIndex(":peak_baseline_level");
+    const int peakMzParam = peaksQuery->parameterIndex(":peak_mz");
+    const int medianMzParam = peaksQuery->parameterIndex(":median_mz");
+    const int baseMzParam = peaksQuery->parameterIndex(":base_mz");
+    const int qualityParam = peaksQuery->parameterIndex(":quality");
+    const int widthParam = peaksQuery->parameterIndex(":width");
+    const int gaussFitSigmaParam =
+        peaksQuery->parameterIndex(":gauss_fit_sigma");
+    const int gaussFitR2Param = peaksQuery->parameterIndex(":gauss_fit_r2");
+    const int noNoiseObsParam = peaksQuery->parameterIndex(":no_noise_obs");
+    const int noNoiseFractionParam =
+        peaksQuery->parameterIndex(":no_noise_fraction");
+    const int symmetryParam = peaksQuery->parameterIndex(":symmetry");
+    const int signalBaselineRatioParam =
+        peaksQuery->parameterIndex(":signal_baseline_ratio");
+    const int groupOverlapParam = peaksQuery->parameterIndex(":group_overlap");
+    const int groupOverlapFracParam =
+        peaksQuery->parameterIndex(":group_overlap_frac");
+    const int localMaxFlagParam = peaksQuery->parameterIndex(":local_max_flag");
+    const int fromBlankSampleParam =
+        peaksQuery->parameterIndex(":from_blank_sample");
+    const int labelParam = peaksQuery->parameterIndex(":label");
+
+    for (Peak& p : group->peaks) {
+        peaksQuery->bind(groupIdParam, databaseId);
+        peaksQuery->bind(sampleIdParam, p.getSample()->getSampleId());
+        peaksQuery->bind(posParam, static_cast<int>(p.pos));
+        peaksQuery->bind(minposParam, static_cast<int>(p.minpos));
+        peaksQuery->bind(maxposParam, static_cast<int>(p.maxpos));
+        peaksQuery->bind(rtParam, p.rt);
+        peaksQuery->bind(rtminParam, p.rtmin);
+        peaksQuery->bind(rtmaxParam, p.rtmax);
+        peaksQuery->bind(mzminParam, p.mzmin);
+        peaksQuery->bind(mzmaxParam, p.mzmax);
+        peaksQuery->bind(scanParam, static_cast<int>(p.scan));
+        peaksQuery->bind(minscanParam, static_cast<int>(p.minscan));
+        peaksQuery->bind(maxscanParam, static_cast<int>(p.maxscan));
+        peaksQuery->bind(peakAreaParam, p.peakArea);
+        peaksQuery->bind(peakSplineAreaParam, p.peakSplineArea);
+        peaksQuery->bind(peakAreaCorrectedParam, p.peakAreaCorrected);
+        peaksQuery->bind(peakAreaTopParam, p.peakAreaTop);
+        peaksQuery->bind(peakAreaTopCorrectedParam, p.peakAreaTopCorrected);
+        peaksQuery->bind(peakAreaFractionalParam, p.peakAreaFractional);
+        peaksQuery->bind(peakRankParam, p.peakRank);
+        peaksQuery->bind(peakIntensityParam, p.peakIntensity);
+        peaksQuery->bind(peakBaselineLevelParam, p.peakBaseLineLevel);
+        peaksQuery->bind(peakMzParam, p.peakMz);
+        peaksQuery->bind(medianMzParam, p.medianMz);
+        peaksQuery->bind(baseMzParam, p.baseMz);
+        peaksQuery->bind(qualityParam, p.quality);
+        peaksQuery->bind(widthParam, static_cast<int>(p.width));
+        peaksQuery->bind(gaussFitSigmaParam, p.gaussFitSigma);
+        peaksQuery->bind(gaussFitR2Param, p.gaussFitR2);
+        peaksQuery->bind(noNoiseObsParam, static_cast<int>(p.noNoiseObs));
+        peaksQuery->bind(noNoiseFractionParam, p.noNoiseFraction);
+        peaksQuery->bind(symmetryParam, p.symmetry);
+        peaksQuery->bind(signalBaselineRatioParam, p.signalBaselineRatio);
+        peaksQuery->bind(groupOverlapParam, p.groupOverlap);
+        peaksQuery->bind(groupOverlapFracParam, p.groupOverlapFrac);
+        peaksQuery->bind(localMaxFlagParam, p.localMaxFlag);
+        peaksQuery->bind(fromBlankSampleParam, p.fromBlankSample);
+        peaksQuery->bind(labelParam, string(1, p.label));
 
         if (!peaksQuery->execute())
             cerr << "Error: failed to write peak" << endl;
     }
 }
 
+void ProjectDatabase::updateGroups(
+    const vector<pair<string, vector<PeakGroup*>>>& tables)
+{
+    if (!_createGroupTables())
+        return;
+
+    // saved groups are deleted by their IDs
+    _connection->prepare(CREATE_PEAKS_GROUP_INDEX)->execute();
+
+    auto startTime = chrono::steady_clock::now();
+    int changesBefore = _connection->totalChanges();
+
+    // groups left in here after the update are no longer part of any table
+    map<pair<string, int>, SavedGroup> previouslySaved;
+    previouslySaved.swap(_savedGroups);
+
+    _connection->begin();
+
+    int unchangedCount = 0;
+    for (const auto& table : tables) {
+        const string& tableName = table.first;
+        for (const auto group : table.second) {
+            if (!group || group->deletedFlag)
+                continue;
+
+            auto saved = previouslySaved.find(make_pair(tableName,
+                                                        group->groupId));
+            if (saved != previouslySaved.end()) {
+                if (saved->second.unique
+                    && saved->second.fingerprint
+                           == _groupFingerprint(group)) {
+                    _savedGroups.insert(*saved);
+                    previouslySaved.erase(saved);
+                    ++unchangedCount;
+                    continue;
+                }
+                _deleteSavedGroup(saved->second);
+                previouslySaved.erase(saved);
+            }
+            _saveAndTrackGroup(group, tableName);
+        }
+    }
+
+    for (const auto& saved : previouslySaved)
+        _deleteSavedGroup(saved.second);
+
+    int rowCount = _connection->totalChanges() - changesBefore;
+    _commitRevision();
+    _connection->commit();
+
+    chrono::duration<double> elapsed = chrono::steady_clock::now()
+                                       - startTime;
+    cerr << "Debug: Updated "
+         << rowCount
+         << " group and peak rows, keeping " << unchangedCount
+         << " unchanged groups, in " << elapsed.count() << "s" << endl;
+}
+
 void ProjectDatabase::saveCompounds(const vector<PeakGroup>& groups)
 {
     set<Compound*> seenCompounds;
@@ -537,36 +697,64 @@ void ProjectDatabase::saveScans(const vector<mzSample*>& sampleSet)
 {
     deleteAllScans();
 
-    if(!_connection->prepare(CREATE_SCANS_TABLE)->execute()) {
+    // scan data is tagged with its format from DB version 5 onwards, files
+    // stamped with an older version keep the older table, which holds text
+    bool tagged = version() >= 5;
+    auto createQuery = _connection->prepare(tagged ? CREATE_SCANS_TABLE
+                                                   : CREATE_SCANS_TABLE_V4);
+    if(!createQuery->execute()) {
         cerr << "Error: failed to create scans table" << endl;
         return;
     }
 
-    auto scansQuery = _connection->prepare(
-        "INSERT INTO scans               \
-              VALUES ( :sample_id        \
-                     , :scan             \
-                     , :file_seek_start  \
-                     , :file_seek_end    \
-                     , :mslevel          \
-                     , :rt               \
-                     , :precursor_mz     \
-                     , :precursor_charge \
-                     , :precursor_ic     \
-                     , :precursor_purity \
-                     , :minmz            \
-                     , :maxmz            \
-                     , :data             )");
+    string columns = "INSERT INTO scans ( sample_id        \
+                                        , scan             \
+                                        , file_seek_start  \
+                                        , file_seek_end    \
+                                        , mslevel          \
+                                        , rt               \
+                                        , precursor_mz     \
+                                        , precursor_charge \
+                                        , precursor_ic     \
+                                        , precursor_purity \
+                                        , minmz            \
+                                        , maxmz            \
+                                        , data             ";
+    string values = "             VALUES ( :sample_id        \
+                                        , :scan             \
+                                        , :file_seek_start  \
+                                        , :file_seek_end    \
+                                        , :mslevel          \
+                                        , :rt               \
+                                        , :precursor_mz     \
+                                        , :precursor_charge \
+                                        , :precursor_ic     \
+                                        , :precursor_purity \
+                                        , :minmz            \
+                                        , :maxmz            \
+                                        , :data             ";
+    if (tagged) {
+        columns += ", data_format ";
+        values += ", :data_format ";
+    }
+    auto scansQuery = _connection->prepare(columns + ")" + values + ")");
 
     _connection->begin();
 
     float ppm = 20;
     for (auto s : sampleSet) {
+        // precursor purity is read off the last full scan, keep it loaded
+        unique_ptr<ScanLoader::Pin> fullScanPin;
         for (auto scan : s->scans) {
-            if (scan->mslevel == 1)
+            if (scan->mslevel == 1) {
+                fullScanPin.reset(new ScanLoader::Pin(s->scanLoader(), scan));
                 continue;
+            }
+
+            ScanLoader::Pin pin(s->scanLoader(), scan);
 
-            string scanData = _getScanSignature(scan, 2000);
+            ScanDataFormat format;
+            string scanData = _packScanData(scan, 2000, tagged, format);
 
             scansQuery->bind(":sample_id", s->getSampleId());
             scansQuery->bind(":scan", scan->scannum);
@@ -580,7 +768,12 @@ void ProjectDatabase::saveScans(const vector<mzSample*>& sampleSet)
             scansQuery->bind(":precursor_purity", scan->getPrecursorPurity(ppm));
             scansQuery->bind(":minmz", scan->minMz());
             scansQuery->bind(":maxmz", scan->maxMz());
-            scansQuery->bind(":data", scanData.c_str());
+            if (tagged) {
+                scansQuery->bindBlob(":data", scanData);
+                scansQuery->bind(":data_format", static_cast<int>(format));
+            } else {
+                scansQuery->bind(":data", scanData);
+            }
 
             if (!scansQuery->execute())
                 cerr << "Error: failed to save scan" << endl;
@@ -903,133 +1096,221 @@ void ProjectDatabase::updateSamples(const vector<mzSample*> freshlyLoaded)
 
 vector<PeakGroup*> ProjectDatabase::loadGroups(const vector<mzSample*>& loaded)
 {
-    _connection->prepare(CREATE_PEAKS_GROUP_INDEX)->execute();
     auto groupsQuery = _connection->prepare("SELECT *         \
                                                FROM peakgroups");
 
     vector<PeakGroup*> groups;
-    map<int, PeakGroup*> databaseIdForGroups;
-    map<PeakGroup*, int> childParentMap;
+    vector<PeakGroup*> loadedGroups;
+    vector<pair<int, int>> childGroups;
+    unordered_map<int, PeakGroup*> databaseIdForGroups;
+
+    // samples, compounds and adducts are resolved once for each distinct
+    // value, instead of searching through all of them for every group
+    unordered_map<int, mzSample*> samplesById;
+    for (auto sample : loaded)
+        samplesById.emplace(sample->getSampleId(), sample);
+    unordered_map<string, Compound*> compoundsByKey;
+    unordered_map<string, Adduct*> adductsByName;
+
+    // resolve result columns once, rather than by name for every row
+    const int groupIdColumn = groupsQuery->columnIndex("group_id");
+    const int tableGroupIdColumn = groupsQuery->columnIndex("table_group_id");
+    const int parentGroupIdColumn = groupsQuery->columnIndex("parent_group_id");
+    const int tagStringColumn = groupsQuery->columnIndex("tag_string");
+    const int metaGroupIdColumn = groupsQuery->columnIndex("meta_group_id");
+    const int expectedMzColumn = groupsQuery->columnIndex("expected_mz");
+    const int expectedAbundanceColumn =
+        groupsQuery->columnIndex("expected_abundance");
+    const int groupRankColumn = groupsQuery->columnIndex("group_rank");
+    const int labelColumn = groupsQuery->columnIndex("label");
+    const int ms2EventCountColumn = groupsQuery->columnIndex("ms2_event_count");
+    const int ms2ScoreColumn = groupsQuery->columnIndex("ms2_score");
+    const int fragmentationFractionMatchedColumn =
+        groupsQuery->columnIndex("fragmentation_fraction_matched");
+    const int fragmentationMzFragErrorColumn =
+        groupsQuery->columnIndex("fragmentation_mz_frag_error");
+    const int fragmentationHypergeomScoreColumn =
+        groupsQuery->columnIndex("fragmentation_hypergeom_score");
+    const int fragmentationMvhScoreColumn =
+        groupsQuery->columnIndex("fragmentation_mvh_score");
+    const int fragmentationDotProductColumn =
+        groupsQuery->columnIndex("fragmentation_dot_product");
+    const int fragmentationWeightedDotProductColumn =
+        groupsQuery->columnIndex("fragmentation_weighted_dot_product");
+    const int fragmentationSpearmanRankCorrColumn =
+        groupsQuery->columnIndex("fragmentation_spearman_rank_corr");
+    const int fragmentationTicMatchedColumn =
+        groupsQuery->columnIndex("fragmentation_tic_matched");
+    const int fragmentationNumMatchesColumn =
+        groupsQuery->columnIndex("fragmentation_num_matches");
+    const int typeColumn = groupsQuery->columnIndex("type");
+    const int tableNameColumn = groupsQuery->columnIndex("table_name");
+    const int minQualityColumn = groupsQuery->columnIndex("min_quality");
+    const int compoundIdColumn = groupsQuery->columnIndex("compound_id");
+    const int compoundDbColumn = groupsQuery->columnIndex("compound_db");
+    const int compoundNameColumn = groupsQuery->columnIndex("compound_name");
+    const int adductNameColumn = groupsQuery->columnIndex("adduct_name");
+    const int srmIdColumn = groupsQuery->columnIndex("srm_id");
+    const int sampleIdsColumn = groupsQuery->columnIndex("sample_ids");
+    const int sliceMzMinColumn = groupsQuery->columnIndex("slice_mz_min");
+    const int sliceMzMaxColumn = groupsQuery->columnIndex("slice_mz_max");
+    const int sliceRtMinColumn = groupsQuery->columnIndex("slice_rt_min");
+    const int sliceRtMaxColumn = groupsQuery->columnIndex("slice_rt_max");
+    const int sliceIonCountColumn = groupsQuery->columnIndex("slice_ion_count");
+
     while (groupsQuery->next()) {
         PeakGroup* group = new PeakGroup();
-        int databaseId = groupsQuery->integerValue("group_id");
-        group->groupId = groupsQuery->integerValue("table_group_id");
-        int parentGroupId = groupsQuery->integerValue("parent_group_id");
-        group->tagString = groupsQuery->stringValue("tag_string");
-        group->metaGroupId = groupsQuery->integerValue("meta_group_id");
-        group->expectedMz = groupsQuery->floatValue("expected_mz");
+        int databaseId = groupsQuery->integerValue(groupIdColumn);
+        group->groupId = groupsQuery->integerValue(tableGroupIdColumn);
+        int parentGroupId = groupsQuery->integerValue(parentGroupIdColumn);
+        group->tagString = groupsQuery->stringValue(tagStringColumn);
+        group->metaGroupId = groupsQuery->integerValue(metaGroupIdColumn);
+        group->expectedMz = groupsQuery->floatValue(expectedMzColumn);
         group->expectedAbundance =
-            groupsQuery->floatValue("expected_abundance");
-        group->groupRank = groupsQuery->floatValue("group_rank");
-        group->label = groupsQuery->stringValue("label")[0];
-        group->ms2EventCount = groupsQuery->integerValue("ms2_event_count");
+            groupsQuery->floatValue(expectedAbundanceColumn);
+        group->groupRank = groupsQuery->floatValue(groupRankColumn);
+        group->label = groupsQuery->stringValue(labelColumn)[0];
+        group->ms2EventCount = groupsQuery->integerValue(ms2EventCountColumn);
         group->fragMatchScore.mergedScore =
-            groupsQuery->doubleValue("ms2_score");
+            groupsQuery->doubleValue(ms2ScoreColumn);
         group->fragMatchScore.fractionMatched =
-            groupsQuery->doubleValue("fragmentation_fraction_matched");
+            groupsQuery->doubleValue(fragmentationFractionMatchedColumn);
         group->fragMatchScore.mzFragError =
-            groupsQuery->doubleValue("fragmentation_mz_frag_error");
+            groupsQuery->doubleValue(fragmentationMzFragErrorColumn);
         group->fragMatchScore.hypergeomScore =
-            groupsQuery->doubleValue("fragmentation_hypergeom_score");
+            groupsQuery->doubleValue(fragmentationHypergeomScoreColumn);
         group->fragMatchScore.mvhScore =
-            groupsQuery->doubleValue("fragmentation_mvh_score");
+            groupsQuery->doubleValue(fragmentationMvhScoreColumn);
         group->fragMatchScore.dotProduct =
-            groupsQuery->doubleValue("fragmentation_dot_product");
+            groupsQuery->doubleValue(fragmentationDotProductColumn);
         group->fragMatchScore.weightedDotProduct =
-            groupsQuery->doubleValue("fragmentation_weighted_dot_product");
+            groupsQuery->doubleValue(fragmentationWeightedDotProductColumn);
         group->fragMatchScore.spearmanRankCorrelation =
-            groupsQuery->doubleValue("fragmentation_spearman_rank_corr");
+            groupsQuery->doubleValue(fragmentationSpearmanRankCorrColumn);
         group->fragMatchScore.ticMatched =
-            groupsQuery->doubleValue("fragmentation_tic_matched");
+            groupsQuery->doubleValue(fragmentationTicMatchedColumn);
         group->fragMatchScore.numMatches =
-            groupsQuery->doubleValue("fragmentation_num_matches");
+            groupsQuery->doubleValue(fragmentationNumMatchesColumn);
 
-        group->setType(static_cast<PeakGroup::GroupType>(groupsQuery->integerValue("type")));
-        group->setTableName(groupsQuery->stringValue("table_name"));
-        group->minQuality = groupsQuery->doubleValue("min_quality");
+        group->setType(static_cast<PeakGroup::GroupType>(groupsQuery->integerValue(typeColumn)));
+        group->setTableName(groupsQuery->stringValue(tableNameColumn));
+        group->minQuality = groupsQuery->doubleValue(minQualityColumn);
 
-        string compoundId = groupsQuery->stringValue("compound_id");
-        string compoundDB = groupsQuery->stringValue("compound_db");
-        string compoundName = groupsQuery->stringValue("compound_name");
-        string adductName = groupsQuery->stringValue("adduct_name");
+        string compoundId = groupsQuery->stringValue(compoundIdColumn);
+        string compoundDB = groupsQuery->stringValue(compoundDbColumn);
+        string compoundName = groupsQuery->stringValue(compoundNameColumn);
+        string adductName = groupsQuery->stringValue(adductNameColumn);
 
-        string srmId = groupsQuery->stringValue("srm_id");
+        string srmId = groupsQuery->stringValue(srmIdColumn);
         if (!srmId.empty())
             group->setSrmId(srmId);
 
         if (!adductName.empty()) {
-            group->setAdduct(_findAdductByName(adductName));
+            // placeholder adducts are only used for their names, which lets
+            // groups share them
+            auto adductIter = adductsByName.find(adductName);
+            if (adductIter == end(adductsByName)) {
+                adductIter = adductsByName.emplace(
+                    adductName, _findAdductByName(adductName)).first;
+            }
+            group->setAdduct(adductIter->second);
         } else {
             group->setAdduct(nullptr);
         }
 
-        if (!compoundId.empty()) {
-            Compound* compound = _findSpeciesByIdAndName(compoundId,
-                                                         compoundName,
-                                                         compoundDB);
-            if (compound)
-                group->setCompound(compound);
-
-        } else if (!compoundName.empty() && !compoundDB.empty()) {
-            vector<Compound*> matches = _findSpeciesByName(compoundName,
-                                                           compoundDB);
-            if (matches.size() > 0)
-                group->setCompound(matches[0]);
+        if (!compoundId.empty()
+            || (!compoundName.empty() && !compoundDB.empty())) {
+            string compoundKey = compoundId + '\0'
+                                 + compoundName + '\0'
+                                 + compoundDB;
+            auto compoundIter = compoundsByKey.find(compoundKey);
+            if (compoundIter == end(compoundsByKey)) {
+                Compound* compound = nullptr;
+                if (!compoundId.empty()) {
+                    compound = _findSpeciesByIdAndName(compoundId,
+                                                       compoundName,
+                                                       compoundDB);
+                } else {
+                    vector<Compound*> matches =
+                        _findSpeciesByName(compoundName, compoundDB);
+                    if (matches.size() > 0)
+                        compound = matches[0];
+                }
+
+                // missing compounds are remembered as well, so that their
+                // database is not queried again for every group
+                compoundIter = compoundsByKey.emplace(compoundKey,
+                                                      compound).first;
+            }
+            if (compoundIter->second)
+                group->setCompound(compoundIter->second);
         }
 
         vector<string> sample_ids;
-        mzUtils::split(groupsQuery->stringValue("sample_ids"), ';', sample_ids);
+        mzUtils::split(groupsQuery->stringValue(sampleIdsColumn),
+                       ';',
+                       sample_ids);
         for (auto idString : sample_ids) {
             if (idString.empty())
                 continue;
 
-            int sampleId = stoi(idString);
-            auto sampleIter = find_if(begin(loaded),
-                                      end(loaded),
-                                      [sampleId](mzSample* s) {
-                                          return sampleId == s->getSampleId();
-                                      });
-            if (sampleIter != end(loaded)) {
-                group->samples.push_back(*sampleIter);
-            }
+            auto sampleIter = samplesById.find(stoi(idString));
+            if (sampleIter != end(samplesById))
+                group->samples.push_back(sampleIter->second);
         }
 
-        float sliceMzMin = groupsQuery->doubleValue("slice_mz_min");
-        float sliceMzMax = groupsQuery->doubleValue("slice_mz_max");
-        float sliceRtMin = groupsQuery->doubleValue("slice_rt_min");
-        float sliceRtMax = groupsQuery->doubleValue("slice_rt_max");
-        float sliceIonCount = groupsQuery->doubleValue("slice_ion_count");
+        float sliceMzMin = groupsQuery->doubleValue(sliceMzMinColumn);
+        float sliceMzMax = groupsQuery->doubleValue(sliceMzMaxColumn);
+        float sliceRtMin = groupsQuery->doubleValue(sliceRtMinColumn);
+        float sliceRtMax = groupsQuery->doubleValue(sliceRtMaxColumn);
+        float sliceIonCount = groupsQuery->doubleValue(sliceIonCountColumn);
         mzSlice slice(sliceMzMin, sliceMzMax, sliceRtMin, sliceRtMax);
         slice.ionCount = sliceIonCount;
         slice.srmId = group->srmId;
         slice.compound = group->getCompound();
         group->setSlice(slice);
 
-        loadGroupPeaks(group, databaseId, loaded);
-        group->groupStatistics();
-
         if (parentGroupId == 0) {
             groups.push_back(group);
         } else {
-            childParentMap[group] = parentGroupId;
+            childGroups.push_back(make_pair(databaseId, parentGroupId));
         }
+        loadedGroups.push_back(group);
         databaseIdForGroups[databaseId] = group;
     }
 
-    // assign parents for child groups
-    for (auto pair : childParentMap) {
-        bool foundParent = false;
-        auto child = pair.first;
-        for (auto idGroupPair : databaseIdForGroups) {
-            if (idGroupPair.first == pair.second) {
-                idGroupPair.second->addChild(*child);
-                foundParent = true;
-                break;
-            }
-        }
-        // failed to find a parent group, become a parent
-        if (!foundParent)
+    // read peaks of all groups in a single pass, instead of a query per group
+    auto peaksQuery = _connection->prepare(
+                "SELECT peaks.*                             \
+                      , samples.name AS sample_name         \
+                   FROM peaks                               \
+                      , samples                             \
+                  WHERE peaks.sample_id = samples.sample_id \
+               ORDER BY peaks.peak_id                       ");
+    _loadPeaks(peaksQuery, databaseIdForGroups, loaded);
+
+    // statistics of each group depend only on its own peaks
+#pragma omp parallel for schedule(dynamic)
+    for (size_t i = 0; i < loadedGroups.size(); ++i)
+        loadedGroups[i]->groupStatistics();
+
+    // assign parents for child groups, once their own data has been loaded.
+    // A parent keeps its own copy of each child, so children are attached
+    // deepest first: groups are always saved before their children, which
+    // gives every child a higher database ID than its parent.
+    sort(begin(childGroups), end(childGroups), greater<pair<int, int>>());
+    for (auto childParentPair : childGroups) {
+        auto childIter = databaseIdForGroups.find(childParentPair.first);
+        auto child = childIter->second;
+        auto parentIter = databaseIdForGroups.find(childParentPair.second);
+        if (parentIter != end(databaseIdForGroups)) {
+            parentIter->second->addChild(*child);
+            databaseIdForGroups.erase(childIter);
+            delete child;
+        } else {
+            // failed to find a parent group, become a parent
             groups.push_back(child);
+        }
     }
 
 
@@ -1041,6 +1322,7 @@ void ProjectDatabase::loadGroupPeaks(PeakGroup* parentGroup,
                                      int databaseId,
                                      const vector<mzSample*>& loaded)
 {
+    _connection->prepare(CREATE_PEAKS_GROUP_INDEX)->execute();
     auto peaksQuery = _connection->prepare(
                 "SELECT peaks.*                             \
                       , samples.name AS sample_name         \
@@ -1050,63 +1332,129 @@ void ProjectDatabase::loadGroupPeaks(PeakGroup* parentGroup,
                     AND peaks.group_id = :parent_group_id   ");
     peaksQuery->bind(":parent_group_id", databaseId);
 
+    unordered_map<int, PeakGroup*> groups;
+    groups[databaseId] = parentGroup;
+    _loadPeaks(peaksQuery, groups, loaded);
+}
+
+void ProjectDatabase::_loadPeaks(Cursor* peaksQuery,
+                                 const unordered_map<int, PeakGroup*>& groups,
+                                 const vector<mzSample*>& loaded)
+{
+    // the first sample with a name is the one that peaks are matched with
+    unordered_map<string, mzSample*> samplesByName;
+    for (auto sample : loaded)
+        samplesByName.emplace(sample->sampleName, sample);
+
+    const int groupIdColumn = peaksQuery->columnIndex("group_id");
+    const int posColumn = peaksQuery->columnIndex("pos");
+    const int minposColumn = peaksQuery->columnIndex("minpos");
+    const int maxposColumn = peaksQuery->columnIndex("maxpos");
+    const int rtColumn = peaksQuery->columnIndex("rt");
+    const int rtminColumn = peaksQuery->columnIndex("rtmin");
+    const int rtmaxColumn = peaksQuery->columnIndex("rtmax");
+    const int mzminColumn = peaksQuery->columnIndex("mzmin");
+    const int mzmaxColumn = peaksQuery->columnIndex("mzmax");
+    const int scanColumn = peaksQuery->columnIndex("scan");
+    const int minscanColumn = peaksQuery->columnIndex("minscan");
+    const int maxscanColumn = peaksQuery->columnIndex("maxscan");
+    const int peakAreaColumn = peaksQuery->columnIndex("peak_area");
+    const int peakSplineAreaColumn =
+        peaksQuery->columnIndex("peak_spline_area");
+    const int peakAreaCorrectedColumn =
+        peaksQuery->columnIndex("peak_area_corrected");
+    const int peakAreaTopColumn = peaksQuery->columnIndex("peak_area_top");
+    const int peakAreaTopCorrectedColumn =
+        peaksQuery->columnIndex("peak_area_top_corrected");
+    const int peakAreaFractionalColumn =
+        peaksQuery->columnIndex("peak_area_fractional");
+    const int peakRankColumn = peaksQuery->columnIndex("peak_rank");
+    const int peakIntensityColumn = peaksQuery->columnIndex("peak_intensity");
+    const int peakBaselineLevelColumn =
+        peaksQuery->columnIndex("peak_baseline_level");
+    const int peakMzColumn = peaksQuery->columnIndex("peak_mz");
+    const int medianMzColumn = peaksQuery->columnIndex("median_mz");
+    const int baseMzColumn = peaksQuery->columnIndex("base_mz");
+    const int qualityColumn = peaksQuery->columnIndex("quality");
+    const int widthColumn = peaksQuery->columnIndex("width");
+    const int gaussFitSigmaColumn = peaksQuery->columnIndex("gauss_fit_sigma");
+    const int gaussFitR2Column = peaksQuery->columnIndex("gauss_fit_r2");
+    const int noNoiseObsColumn = peaksQuery->columnIndex("no_noise_obs");
+    const int noNoiseFractionColumn =
+        peaksQuery->columnIndex("no_noise_fraction");
+    const int symmetryColumn = peaksQuery->columnIndex("symmetry");
+    const int signalBaselineRatioColumn =
+        peaksQuery->columnIndex("signal_baseline_ratio");
+    const int groupOverlapColumn = peaksQuery->columnIndex("group_overlap");
+    const int groupOverlapFracColumn =
+        peaksQuery->columnIndex("group_overlap_frac");
+    const int localMaxFlagColumn = peaksQuery->columnIndex("local_max_flag");
+    const int fromBlankSampleColumn =
+        peaksQuery->columnIndex("from_blank_sample");
+    const int labelColumn = peaksQuery->columnIndex("label");
+    const int sampleNameColumn = peaksQuery->columnIndex("sample_name");
+
     while (peaksQuery->next()) {
+        auto groupIter = groups.find(peaksQuery->integerValue(groupIdColumn));
+        if (groupIter == end(groups))
+            continue;
+
         Peak peak;
-        peak.pos = static_cast<unsigned int>(peaksQuery->integerValue("pos"));
+        peak.pos =
+            static_cast<unsigned int>(peaksQuery->integerValue(posColumn));
         peak.minpos =
-            static_cast<unsigned int>(peaksQuery->integerValue("minpos"));
+            static_cast<unsigned int>(peaksQuery->integerValue(minposColumn));
         peak.maxpos =
-            static_cast<unsigned int>(peaksQuery->integerValue("maxpos"));
-        peak.rt = peaksQuery->floatValue("rt");
-        peak.rtmin = peaksQuery->floatValue("rtmin");
-        peak.rtmax = peaksQuery->floatValue("rtmax");
-        peak.mzmin = peaksQuery->floatValue("mzmin");
-        peak.mzmax = peaksQuery->floatValue("mzmax");
-        peak.scan = static_cast<unsigned int>(peaksQuery->integerValue("scan"));
+            static_cast<unsigned int>(peaksQuery->integerValue(maxposColumn));
+        peak.rt = peaksQuery->floatValue(rtColumn);
+        peak.rtmin = peaksQuery->floatValue(rtminColumn);
+        peak.rtmax = peaksQuery->floatValue(rtmaxColumn);
+        peak.mzmin = peaksQuery->floatValue(mzminColumn);
+        peak.mzmax = peaksQuery->floatValue(mzmaxColumn);
+        peak.scan =
+            static_cast<unsigned int>(peaksQuery->integerValue(scanColumn));
         peak.minscan =
-            static_cast<unsigned int>(peaksQuery->integerValue("minscan"));
+            static_cast<unsigned int>(peaksQuery->integerValue(minscanColumn));
         peak.maxscan =
-            static_cast<unsigned int>(peaksQuery->integerValue("maxscan"));
-        peak.peakArea = peaksQuery->floatValue("peak_area");
-        peak.peakSplineArea = peaksQuery->floatValue("peak_spline_area");
-        peak.peakAreaCorrected = peaksQuery->floatValue("peak_area_corrected");
-        peak.peakAreaTop = peaksQuery->floatValue("peak_area_top");
+            static_cast<unsigned int>(peaksQuery->integerValue(maxscanColumn));
+        peak.peakArea = peaksQuery->floatValue(peakAreaColumn);
+        peak.peakSplineArea = peaksQuery->floatValue(peakSplineAreaColumn);
+        peak.peakAreaCorrected =
+            peaksQuery->floatValue(peakAreaCorrectedColumn);
+        peak.peakAreaTop = peaksQuery->floatValue(peakAreaTopColumn);
         peak.peakAreaTopCorrected =
-            peaksQuery->floatValue("peak_area_top_corrected");
+            peaksQuery->floatValue(peakAreaTopCorrectedColumn);
         peak.peakAreaFractional =
-            peaksQuery->floatValue("peak_area_fractional");
-        peak.peakRank = peaksQuery->floatValue("peak_rank");
-        peak.peakIntensity = peaksQuery->floatValue("peak_intensity");
-        peak.peakBaseLineLevel = peaksQuery->floatValue("peak_baseline_level");
-        peak.peakMz = peaksQuery->floatValue("peak_mz");
-        peak.medianMz = peaksQuery->floatValue("median_mz");
-        peak.baseMz = peaksQuery->floatValue("base_mz");
-        peak.quality = peaksQuery->floatValue("quality");
+            peaksQuery->floatValue(peakAreaFractionalColumn);
+        peak.peakRank = peaksQuery->floatValue(peakRankColumn);
+        peak.peakIntensity = peaksQuery->floatValue(peakIntensityColumn);
+        peak.peakBaseLineLevel =
+            peaksQuery->floatValue(peakBaselineLevelColumn);
+        peak.peakMz = peaksQuery->floatValue(peakMzColumn);
+        peak.medianMz = peaksQuery->floatValue(medianMzColumn);
+        peak.baseMz = peaksQuery->floatValue(baseMzColumn);
+        peak.quality = peaksQuery->floatValue(qualityColumn);
         peak.width =
-            static_cast<unsigned int>(peaksQuery->integerValue("width"));
-        peak.gaussFitSigma = peaksQuery->floatValue("gauss_fit_sigma");
-        peak.gaussFitR2 = peaksQuery->floatValue("gauss_fit_r2");
+            static_cast<unsigned int>(peaksQuery->integerValue(widthColumn));
+        peak.gaussFitSigma = peaksQuery->floatValue(gaussFitSigmaColumn);
+        peak.gaussFitR2 = peaksQuery->floatValue(gaussFitR2Column);
         peak.noNoiseObs =
-            static_cast<unsigned int>(peaksQuery->integerValue("no_noise_obs"));
-        peak.noNoiseFraction = peaksQuery->floatValue("no_noise_fraction");
-        peak.symmetry = peaksQuery->floatValue("symmetry");
+            static_cast<unsigned int>(peaksQuery->integerValue(noNoiseObsColumn));
+        peak.noNoiseFraction = peaksQuery->floatValue(noNoiseFractionColumn);
+        peak.symmetry = peaksQuery->floatValue(symmetryColumn);
         peak.signalBaselineRatio =
-            peaksQuery->floatValue("signal_baseline_ratio");
-        peak.groupOverlap = peaksQuery->floatValue("group_overlap");
-        peak.groupOverlapFrac = peaksQuery->floatValue("group_overlap_frac");
-        peak.localMaxFlag = peaksQuery->integerValue("local_max_flag");
-        peak.fromBlankSample = peaksQuery->integerValue("from_blank_sample");
-        peak.label = peaksQuery->stringValue("label")[0];
-
-        string sampleName = peaksQuery->stringValue("sample_name");
-
-        for (auto sample : loaded) {
-            if (sample->sampleName == sampleName) {
-                peak.setSample(sample);
-                break;
-            }
-        }
-        parentGroup->addPeak(peak);
+            peaksQuery->floatValue(signalBaselineRatioColumn);
+        peak.groupOverlap = peaksQuery->floatValue(groupOverlapColumn);
+        peak.groupOverlapFrac = peaksQuery->floatValue(groupOverlapFracColumn);
+        peak.localMaxFlag = peaksQuery->integerValue(localMaxFlagColumn);
+        peak.fromBlankSample = peaksQuery->integerValue(fromBlankSampleColumn);
+        peak.label = peaksQuery->stringValue(labelColumn)[0];
+
+        auto sampleIter = samplesByName.find(
+            peaksQuery->stringValue(sampleNameColumn));
+        if (sampleIter != end(samplesByName))
+            peak.setSample(sampleIter->second);
+        groupIter->second->addPeak(peak);
     }
 }
 
@@ -1128,14 +1476,38 @@ vector<Compound*> ProjectDatabase::loadCompounds(const string databaseName)
 
     MassCalculator mcalc;
     int loadCount = 0;
+
+    const int compoundIdColumn = compoundsQuery->columnIndex("compound_id");
+    const int nameColumn = compoundsQuery->columnIndex("name");
+    const int formulaColumn = compoundsQuery->columnIndex("formula");
+    const int chargeColumn = compoundsQuery->columnIndex("charge");
+    const int massColumn = compoundsQuery->columnIndex("mass");
+    const int dbNameColumn = compoundsQuery->columnIndex("db_name");
+    const int expectedRtColumn = compoundsQuery->columnIndex("expected_rt");
+    const int precursorMzColumn = compoundsQuery->columnIndex("precursor_mz");
+    const int productMzColumn = compoundsQuery->columnIndex("product_mz");
+    const int collisionEnergyColumn =
+        compoundsQuery->columnIndex("collision_energy");
+    const int smileStringColumn = compoundsQuery->columnIndex("smile_string");
+    const int logPColumn = compoundsQuery->columnIndex("log_p");
+    const int ionizationModeColumn =
+        compoundsQuery->columnIndex("ionization_mode");
+    const int noteColumn = compoundsQuery->columnIndex("note");
+    const int categoryColumn = compoundsQuery->columnIndex("category");
+    const int fragmentMzsColumn = compoundsQuery->columnIndex("fragment_mzs");
+    const int fragmentIntensityColumn =
+        compoundsQuery->columnIndex("fragment_intensity");
+    const int fragmentIonTypesColumn =
+        compoundsQuery->columnIndex("fragment_ion_types");
+
     while (compoundsQuery->next()) {
-        string id = compoundsQuery->stringValue("compound_id");
-        string name = compoundsQuery->stringValue("name");
-        string formula = compoundsQuery->stringValue("formula");
-        int charge = compoundsQuery->integerValue("charge");
-        float mass = compoundsQuery->floatValue("mass");
-        string db = compoundsQuery->stringValue("db_name");
-        float expectedRt = compoundsQuery->floatValue("expected_rt");
+        string id = compoundsQuery->stringValue(compoundIdColumn);
+        string name = compoundsQuery->stringValue(nameColumn);
+        string formula = compoundsQuery->stringValue(formulaColumn);
+        int charge = compoundsQuery->integerValue(chargeColumn);
+        float mass = compoundsQuery->floatValue(massColumn);
+        string db = compoundsQuery->stringValue(dbNameColumn);
+        float expectedRt = compoundsQuery->floatValue(expectedRtColumn);
 
         // skip if compound already exists in internal database
         if (_compoundIdMap.find(id + name + db) != end(_compoundIdMap))
@@ -1154,15 +1526,17 @@ vector<Compound*> ProjectDatabase::loadCompounds(const string databaseName)
                     (static_cast<float>(mcalc.computeNeutralMass(formula)));
         }
 
-        compound->setPrecursorMz ( compoundsQuery->floatValue("precursor_mz"));
-        compound->setProductMz (compoundsQuery->floatValue("product_mz"));
+        compound->setPrecursorMz
+                (compoundsQuery->floatValue(precursorMzColumn));
+        compound->setProductMz (compoundsQuery->floatValue(productMzColumn));
         compound->setCollisionEnergy
-                (compoundsQuery->floatValue("collision_energy"));
-        compound->setSmileString (compoundsQuery->stringValue("smile_string"));
-        compound->setLogP (compoundsQuery->floatValue("log_p"));
+                (compoundsQuery->floatValue(collisionEnergyColumn));
+        compound->setSmileString
+                (compoundsQuery->stringValue(smileStringColumn));
+        compound->setLogP (compoundsQuery->floatValue(logPColumn));
 
         int ionizationMode;
-        ionizationMode = compoundsQuery->floatValue("ionization_mode");
+        ionizationMode = compoundsQuery->floatValue(ionizationModeColumn);
         if (ionizationMode > 0)
             compound->ionizationMode = Compound::IonizationMode::Positive;
         else if (ionizationMode < 0)
@@ -1170,7 +1544,7 @@ vector<Compound*> ProjectDatabase::loadCompounds(const string databaseName)
         else
             compound->ionizationMode = Compound::IonizationMode::Neutral;
 
-        compound->setNote (compoundsQuery->stringValue("note"));
+        compound->setNote (compoundsQuery->stringValue(noteColumn));
 
         // mark compound as decoy if names contains DECOY string
         if (compound->name().find("DECOY") != string::npos)
@@ -1186,7 +1560,7 @@ vector<Compound*> ProjectDatabase::loadCompounds(const string databaseName)
             return separated;
         };
 
-        string categories = compoundsQuery->stringValue("category");
+        string categories = compoundsQuery->stringValue(categoryColumn);
         vector<string> categoryVect;
         for (auto category : split(categories, ';')) {
             if (!category.empty())
@@ -1194,7 +1568,8 @@ vector<Compound*> ProjectDatabase::loadCompounds(const string databaseName)
         }
         compound->setCategory(categoryVect);
 
-        string fragmentMzValues = compoundsQuery->stringValue("fragment_mzs");
+        string fragmentMzValues =
+                compoundsQuery->stringValue(fragmentMzsColumn);
         vector<float> mzValues;
         for (string fragMz : split(fragmentMzValues, ';')) {
             if (!fragMz.empty())
@@ -1203,7 +1578,7 @@ vector<Compound*> ProjectDatabase::loadCompounds(const string databaseName)
         compound->setFragmentMzValues(mzValues);
 
         string fragmentIntensities =
-                compoundsQuery->stringValue("fragment_intensity");
+                compoundsQuery->stringValue(fragmentIntensityColumn);
         vector<float> intensities;
         for (string fragIntensity : split(fragmentIntensities, ';')) {
             if (!fragIntensity.empty())
@@ -1212,7 +1587,7 @@ vector<Compound*> ProjectDatabase::loadCompounds(const string databaseName)
         compound->setFragmentIntensities(intensities);
 
         vector<string> fragmentIonTypes =
-            split(compoundsQuery->stringValue("fragment_ion_types"), ';');
+            split(compoundsQuery->stringValue(fragmentIonTypesColumn), ';');
         map<int, string> ionTypes;
         for (size_t i = 0; i < fragmentIonTypes.size(); ++i) {
             string fragIonType = fragmentIonTypes[i];
@@ -1222,6 +1597,8 @@ vector<Compound*> ProjectDatabase::loadCompounds(const string databaseName)
         compound->setFragmentIonTypes(ionTypes);
 
         _compoundIdMap[compound->id()  + compound->name() + compound->db()] = compound;
+        _compoundNameMap[compound->name() + '\0' + compound->db()]
+            .push_back(compound);
         compounds.push_back(compound);
         loadCount++;
     }
@@ -1264,35 +1641,41 @@ void ProjectDatabase::loadAndPerformAlignment(const vector<mzSample*>& loaded)
     AlignmentSegment* lastSegment = nullptr;
     int segCount = 0;
 
+    const int sampleNameColumn = alignmentQuery->columnIndex("sample_name");
+    const int sampleIdColumn = alignmentQuery->columnIndex("sample_id");
+    const int scannumColumn = alignmentQuery->columnIndex("scannum");
+    const int rtUpdatedColumn = alignmentQuery->columnIndex("rt_updated");
+    const int rtOriginalColumn = alignmentQuery->columnIndex("rt_original");
+
     while (alignmentQuery->next()) {
-        string sampleName = alignmentQuery->stringValue("sample_name");
-        int sampleId = alignmentQuery->integerValue("sample_id");
+        string sampleName = alignmentQuery->stringValue(sampleNameColumn);
+        int sampleId = alignmentQuery->integerValue(sampleIdColumn);
         if (!sampleScanMap.count(sampleId)) {
             cerr << "Error: no sample with id " << sampleId << " found" << endl;
             continue;
         }
 
-        int scannum = alignmentQuery->integerValue("scannum");
+        int scannum = alignmentQuery->integerValue(scannumColumn);
         if (scannum != -1) {
             // perform regular alignment
-            auto scanMap = sampleScanMap[sampleId];
+            auto& scanMap = sampleScanMap[sampleId];
             if (!scanMap.count(scannum)) {
                 cerr << "Error: no scan with scannum " << sampleId << endl;
                 continue;
             }
 
             Scan* scan = scanMap[scannum];
-            scan->rt = alignmentQuery->floatValue("rt_updated");
-            scan->originalRt = alignmentQuery->floatValue("rt_original");
+            scan->rt = alignmentQuery->floatValue(rtUpdatedColumn);
+            scan->originalRt = alignmentQuery->floatValue(rtOriginalColumn);
         } else {
             // perform segmented alignment
             segCount++;
             AlignmentSegment* seg = new AlignmentSegment();
             seg->sampleName = sampleName;
             seg->segStart = 0;
-            seg->segEnd   = alignmentQuery->floatValue("rt_original");
+            seg->segEnd   = alignmentQuery->floatValue(rtOriginalColumn);
             seg->newStart = 0;
-            seg->newEnd   = alignmentQuery->floatValue("rt_updated");
+            seg->newEnd   = alignmentQuery->floatValue(rtUpdatedColumn);
 
             if (lastSegment and lastSegment->sampleName == seg->sampleName) {
                 seg->segStart = lastSegment->segEnd;
@@ -1309,6 +1692,60 @@ void ProjectDatabase::loadAndPerformAlignment(const vector<mzSample*>& loaded)
         aligner.performSegmentedAlignment();
 }
 
+vector<Scan*> ProjectDatabase::loadScans(const vector<mzSample*>& loaded)
+{
+    auto scansQuery = _connection->prepare("SELECT *    \
+                                              FROM scans");
+
+    unordered_map<int, mzSample*> samplesById;
+    for (auto sample : loaded)
+        samplesById[sample->getSampleId()] = sample;
+
+    const int sampleIdColumn = scansQuery->columnIndex("sample_id");
+    const int scanColumn = scansQuery->columnIndex("scan");
+    const int mslevelColumn = scansQuery->columnIndex("mslevel");
+    const int rtColumn = scansQuery->columnIndex("rt");
+    const int precursorMzColumn = scansQuery->columnIndex("precursor_mz");
+    const int precursorChargeColumn =
+        scansQuery->columnIndex("precursor_charge");
+    const int dataColumn = scansQuery->columnIndex("data");
+    const int dataFormatColumn = scansQuery->columnIndex("data_format");
+
+    vector<Scan*> scans;
+    while (scansQuery->next()) {
+        int sampleId = scansQuery->integerValue(sampleIdColumn);
+        auto sample = samplesById.find(sampleId);
+        if (sample == samplesById.end()) {
+            cerr << "Error: no sample with id " << sampleId << " found" << endl;
+            continue;
+        }
+
+        auto scan = new Scan(sample->second,
+                             scansQuery->integerValue(scanColumn),
+                             scansQuery->integerValue(mslevelColumn),
+                             scansQuery->floatValue(rtColumn),
+                             scansQuery->floatValue(precursorMzColumn),
+                             0);
+        scan->precursorCharge = scansQuery->integerValue(precursorChargeColumn);
+
+        // tables of DB version 4 and older have no data_format column, which
+        // reads as text
+        auto format = static_cast<ScanDataFormat>(
+            scansQuery->integerValue(dataFormatColumn));
+        if (!_unpackScanData(scansQuery->blobValue(dataColumn),
+                             format,
+                             scan->mz,
+                             scan->intensity)) {
+            cerr << "Error: failed to read data of scan " << scan->scannum
+                 << endl;
+        }
+        scans.push_back(scan);
+    }
+
+    cerr << "Debug: Read in " << scans.size() << " scans" << endl;
+    return scans;
+}
+
 map<string, variant> ProjectDatabase::loadSettings()
 {
     map<string, variant> settingsMap;
@@ -1448,6 +1885,11 @@ void ProjectDatabase::deleteAllGroupsAndPeaks()
 {
     _connection->prepare("DROP TABLE peaks")->execute();
     _connection->prepare("DROP TABLE peakgroups")->execute();
+
+    // with no groups left, every group saved from now on can be tracked
+    _savedGroups.clear();
+    _savedRevision = revision();
+    _commitRevision();
     _connection->commit();
 }
 
@@ -1515,6 +1957,13 @@ void ProjectDatabase::deleteTableGroups(const string& tableName)
         return;
     }
 
+    for (auto saved = begin(_savedGroups); saved != end(_savedGroups);) {
+        if (saved->first.first == tableName)
+            saved = _savedGroups.erase(saved);
+        else
+            ++saved;
+    }
+    _commitRevision();
     _connection->commit();
 }
 
@@ -1563,6 +2012,17 @@ void ProjectDatabase::deletePeakGroup(PeakGroup* group)
         }
     }
 
+    // any tracked group sharing one of these IDs has lost some of its rows,
+    // so drop the rest of them as well
+    _connection->prepare(CREATE_PEAKS_GROUP_INDEX)->execute();
+    for (auto groupId : selectedGroups) {
+        auto saved = _savedGroups.find(make_pair(tableName, groupId));
+        if (saved == _savedGroups.end())
+            continue;
+        _deleteSavedGroup(saved->second);
+        _savedGroups.erase(saved);
+    }
+    _commitRevision();
     _connection->commit();
 }
 
@@ -1604,6 +2064,32 @@ int ProjectDatabase::version()
     return version;
 }
 
+int ProjectDatabase::revision()
+{
+    auto query = _connection->prepare(
+        "SELECT COUNT(*) AS table_count \
+           FROM sqlite_master           \
+          WHERE type = 'table'          \
+            AND name = 'save_revision'  ");
+    auto tableExists = false;
+    while (query->next())
+        tableExists = query->integerValue("table_count") > 0;
+    if (!tableExists)
+        return 0;
+
+    auto revisionQuery = _connection->prepare(
+        "SELECT MAX(revision) AS revision FROM save_revision");
+    auto revision = 0;
+    while (revisionQuery->next())
+        revision = revisionQuery->integerValue("revision");
+    return revision;
+}
+
+bool ProjectDatabase::canSaveIncrementally()
+{
+    return _savedRevision >= 0 && revision() == _savedRevision;
+}
+
 bool ProjectDatabase::isEmpty()
 {
     auto query = _connection->prepare(
@@ -1626,6 +2112,195 @@ bool ProjectDatabase::openConnection()
     return _connection != nullptr;
 }
 
+bool ProjectDatabase::_createGroupTables()
+{
+    if (!_connection->prepare(CREATE_PEAK_GROUPS_TABLE)->execute()) {
+        cerr << "Error: failed to create peakgroups table" << endl;
+        return false;
+    }
+    if (!_connection->prepare(CREATE_PEAKS_TABLE)->execute()) {
+        cerr << "Error: failed to create peaks table" << endl;
+        return false;
+    }
+    return true;
+}
+
+int ProjectDatabase::_saveAndTrackGroup(PeakGroup* group,
+                                        const string& tableName)
+{
+    vector<int> databaseIds;
+    int databaseId = _saveGroupAndPeaks(group, 0, tableName, &databaseIds);
+    if (databaseIds.empty())
+        return databaseId;
+
+    auto key = make_pair(tableName, group->groupId);
+    auto saved = _savedGroups.find(key);
+    if (saved == _savedGroups.end()) {
+        SavedGroup& savedGroup = _savedGroups[key];
+        savedGroup.databaseIds = move(databaseIds);
+        savedGroup.fingerprint = _groupFingerprint(group);
+        savedGroup.unique = true;
+        return databaseId;
+    }
+
+    // groups sharing an ID within a table cannot be told apart, so they are
+    // tracked together and rewritten on every update
+    saved->second.databaseIds.insert(end(saved->second.databaseIds),
+                                     begin(databaseIds),
+                                     end(databaseIds));
+    saved->second.unique = false;
+    return databaseId;
+}
+
+void ProjectDatabase::_deleteSavedGroup(const SavedGroup& savedGroup)
+{
+    auto peaksQuery = _connection->prepare(
+        "DELETE FROM peaks                \
+               WHERE group_id = :group_id");
+    auto peakgroupsQuery = _connection->prepare(
+        "DELETE FROM peakgroups           \
+               WHERE group_id = :group_id");
+    const int peaksGroupIdParam = peaksQuery->parameterIndex(":group_id");
+    const int peakgroupsGroupIdParam =
+        peakgroupsQuery->parameterIndex(":group_id");
+
+    for (auto databaseId : savedGroup.databaseIds) {
+        peaksQuery->bind(peaksGroupIdParam, databaseId);
+        if (!peaksQuery->execute())
+            cerr << "Error: failed to delete peaks of saved group" << endl;
+
+        peakgroupsQuery->bind(peakgroupsGroupIdParam, databaseId);
+        if (!peakgroupsQuery->execute())
+            cerr << "Error: failed to delete saved group" << endl;
+    }
+}
+
+size_t ProjectDatabase::_groupFingerprint(PeakGroup* group)
+{
+    size_t seed = 0;
+    boost::hash_combine(seed, group->deletedFlag);
+    if (group->deletedFlag)
+        return seed;
+
+    boost::hash_combine(seed, group->groupId);
+    boost::hash_combine(seed, group->metaGroupId);
+    boost::hash_combine(seed, group->tagString);
+    boost::hash_combine(seed, group->expectedMz);
+    boost::hash_combine(seed, group->expectedRtDiff());
+    boost::hash_combine(seed, group->expectedAbundance);
+    boost::hash_combine(seed, group->groupRank);
+    boost::hash_combine(seed, group->label);
+    boost::hash_combine(seed, static_cast<int>(group->type()));
+    boost::hash_combine(seed, group->srmId);
+    boost::hash_combine(seed, group->ms2EventCount);
+    boost::hash_combine(seed, group->minQuality);
+
+    const auto& score = group->fragMatchScore;
+    boost::hash_combine(seed, score.mergedScore);
+    boost::hash_combine(seed, score.fractionMatched);
+    boost::hash_combine(seed, score.mzFragError);
+    boost::hash_combine(seed, score.hypergeomScore);
+    boost::hash_combine(seed, score.mvhScore);
+    boost::hash_combine(seed, score.dotProduct);
+    boost::hash_combine(seed, score.weightedDotProduct);
+    boost::hash_combine(seed, score.spearmanRankCorrelation);
+    boost::hash_combine(seed, score.ticMatched);
+    boost::hash_combine(seed, score.numMatches);
+
+    boost::hash_combine(seed, group->getAdduct() ? group->getAdduct()->getName()
+                                                 : "");
+    auto compound = group->getCompound();
+    boost::hash_combine(seed, compound ? compound->id() : "");
+    boost::hash_combine(seed, compound ? compound->name() : "");
+    boost::hash_combine(seed, compound ? compound->db() : "");
+
+    const auto& slice = group->getSlice();
+    boost::hash_combine(seed, slice.mzmin);
+    boost::hash_combine(seed, slice.mzmax);
+    boost::hash_combine(seed, slice.rtmin);
+    boost::hash_combine(seed, slice.rtmax);
+    boost::hash_combine(seed, slice.ionCount);
+
+    for (auto sample : group->samples)
+        boost::hash_combine(seed, sample->getSampleId());
+
+    for (Peak& p : group->peaks) {
+        boost::hash_combine(seed, p.getSample()->getSampleId());
+        boost::hash_combine(seed, p.pos);
+        boost::hash_combine(seed, p.minpos);
+        boost::hash_combine(seed, p.maxpos);
+        boost::hash_combine(seed, p.rt);
+        boost::hash_combine(seed, p.rtmin);
+        boost::hash_combine(seed, p.rtmax);
+        boost::hash_combine(seed, p.mzmin);
+        boost::hash_combine(seed, p.mzmax);
+        boost::hash_combine(seed, p.scan);
+        boost::hash_combine(seed, p.minscan);
+        boost::hash_combine(seed, p.maxscan);
+        boost::hash_combine(seed, p.peakArea);
+        boost::hash_combine(seed, p.peakSplineArea);
+        boost::hash_combine(seed, p.peakAreaCorrected);
+        boost::hash_combine(seed, p.peakAreaTop);
+        boost::hash_combine(seed, p.peakAreaTopCorrected);
+        boost::hash_combine(seed, p.peakAreaFractional);
+        boost::hash_combine(seed, p.peakRank);
+        boost::hash_combine(seed, p.peakIntensity);
+        boost::hash_combine(seed, p.peakBaseLineLevel);
+        boost::hash_combine(seed, p.peakMz);
+        boost::hash_combine(seed, p.medianMz);
+        boost::hash_combine(seed, p.baseMz);
+        boost::hash_combine(seed, p.quality);
+        boost::hash_combine(seed, p.width);
+        boost::hash_combine(seed, p.gaussFitSigma);
+        boost::hash_combine(seed, p.gaussFitR2);
+        boost::hash_combine(seed, p.noNoiseObs);
+        boost::hash_combine(seed, p.noNoiseFraction);
+        boost::hash_combine(seed, p.symmetry);
+        boost::hash_combine(seed, p.signalBaselineRatio);
+        boost::hash_combine(seed, p.groupOverlap);
+        boost::hash_combine(seed, p.groupOverlapFrac);
+        boost::hash_combine(seed, p.localMaxFlag);
+        boost::hash_combine(seed, p.fromBlankSample);
+        boost::hash_combine(seed, p.label);
+    }
+
+    // children are saved along with their parent, so they are part of it
+    for (auto& child : group->children)
+        boost::hash_combine(seed, _groupFingerprint(&child));
+
+    return seed;
+}
+
+void ProjectDatabase::_commitRevision()
+{
+    if (!_connection->prepare(CREATE_SAVE_REVISION_TABLE)->execute()) {
+        cerr << "Error: failed to create save revision table" << endl;
+        _forgetSavedGroups();
+        return;
+    }
+
+    int newRevision = revision() + 1;
+    _connection->prepare("DELETE FROM save_revision")->execute();
+    auto revisionQuery = _connection->prepare(
+        "INSERT INTO save_revision VALUES ( :revision )");
+    revisionQuery->bind(":revision", newRevision);
+    if (!revisionQuery->execute()) {
+        cerr << "Error: failed to write save revision" << endl;
+        _forgetSavedGroups();
+        return;
+    }
+
+    // the saved groups are only known if they were known before this change
+    if (_savedRevision >= 0)
+        _savedRevision = newRevision;
+}
+
+void ProjectDatabase::_forgetSavedGroups()
+{
+    _savedGroups.clear();
+    _savedRevision = -1;
+}
+
 void ProjectDatabase::_assignSampleIds(const vector<mzSample*>& samples) {
     int maxSampleId = -1;
     for (auto sample : samples)
@@ -1672,12 +2347,18 @@ vector<Compound*> ProjectDatabase::_findSpeciesByName(string name,
     if (!databaseName.empty() && !_compoundDatabaseLoaded(databaseName))
         loadCompounds(databaseName);
 
-    vector<Compound*> similarlyNamedCompounds;
-    for (const auto& key : _compoundIdMap) {
-        Compound* compound = key.second;
-        if (compound->name() == name && compound->db() == databaseName)
-            similarlyNamedCompounds.push_back(compound);
-    }
+    auto nameIter = _compoundNameMap.find(name + '\0' + databaseName);
+    if (nameIter == end(_compoundNameMap))
+        return {};
+
+    // keep the same order in which compounds are ordered by their unique keys
+    vector<Compound*> similarlyNamedCompounds = nameIter->second;
+    sort(begin(similarlyNamedCompounds),
+         end(similarlyNamedCompounds),
+         [](Compound* a, Compound* b) {
+             return a->id() + a->name() + a->db()
+                    < b->id() + b->name() + b->db();
+         });
     return similarlyNamedCompounds;
 }
 
@@ -1690,25 +2371,120 @@ bool ProjectDatabase::_compoundDatabaseLoaded(string databaseName)
     return false;
 }
 
-string ProjectDatabase::_getScanSignature(Scan* scan, int limitSize)
+string ProjectDatabase::_packScanData(Scan* scan,
+                                      int limitSize,
+                                      bool binary,
+                                      ScanDataFormat& format)
 {
-    stringstream signature;
-    map<int, bool> seen;
+    format = binary ? ScanDataFormat::Floats : ScanDataFormat::TextSignature;
+
+    // keep the most intense peak of every nominal mass, looking at no more
+    // than `limitSize` of the most intense peaks
+    unordered_set<int> seen;
+    vector<size_t> selected;
     int mz_count = 0;
     for (auto posIndex : scan->intensityOrderDesc()) {
         size_t pos = static_cast<unsigned int>(posIndex);
         int mzround = static_cast<int>(scan->mz[pos]);
-        if (!seen.count(mzround)) {
-            signature << "[" << setprecision(9)
-                      << scan->mz[pos] << ","
-                      << scan->intensity[pos] << "]";
-            seen[mzround] = true;
-        }
+        if (seen.insert(mzround).second)
+            selected.push_back(pos);
 
         if (mz_count++ >= limitSize)
             break;
     }
-    return signature.str();
+
+    if (selected.empty())
+        return "";
+
+    // m/z-sorted arrays pack much tighter
+    sort(begin(selected), end(selected));
+    vector<float> mz;
+    vector<float> intensity;
+    mz.reserve(selected.size());
+    intensity.reserve(selected.size());
+    for (auto pos : selected) {
+        mz.push_back(scan->mz[pos]);
+        intensity.push_back(scan->intensity[pos]);
+    }
+
+    if (!binary) {
+        stringstream signature;
+        signature << setprecision(9);
+        for (size_t i = 0; i < mz.size(); ++i)
+            signature << "[" << mz[i] << "," << intensity[i] << "]";
+        return signature.str();
+    }
+
+    // spectra with few peaks are smaller without the compression overhead
+    string floats(mz.size() * 2 * sizeof(float), '\0');
+    memcpy(&floats[0], mz.data(), mz.size() * sizeof(float));
+    memcpy(&floats[mz.size() * sizeof(float)],
+           intensity.data(),
+           intensity.size() * sizeof(float));
+
+    string packed;
+    ScanLoader::pack(mz, intensity, packed);
+    if (packed.size() < floats.size()) {
+        format = ScanDataFormat::Packed;
+        return packed;
+    }
+    format = ScanDataFormat::Floats;
+    return floats;
+}
+
+bool ProjectDatabase::_unpackScanData(const string& data,
+                                      ScanDataFormat format,
+                                      vector<float>& mz,
+                                      vector<float>& intensity)
+{
+    mz.clear();
+    intensity.clear();
+    if (data.empty())
+        return true;
+
+    if (format == ScanDataFormat::Floats) {
+        if (data.size() % (2 * sizeof(float)) != 0)
+            return false;
+        size_t count = data.size() / (2 * sizeof(float));
+        mz.resize(count);
+        intensity.resize(count);
+        memcpy(mz.data(), data.data(), count * sizeof(float));
+        memcpy(intensity.data(),
+               data.data() + count * sizeof(float),
+               count * sizeof(float));
+        return true;
+    }
+
+    if (format == ScanDataFormat::Packed)
+        return ScanLoader::unpack(data, mz, intensity);
+
+    if (format != ScanDataFormat::TextSignature)
+        return false;
+
+    // "[mz,intensity]" pairs, which older versions wrote in decreasing order
+    // of intensity
+    vector<pair<float, float>> peaks;
+    const char* position = data.c_str();
+    while ((position = strchr(position, '['))) {
+        char* next;
+        float peakMz = strtof(position + 1, &next);
+        if (*next != ',')
+            return false;
+        float peakIntensity = strtof(next + 1, &next);
+        if (*next != ']')
+            return false;
+        peaks.push_back(make_pair(peakMz, peakIntensity));
+        position = next + 1;
+    }
+
+    sort(begin(peaks), end(peaks));
+    mz.reserve(peaks.size());
+    intensity.reserve(peaks.size());
+    for (const auto& peak : peaks) {
+        mz.push_back(peak.first);
+        intensity.push_back(peak.second);
+    }
+    return true;
 }
 
 string ProjectDatabase::_locateSample(const string filepath,
@@ -4,6 +4,7 @@
 #include <iostream>
 #include <map>
 #include <set>
+#include <unordered_map>
 #include <utility>
 #include <vector>
 
@@ -12,6 +13,7 @@
 class Adduct;
 class Compound;
 class Connection;
+class Cursor;
 class mzSample;
 class PeakGroup;
 class Scan;
@@ -106,6 +108,22 @@ public:
      */
     void saveGroupPeaks(PeakGroup* group, const int databaseId);
 
+    /**
+     * @brief Bring the saved peak groups of all tables up to date with the
+     * given ones, rewriting only the groups that changed since they were last
+     * saved through this object.
+     * @details A group is identified by its table name and `groupId`, and is
+     * considered changed if any of the values that would be saved for it, its
+     * peaks or its children differ. Changed groups are deleted and saved again,
+     * saved groups not present in any of the given tables are deleted and the
+     * rest are left untouched, all within a single transaction. This should
+     * only be used when `canSaveIncrementally` returns true, otherwise groups
+     * saved before they could be tracked would be left behind.
+     * @param tables A vector of table names paired with the top-level groups
+     * that belong to them.
+     */
+    void updateGroups(const vector<pair<string, vector<PeakGroup*>>>& tables);
+
     /**
      * @brief Save compounds linked to a given set of groups.
      * @details This method filters out the total pool of Compound objects from
@@ -133,9 +151,11 @@ public:
 
     /**
      * @brief Save some information about the scans of a set of samples.
-     * @details Although there is a save method for scans information, there is
-     * no load counterpart. So its still unclear, but this is probably used by
-     * the author (Eugene) for their downstream work using the database file.
+     * @details Only fragmentation scans are saved, each with the most intense
+     * peak of every nominal mass in binary form, or as text in files stamped
+     * with DB version 4 or older. This is probably used by the author
+     * (Eugene) for their downstream work using the database file, and can be
+     * read back using `loadScans`.
      * @param sampleSet A vector of pointers to mzSample objects whose scans
      * need to be saved. These samples should already have their uniqe ID set.
      */
@@ -240,6 +260,17 @@ public:
      */
     void loadAndPerformAlignment(const vector<mzSample*>& loaded);
 
+    /**
+     * @brief Load the scans saved using `saveScans`.
+     * @details Scans saved by older versions, as text, are read as well.
+     * @param loaded A vector of loaded samples which will be associated with
+     * the scans. Scans of other samples are skipped.
+     * @return A vector of new Scan objects holding the saved peaks, sorted by
+     * m/z. The caller takes ownership of these scans; they are not added to
+     * their samples.
+     */
+    vector<Scan*> loadScans(const vector<mzSample*>& loaded);
+
     /**
      * @brief Load user settings saved in the SQLite project database.
      * @details Since the values in this map can be of different types, a
@@ -347,6 +378,24 @@ public:
      */
     int version();
 
+    /**
+     * @brief Obtain the save revision of the database, a counter incremented
+     * every time peak groups are saved or deleted through this class.
+     * @return The save revision as an integer, or 0 if the database has never
+     * been saved to by a version aware of it.
+     */
+    int revision();
+
+    /**
+     * @brief Check whether the peak groups in the database are exactly the
+     * ones saved through this object, so that `updateGroups` can be used.
+     * @details This holds after the groups have been deleted through this
+     * object (e.g., using `deleteAll`) and only as long as the save revision on
+     * disk has not been changed by any other writer.
+     * @return True if groups can be updated incrementally, false otherwise.
+     */
+    bool canSaveIncrementally();
+
     /**
      * @brief Check whether the underlying database has not yet been used (or
      * appears to be so).
@@ -390,6 +439,127 @@ private:
      */
     map<string, Compound*> _compoundIdMap;
 
+    /**
+     * @brief _compoundNameMap Loaded compounds indexed by their name and
+     * database name, so that a compound can be found using its name without
+     * going through all loaded compounds.
+     */
+    unordered_map<string, vector<Compound*>> _compoundNameMap;
+
+    /**
+     * @brief Formats in which the peaks of a scan are stored in the data
+     * column of the 'scans' table.
+     */
+    enum class ScanDataFormat {
+        TextSignature = 0,  ///< "[mz,intensity]" text, written by older versions
+        Floats = 1,         ///< all m/z values, then all intensities, as floats
+        Packed = 2          ///< compressed, as created by `ScanLoader::pack`
+    };
+
+    /**
+     * @brief The SavedGroup struct records where a top-level group was saved
+     * and what it looked like at the time.
+     */
+    struct SavedGroup {
+        vector<int> databaseIds;
+        size_t fingerprint;
+        bool unique;
+    };
+
+    /**
+     * @brief _savedGroups Top-level groups saved through this object, keyed by
+     * their table name and `groupId`.
+     */
+    map<pair<string, int>, SavedGroup> _savedGroups;
+
+    /**
+     * @brief _savedRevision The save revision written along with the last
+     * change to tracked groups, or -1 if the groups in the database are not
+     * all tracked.
+     */
+    int _savedRevision;
+
+    /**
+     * @brief Create the tables for peak groups and peaks, if they do not
+     * exist yet.
+     * @return True if both tables exist.
+     */
+    bool _createGroupTables();
+
+    /**
+     * @brief Save the given peak group, its sub-groups and their peaks,
+     * assuming that the tables for them already exist. Statements are
+     * prepared once per connection and reused for every group and peak.
+     * @param group The PeakGroup which has to be saved.
+     * @param parentGroupId The group ID of the parent group, if any.
+     * @param tableName Table name to be saved for the group.
+     * @param databaseIds If given, the IDs of the group and all of its
+     * sub-groups are appended to this vector as they are saved.
+     * @return An integer ID for the group saved.
+     */
+    int _saveGroupAndPeaks(PeakGroup* group,
+                           const int parentGroupId,
+                           const string& tableName,
+                           vector<int>* databaseIds=nullptr);
+
+    /**
+     * @brief Save peaks for the given group, assuming that the peaks table
+     * already exists.
+     * @param group The peak group whose peaks need to be saved.
+     * @param databaseId A unique ID for the group (as saved in the database).
+     */
+    void _saveGroupPeaks(PeakGroup* group, const int databaseId);
+
+    /**
+     * @brief Load peaks returned by the given query into their groups.
+     * @param peaksQuery A query over the peaks table, which should also have
+     * a `sample_name` column from the samples table.
+     * @param groups Peak groups mapped by their database IDs. Each peak is
+     * added to the group matching its `group_id`, peaks of other groups are
+     * skipped.
+     * @param loaded A vector of loaded mzSample objects to associate each peak
+     * with.
+     */
+    void _loadPeaks(Cursor* peaksQuery,
+                    const unordered_map<int, PeakGroup*>& groups,
+                    const vector<mzSample*>& loaded);
+
+    /**
+     * @brief Save a top-level group, its sub-groups and their peaks, and start
+     * tracking them for later updates.
+     * @param group The PeakGroup which has to be saved.
+     * @param tableName Table name to be saved for the group.
+     * @return An integer ID for the group saved.
+     */
+    int _saveAndTrackGroup(PeakGroup* group, const string& tableName);
+
+    /**
+     * @brief Delete the rows of a tracked group and its peaks, without
+     * committing.
+     * @param savedGroup The tracked group to be deleted.
+     */
+    void _deleteSavedGroup(const SavedGroup& savedGroup);
+
+    /**
+     * @brief Hash all values that would be saved for a group, its peaks and
+     * its sub-groups.
+     * @param group The PeakGroup to be hashed.
+     * @return A hash that changes whenever the saved group would.
+     */
+    size_t _groupFingerprint(PeakGroup* group);
+
+    /**
+     * @brief Increment the save revision on disk, as part of the current
+     * transaction, and remember it if the saved groups are being tracked.
+     */
+    void _commitRevision();
+
+    /**
+     * @brief Stop tracking saved groups, because the database was changed in
+     * a way that cannot be followed.
+     */
+    void _forgetSavedGroups();
+
     /**
      * @brief Assign each sample in the given vector with a unique ID.
      * @details This unique ID is extremely important in ensuring that other
@@ -437,12 +607,34 @@ private:
     bool _compoundDatabaseLoaded(string databaseName);
 
     /**
-     * @brief Attempt to create a unique scan signature for a given Scan object.
-     * @param scan A Scan object for which signature needs to be created.
-     * @param limitSize A limiting number on the length of the scan signature.
-     * @return A scan signature of the Scan as a string.
-     */
-    string _getScanSignature(Scan* scan, int limitSize);
+     * @brief Pack the peaks to be saved for a given Scan object, in whichever
+     * binary format is smaller for them.
+     * @param scan A Scan object whose peaks need to be packed.
+     * @param limitSize A limiting number on the peaks looked at, in decreasing
+     * order of intensity.
+     * @param binary Whether a binary format may be used. If not, the peaks
+     * are written as "[mz,intensity]" text, for files stamped with DB version
+     * 4 or older.
+     * @param format Receives the format used.
+     * @return Packed peaks of the Scan as a string of bytes.
+     */
+    string _packScanData(Scan* scan,
+                         int limitSize,
+                         bool binary,
+                         ScanDataFormat& format);
+
+    /**
+     * @brief Decode the peaks saved for a scan.
+     * @param data The saved data of the scan.
+     * @param format Format in which the data was saved.
+     * @param mz Vector that receives the m/z values, in increasing order.
+     * @param intensity Vector that receives the intensities.
+     * @return False if the data could not be decoded.
+     */
+    bool _unpackScanData(const string& data,
+                         ScanDataFormat format,
+                         vector<float>& mz,
+                         vector<float>& intensity);
 
     /**
      * @brief Find a given sample within one of the possible paths.
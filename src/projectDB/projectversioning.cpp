@@ -20,7 +20,8 @@ map<Version, int> appDbVersionMap = {
     {Version("0.7.0"), 1},
     {Version("0.8.0"), 2},
     {Version("0.9.0"), 3},
-    {Version("0.10.0"), 4}
+    {Version("0.10.0"), 4},
+    {Version("0.11.0"), 5}
 };
 
 /**
@@ -449,6 +450,29 @@ map<int, string> dbVersionUpgradeScripts = {
         "ALTER TABLE user_settings ADD COLUMN identification_match_rt  INTEGER;"
         "ALTER TABLE user_settings ADD COLUMN identification_rt_window REAL;"
         "COMMIT;"
+    },
+    {
+        4,
+        "BEGIN TRANSACTION;"
+
+        // scan data is now stored in binary form, tagged with its format; the
+        // table may not exist yet, since scans are only saved on request
+        "CREATE TABLE IF NOT EXISTS scans ( id               INTEGER PRIMARY KEY AUTOINCREMENT "
+        "                                 , sample_id        INTEGER NOT NULL                  "
+        "                                 , scan             INTEGER NOT NULL                  "
+        "                                 , file_seek_start  INTEGER NOT NULL                  "
+        "                                 , file_seek_end    INTEGER NOT NULL                  "
+        "                                 , mslevel          INTEGER NOT NULL                  "
+        "                                 , rt               REAL    NOT NULL                  "
+        "                                 , precursor_mz     REAL    NOT NULL                  "
+        "                                 , precursor_charge INTEGER NOT NULL                  "
+        "                                 , precursor_ic     REAL    NOT NULL                  "
+        "                                 , precursor_purity REAL                              "
+        "                                 , minmz            REAL    NOT NULL                  "
+        "                                 , maxmz            REAL    NOT NULL                  "
+        "                                 , data TEXT                                          );"
+        "ALTER TABLE scans ADD COLUMN data_format INTEGER NOT NULL DEFAULT 0;"
+        "COMMIT;"
     }
 };
 
@@ -663,8 +687,49 @@ void upgradeDatabase(const string& dbFilename,
 
     if (!upgradeScript.empty()) {
         Connection connection(dbFilename);
-        connection.executeMulti(upgradeScript);
+
+        // statements are run one at a time, so that columns which already
+        // exist can be skipped instead of failing the rest of the upgrade
+        regex addColumn("ALTER\\s+TABLE\\s+(\\w+)\\s+ADD\\s+COLUMN\\s+(\\w+)",
+                        regex::icase);
+        vector<string> statements;
+        mzUtils::split(upgradeScript, ';', statements);
+        for (const auto& statement : statements) {
+            bool blank = all_of(begin(statement),
+                                end(statement),
+                                [](unsigned char x) { return isspace(x); });
+            if (blank)
+                continue;
+
+            smatch matches;
+            if (regex_search(statement, matches, addColumn)
+                && hasColumn(connection, matches[1].str(), matches[2].str())) {
+                continue;
+            }
+
+            if (!connection.executeMulti(statement + ";")) {
+                cerr << "Error: failed to upgrade database at statement \""
+                     << statement
+                     << "\""
+                     << endl;
+                break;
+            }
+        }
+    }
+}
+
+bool hasColumn(Connection& connection,
+               const string& tableName,
+               const string& columnName)
+{
+    // SQLite does not support binding for PRAGMA statements
+    auto query = connection.prepare("PRAGMA table_info(" + tableName + ")");
+    bool found = false;
+    while (query->next()) {
+        if (query->stringValue("name") == columnName)
+            found = true;
     }
+    return found;
 }
 
 bool backupFile(const string& originalFilepath, const string& newFilepath)
@@ -6,6 +6,8 @@
 
 using namespace std;
 
+class Connection;
+
 namespace ProjectVersioning {
 
 /**
@@ -182,6 +184,10 @@ string generateUpgradeScript(const int fromVersion, const int toVersion);
 /**
  * @brief Upgrade a SQLite database by executing an upgrade script and backup
  * the existing database.
+ * @details Statements of the script are executed one after the other, until
+ * one of them fails. Statements adding a column that the table already has
+ * are skipped, so that upgrading a file which was already given a column of
+ * the new version does not fail.
  * @param dbFilename Absolute path of the database file to be backed up and
  * upgraded.
  * @param upgradeScript A valid SQL string that can be executed to mutate a
@@ -203,6 +209,17 @@ void upgradeDatabase(const string& dbFilename,
  */
 bool backupFile(const string& originalFilepath, const string& newFilepath);
 
+/**
+ * @brief Check whether a table of a database has a given column.
+ * @param connection Connection to the database.
+ * @param tableName Name of the table.
+ * @param columnName Name of the column.
+ * @return True if the table exists and has the column, false otherwise.
+ */
+bool hasColumn(Connection& connection,
+               const string& tableName,
+               const string& columnName);
+
 }
 
 #endif // PROJECTVERSIONING_H
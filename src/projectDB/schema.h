@@ -21,6 +21,24 @@
                                         , transform_a5 REAL                              );"
 
 #define CREATE_SCANS_TABLE \
+    "CREATE TABLE IF NOT EXISTS scans ( id               INTEGER PRIMARY KEY AUTOINCREMENT \
+                                      , sample_id        INTEGER NOT NULL                  \
+                                      , scan             INTEGER NOT NULL                  \
+                                      , file_seek_start  INTEGER NOT NULL                  \
+                                      , file_seek_end    INTEGER NOT NULL                  \
+                                      , mslevel          INTEGER NOT NULL                  \
+                                      , rt               REAL    NOT NULL                  \
+                                      , precursor_mz     REAL    NOT NULL                  \
+                                      , precursor_charge INTEGER NOT NULL                  \
+                                      , precursor_ic     REAL    NOT NULL                  \
+                                      , precursor_purity REAL                              \
+                                      , minmz            REAL    NOT NULL                  \
+                                      , maxmz            REAL    NOT NULL                  \
+                                      , data             BLOB                              \
+                                      , data_format      INTEGER NOT NULL DEFAULT 0        );"
+
+// scans table of project DB version 4 and older, which stores scan data as text
+#define CREATE_SCANS_TABLE_V4 \
     "CREATE TABLE IF NOT EXISTS scans ( id               INTEGER PRIMARY KEY AUTOINCREMENT \
                                       , sample_id        INTEGER NOT NULL                  \
                                       , scan             INTEGER NOT NULL                  \
@@ -251,6 +269,9 @@
                                               , adduct_search_window             REAL    \
                                               , adduct_percent_correlation       REAL    );"
 
+#define CREATE_SAVE_REVISION_TABLE \
+    "CREATE TABLE IF NOT EXISTS save_revision ( revision INTEGER NOT NULL );"
+
 #define CREATE_COMPOUNDS_DB_INDEX \
     "CREATE INDEX IF NOT EXISTS compounds_db_idx    \
                              ON compounds ( db_name );"
@@ -21,7 +21,7 @@ QMAKE_CXXFLAGS += -fopenmp
 INCLUDEPATH +=  $$top_srcdir/src/core/libmaven  $$top_srcdir/3rdparty/pugixml/src $$top_srcdir/3rdparty/libneural $$top_srcdir/3rdparty/libpls \
 				$$top_srcdir/3rdparty/libcsvparser $$top_srcdir/src/cli/peakdetector $$top_srcdir/3rdparty/libdate $$top_srcdir/3rdparty/libcdfread \
                 $$top_srcdir/3rdparty/obiwarp $$top_srcdir/src/pollyCLI \
-                $$top_srcdir/3rdparty/Eigen $$top_srcdir/src/
+                $$top_srcdir/3rdparty/Eigen $$top_srcdir/src/ $$top_srcdir/src/projectDB
 macx {
 
     DYLIBPATH = $$system(source ~/.bash_profile ; echo $LDFLAGS)
@@ -33,9 +33,9 @@ macx {
 }
 QMAKE_LFLAGS += -L$$top_builddir/libs/
 
-LIBS += -lmaven -lpugixml -lneural -lcsvparser -lpls -lErrorHandling -lLogger -lcdfread -lz -lnetcdf -lobiwarp -lpollyCLI -lcommon
-unix: LIBS += -lboost_system -lboost_filesystem
-win32: LIBS += -lboost_system-mt -lboost_filesystem-mt
+LIBS += -lprojectDB -lmaven -lpugixml -lneural -lcsvparser -lpls -lErrorHandling -lLogger -lcdfread -lz -lnetcdf -lobiwarp -lpollyCLI -lcommon
+unix: LIBS += -lboost_system -lboost_filesystem -lsqlite3
+win32: LIBS += -lboost_system-mt -lboost_filesystem-mt -lsqlite3
 !macx: LIBS += -fopenmp
 
 macx {
@@ -62,6 +62,8 @@ HEADERS += \
     testSRMList.h \
     testGroupFiltering.h \
     testIsotopeLogic.h \
+    testProjectDB.h \
+    testMassSlicer.h \
     $$top_srcdir/src/cli/peakdetector/peakdetectorcli.h \
     $$top_srcdir/src/core/libmaven/classifier.h \
     $$top_srcdir/src/core/libmaven/classifierNeuralNet.h \
@@ -86,6 +88,8 @@ SOURCES += \
     testSRMList.cpp \
     testGroupFiltering.cpp \
     testIsotopeLogic.cpp \
+    testProjectDB.cpp \
+    testMassSlicer.cpp \
     main.cpp \
     $$top_srcdir/src/cli/peakdetector/peakdetectorcli.cpp  \
     $$top_srcdir/src/cli/peakdetector/options.cpp \
@@ -15,6 +15,8 @@
 #include "testCharge.h"
 #include "testSRMList.h"
 #include "testIsotopeLogic.h"
+#include "testProjectDB.h"
+#include "testMassSlicer.h"
 
 int readLog(QString);
 
@@ -114,6 +116,18 @@ int main(int argc, char** argv) {
     result|=readLog("testMzAligner.xml");
     mzUtils::stopTimer(timer, "testMzAligner");
 
+    timer = mzUtils::startTimer();
+    if (freopen("testProjectDB.xml", "w", stdout))
+        result |= QTest::qExec(new TestProjectDB, argc, argv);
+    result|=readLog("testProjectDB.xml");
+    mzUtils::stopTimer(timer, "testProjectDB");
+
+    timer = mzUtils::startTimer();
+    if (freopen("testMassSlicer.xml", "w", stdout))
+        result |= QTest::qExec(new TestMassSlicer, argc, argv);
+    result|=readLog("testMassSlicer.xml");
+    mzUtils::stopTimer(timer, "testMassSlicer");
+
     return result;
 }
 
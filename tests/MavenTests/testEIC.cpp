@@ -62,6 +62,89 @@ void TestEIC::testgetEICms2() {
     QVERIFY(e3->maxIntensity == 49400);
 }
 
+// pull EICs over the entire run for a ladder of 10 ppm wide slices across the
+// sample's m/z range, similar to what untargeted detection does, and count how
+// many of them have one point per MS1 scan
+static unsigned int makeFullRunEICs(mzSample* mzsample,
+                                    unsigned int sliceCount)
+{
+    float mzStep = (mzsample->maxMz - mzsample->minMz) / sliceCount;
+    unsigned int fullSizeEICs = 0;
+    for (unsigned int i = 0; i < sliceCount; ++i) {
+        float mz = mzsample->minMz + i * mzStep;
+        float delta = mz * 10.0f / 1e6f;
+        EIC e;
+        e.makeEICSlice(mzsample,
+                       mz - delta,
+                       mz + delta,
+                       mzsample->minRt,
+                       mzsample->maxRt,
+                       1,
+                       0,
+                       "");
+        if (e.size() == mzsample->ms1ScanCount())
+            fullSizeEICs++;
+    }
+    return fullSizeEICs;
+}
+
+void TestEIC::testmakeEICSliceFullRun() {
+    // every EIC spanning the whole run should have one point per MS1 scan
+    mzSample* mzsample = maventests::samples.ms2TestSamples[0];
+    QVERIFY(makeFullRunEICs(mzsample, 200) == 200);
+}
+
+void TestEIC::testmakeEICSliceBenchmark() {
+    if (qgetenv("MAVEN_BENCHMARKS").isEmpty())
+        QSKIP("set MAVEN_BENCHMARKS to run benchmarks");
+
+    // the number of slices is fixed so that rates can be compared across files
+    mzSample* mzsample = maventests::samples.ms2TestSamples[0];
+    const unsigned int sliceCount = 2000;
+    auto start = chrono::high_resolution_clock::now();
+    unsigned int fullSizeEICs = makeFullRunEICs(mzsample, sliceCount);
+    auto end = chrono::high_resolution_clock::now();
+    double seconds = chrono::duration<double>(end - start).count();
+    cerr << "makeEICSlice: " << sliceCount << " EICs in " << seconds
+         << " s (" << sliceCount / max(seconds, 1e-9) << " EICs/sec)" << endl;
+
+    QVERIFY(fullSizeEICs == sliceCount);
+}
+
+void TestEIC::testgetEICs() {
+    mzSample* mzsample = maventests::samples.ms1TestSamples[0];
+    vector<mzSlice*> slices = {new mzSlice(402.9929f, 402.9969f, 12.0, 16.0),
+                               new mzSlice(180.002f, 180.004f, 0.0, 30.0),
+                               new mzSlice(744.070f, 744.090f, 14.0, 15.0),
+                               new mzSlice(402.9929f, 402.9969f, 15.5, 20.0),
+                               new mzSlice(90.0f, 900.0f, 10.0, 10.5)};
+
+    for (int eicType = 0; eicType <= 1; eicType++) {
+        vector<EIC*> eics = mzsample->getEICs(slices, 1, eicType, "");
+        QVERIFY(eics.size() == slices.size());
+
+        for (unsigned int i = 0; i < slices.size(); i++) {
+            EIC* e = mzsample->getEIC(slices[i]->mzmin,
+                                      slices[i]->mzmax,
+                                      slices[i]->rtmin,
+                                      slices[i]->rtmax,
+                                      1,
+                                      eicType,
+                                      "");
+            QVERIFY(eics[i]->scannum == e->scannum);
+            QVERIFY(eics[i]->rt == e->rt);
+            QVERIFY(eics[i]->intensity == e->intensity);
+            QVERIFY(eics[i]->totalIntensity == e->totalIntensity);
+            QVERIFY(eics[i]->maxIntensity == e->maxIntensity);
+            QVERIFY(eics[i]->mzmin == e->mzmin);
+            QVERIFY(eics[i]->mzmax == e->mzmax);
+            delete e;
+        }
+        delete_all(eics);
+    }
+    delete_all(slices);
+}
+
 void TestEIC::testcomputeSpline()
 {
     EIC* e = maventests::samples.ms1TestSamples[0]->getEIC(402.9929f,
@@ -355,6 +438,126 @@ void TestEIC:: testgroupPeaks() {
 }
 
 
+void TestEIC::testgroupPeaksManySamples() {
+    MavenParameters* mavenparameters = new MavenParameters();
+    mavenparameters->compoundMassCutoffWindow->setMassCutoffAndType(10,"ppm");
+    mavenparameters->samples = maventests::samples.ms1TestSamples;
+    mavenparameters->eic_smoothingWindow = 10;
+    mavenparameters->eic_smoothingAlgorithm = 1;
+    mavenparameters->aslsBaselineMode = false;
+    mavenparameters->baseline_smoothingWindow = 5;
+    mavenparameters->baseline_dropTopX = 80;
+    mavenparameters->grouping_maxRtWindow = 0.5;
+    mavenparameters->distXWeight = 1;
+    mavenparameters->distYWeight = 5;
+    mavenparameters->overlapWeight = 2;
+
+    vector<Compound*> compounds = TestUtils::getCompoudDataBaseWithRT();
+    mzSlice* slice = new mzSlice();
+    slice->compound = compounds[4];
+    slice->calculateRTMinMax(false, 0.0f);
+    slice->calculateMzMinMax(mavenparameters->compoundMassCutoffWindow, +1);
+
+    // emulate a 500 sample set by pulling the same EICs repeatedly and
+    // perturbing their intensities, so that peaks differ across "samples"
+    mt19937 generator(42);
+    uniform_real_distribution<float> noise(0.7f, 1.3f);
+    vector<EIC*> eics;
+    while (eics.size() < 500) {
+        vector<EIC*> pulled = PeakDetector::pullEICs(slice,
+                                                     mavenparameters->samples,
+                                                     mavenparameters);
+        for (auto eic : pulled) {
+            for (auto& intensity : eic->intensity)
+                intensity *= noise(generator);
+            eic->getPeakPositions(mavenparameters->eic_smoothingWindow);
+            eics.push_back(eic);
+        }
+    }
+
+    // reference assignment, scoring every sample peak against every merged
+    // peak like groupPeaks originally did
+    auto bruteForceGroups = [&](bool useOverlap) {
+        EIC* m = EIC::eicMerge(eics);
+        m->setFilterSignalBaselineDiff(
+            mavenparameters->minSignalBaselineDifference);
+        m->getPeakPositions(mavenparameters->eic_smoothingWindow);
+        sort(m->peaks.begin(), m->peaks.end(), Peak::compRt);
+
+        vector<int> groupNums;
+        for (auto eic : eics) {
+            for (auto& b : eic->peaks) {
+                int groupNum = -1;
+                float bestScore = FLT_MIN;
+                for (unsigned int k = 0; k < m->peaks.size(); k++) {
+                    Peak& a = m->peaks[k];
+                    float overlap = mzUtils::checkOverlap(a.rtmin,
+                                                          a.rtmax,
+                                                          b.rtmin,
+                                                          b.rtmax);
+                    float distx = abs(b.rt - a.rt);
+                    float disty = abs(b.peakIntensity - a.peakIntensity);
+                    float score;
+                    if (useOverlap) {
+                        if (overlap == 0 and a.rtmax < b.rtmin)
+                            continue;
+                        if (overlap == 0 and a.rtmin > b.rtmax)
+                            break;
+                        if (distx > mavenparameters->grouping_maxRtWindow
+                            && overlap < 0.2)
+                            continue;
+                        score = 1.0
+                                / (mavenparameters->distXWeight * distx + 0.01)
+                                / (mavenparameters->distYWeight * disty + 0.01)
+                                * (mavenparameters->overlapWeight * overlap);
+                    } else {
+                        if (distx > mavenparameters->grouping_maxRtWindow)
+                            continue;
+                        score = 1.0
+                                / (mavenparameters->distXWeight * distx + 0.01)
+                                / (mavenparameters->distYWeight * disty + 0.01);
+                    }
+                    if (score > bestScore) {
+                        groupNum = k;
+                        bestScore = score;
+                    }
+                }
+                groupNums.push_back(groupNum);
+            }
+        }
+        delete m;
+        return groupNums;
+    };
+
+    for (bool useOverlap : {false, true}) {
+        vector<int> expected = bruteForceGroups(useOverlap);
+        vector<PeakGroup> peakgroups = EIC::groupPeaks(
+            eics,
+            slice,
+            mavenparameters->eic_smoothingWindow,
+            mavenparameters->grouping_maxRtWindow,
+            mavenparameters->minQuality,
+            mavenparameters->distXWeight,
+            mavenparameters->distYWeight,
+            mavenparameters->overlapWeight,
+            useOverlap,
+            mavenparameters->minSignalBaselineDifference,
+            mavenparameters->fragmentTolerance,
+            mavenparameters->scoringAlgo);
+
+        vector<int> observed;
+        for (auto eic : eics) {
+            for (auto& peak : eic->peaks)
+                observed.push_back(peak.groupNum);
+        }
+        QVERIFY(peakgroups.size() > 0);
+        QVERIFY(observed == expected);
+    }
+
+    delete_all(eics);
+    delete slice;
+}
+
 void TestEIC:: testeicMerge() {
     bool matchRtFlag = true;
     float compoundRTWindow = 2;
@@ -25,6 +25,9 @@ class TestEIC : public QObject {
         // this is automatically detected thanks to Qt's meta-information about QObjects
         void testgetEIC();
         void testgetEICms2();
+        void testmakeEICSliceFullRun();
+        void testmakeEICSliceBenchmark();
+        void testgetEICs();
         void testcomputeSpline();
         void testgetPeakPositions();
         void testcomputeBaselineThreshold();
@@ -34,6 +37,7 @@ class TestEIC : public QObject {
         void testfindPeakBounds();
         void testGetPeakDetails();
         void testgroupPeaks();
+        void testgroupPeaksManySamples();
         void testeicMerge();
 };
 
@@ -1,7 +1,13 @@
 #include "testLoadSamples.h"
 #include "mavenparameters.h"
+#include "EIC.h"
+#include "Fragment.h"
+#include "mzAligner.h"
 #include "mzSample.h"
+#include "obiwarp.h"
 #include "Scan.h"
+#include "datastructures/mzSlice.h"
+#include "samplecache.h"
 #include "utilities.h"
 
 TestLoadSamples::TestLoadSamples() {
@@ -85,6 +91,54 @@ void TestLoadSamples:: testScanParsing() {
 
 }
 
+void TestLoadSamples::testNestedScanParsing() {
+    // MS2 scans nested within their MS1 scan are parsed, scans nested any
+    // deeper are not
+    string filename = QDir::temp().filePath("nestedscans.mzXML").toStdString();
+    ofstream file(filename);
+    file << "<?xml version=\"1.0\" encoding=\"ISO-8859-1\"?>\n"
+         << "<mzXML><msRun scanCount=\"3\">\n"
+         << "<msInstrument><msModel category=\"msModel\" value=\"Exactive\"/>"
+         << "</msInstrument>\n"
+         << "<!-- <scan num=\"0\"> -->\n"
+         << "<scan num=\"1\" msLevel=\"1\" retentionTime=\"PT60S\">\n"
+         << "<peaks precision=\"32\">QsgAAEEgAABDSAAAQaAAAA==</peaks>\n"
+         << "<scan num=\"2\" msLevel=\"2\" retentionTime=\"PT61S\">\n"
+         << "<precursorMz>200</precursorMz>\n"
+         << "<peaks precision=\"32\">QxYAAECgAAA=</peaks>\n"
+         << "<scan num=\"3\" msLevel=\"3\" retentionTime=\"PT62S\"/>\n"
+         << "</scan>\n"
+         << "</scan>\n"
+         << "<scan num=\"4\" msLevel=\"1\" retentionTime=\"PT120S\">\n"
+         << "<peaks precision=\"32\">QvAAAEDgAAA=</peaks>\n"
+         << "</scan>\n"
+         << "</msRun></mzXML>\n";
+    file.close();
+
+    mzSample mzsample;
+    mzsample.parseMzXML(filename.c_str());
+    remove(filename.c_str());
+
+    QVERIFY(mzsample.scanCount() == 3);
+    QVERIFY(mzsample.instrumentInfo["msModel"] == "Exactive");
+
+    Scan* scan = mzsample.getScan(0);
+    QVERIFY(scan->mslevel == 1);
+    QVERIFY(TestUtils::floatCompare(scan->rt, 1.0f));
+    QVERIFY(scan->mz.size() == 2);
+    QVERIFY(scan->mz[1] == 200.0f && scan->intensity[1] == 20.0f);
+
+    scan = mzsample.getScan(1);
+    QVERIFY(scan->mslevel == 2);
+    QVERIFY(scan->precursorMz == 200.0f);
+    QVERIFY(scan->mz.size() == 1 && scan->mz[0] == 150.0f);
+
+    scan = mzsample.getScan(2);
+    QVERIFY(scan->mslevel == 1);
+    QVERIFY(TestUtils::floatCompare(scan->rt, 2.0f));
+    QVERIFY(scan->intensity.size() == 1 && scan->intensity[0] == 7.0f);
+}
+
 void TestLoadSamples:: testSrmScan() {
     mzSample mzsample;
     unsigned int numberOfScans = 1603;
@@ -194,3 +248,443 @@ void TestLoadSamples::testParseMzMLInjectionTimeStamp() {
     }
 
 }
+
+void TestLoadSamples::testSampleCache() {
+    // work on a copy, so that no cache is left next to the test data
+    string filename = QDir::temp().filePath("cachedsample.mzxml").toStdString();
+    QFile::remove(QString::fromStdString(filename));
+    QVERIFY(QFile::copy(loadFile, QString::fromStdString(filename)));
+    string cacheFile = SampleCache::cachePath(filename);
+    QFile::remove(QString::fromStdString(cacheFile));
+
+    mzSample::setUseSampleCache(true);
+    mzSample parsed;
+    parsed.loadSample(filename.c_str());
+    QVERIFY(QFile::exists(QString::fromStdString(cacheFile)));
+
+    mzSample cached;
+    QVERIFY(SampleCache::read(&cached, filename));
+    mzSample::setUseSampleCache(false);
+
+    QVERIFY(cached.scans.size() == parsed.scans.size());
+    for (unsigned int i = 0; i < parsed.scans.size(); i++) {
+        Scan* a = parsed.scans[i];
+        Scan* b = cached.scans[i];
+        QVERIFY(a->scannum == b->scannum);
+        QVERIFY(a->mslevel == b->mslevel);
+        QVERIFY(a->rt == b->rt);
+        QVERIFY(a->polarity == b->polarity);
+        QVERIFY(a->precursorMz == b->precursorMz);
+        QVERIFY(a->filterLine == b->filterLine);
+        QVERIFY(a->mz == b->mz);
+        QVERIFY(a->intensity == b->intensity);
+    }
+    QVERIFY(cached.instrumentInfo == parsed.instrumentInfo);
+
+    // a cache is not used once the scan filters change
+    mzSample::setFilter_mslevel(2);
+    mzSample filtered;
+    QVERIFY(!SampleCache::read(&filtered, filename));
+    mzSample::setFilter_mslevel(0);
+
+    QFile::remove(QString::fromStdString(cacheFile));
+    QFile::remove(QString::fromStdString(filename));
+}
+
+void TestLoadSamples::testLazyLoading() {
+    mzSample eager;
+    eager.loadSample(loadFile);
+
+    // keep far fewer scans in memory than the sample has
+    mzSample::setLazyLoading(true);
+    mzSample::setLazyScanCacheSize(1);
+    mzSample lazy;
+    lazy.loadSample(loadFile);
+    mzSample::setLazyLoading(false);
+    mzSample::setLazyScanCacheSize(256);
+
+    QVERIFY(lazy.scanLoader() != nullptr);
+    QVERIFY(lazy.scanLoader()->residentBytes() <= (1 << 20));
+    QVERIFY(lazy.scans.size() == eager.scans.size());
+    QVERIFY(lazy.minMz == eager.minMz);
+    QVERIFY(lazy.maxMz == eager.maxMz);
+    QVERIFY(lazy.maxIntensity == eager.maxIntensity);
+
+    EIC* eagerEic = eager.getEIC(210.0, 211.0, 0.0, 10.0, 1, 0, "");
+    EIC* lazyEic = lazy.getEIC(210.0, 211.0, 0.0, 10.0, 1, 0, "");
+    QVERIFY(lazyEic->rt == eagerEic->rt);
+    QVERIFY(lazyEic->intensity == eagerEic->intensity);
+    delete eagerEic;
+    delete lazyEic;
+
+    for (unsigned int i = 0; i < eager.scans.size(); i++) {
+        Scan* a = eager.scans[i];
+        Scan* b = lazy.getScan(i);
+        ScanLoader::Pin pin(lazy.scanLoader(), b);
+        QVERIFY(a->rt == b->rt);
+        QVERIFY(a->precursorMz == b->precursorMz);
+        QVERIFY(a->mz == b->mz);
+        QVERIFY(a->intensity == b->intensity);
+    }
+}
+
+void TestLoadSamples::testCompactScans() {
+    mzSample full;
+    full.loadSample(loadFile);
+
+    mzSample::setCompactScans(true);
+    mzSample::setCompactScanCacheSize(0);
+    mzSample compact;
+    compact.loadSample(loadFile);
+    mzSample::setCompactScans(false);
+    mzSample::setCompactScanCacheSize(32);
+
+    size_t fullBytes = 0;
+    for (auto scan : full.scans)
+        fullBytes += (scan->mz.size() + scan->intensity.size()) * sizeof(float);
+
+    ScanLoader* loader = compact.scanLoader();
+    QVERIFY(loader != nullptr);
+    QVERIFY(loader->compressedBytes() + loader->residentBytes() < fullBytes);
+    QVERIFY(compact.scans.size() == full.scans.size());
+    QVERIFY(compact.minMz == full.minMz);
+    QVERIFY(compact.maxIntensity == full.maxIntensity);
+
+    EIC* fullEic = full.getEIC(210.0, 211.0, 0.0, 10.0, 1, 0, "");
+    EIC* compactEic = compact.getEIC(210.0, 211.0, 0.0, 10.0, 1, 0, "");
+    QVERIFY(compactEic->rt == fullEic->rt);
+    QVERIFY(compactEic->intensity == fullEic->intensity);
+    delete fullEic;
+    delete compactEic;
+
+    // peak data is stored losslessly
+    for (unsigned int i = 0; i < full.scans.size(); i++) {
+        Scan* a = full.scans[i];
+        Scan* b = compact.getScan(i);
+        ScanLoader::Pin pin(loader, b);
+        QVERIFY(a->filterLine == b->filterLine);
+        QVERIFY(a->mz == b->mz);
+        QVERIFY(a->intensity == b->intensity);
+    }
+}
+
+// base64 encode 32-bit floats, in network or in little endian byte order
+static string encodeFloats(const vector<float>& values, bool networkOrder)
+{
+    string bytes;
+    for (float value : values) {
+        uint32_t word;
+        memcpy(&word, &value, sizeof(word));
+        for (int i = 0; i < 4; i++) {
+            int shift = networkOrder ? 24 - 8 * i : 8 * i;
+            bytes += static_cast<char>((word >> shift) & 0xff);
+        }
+    }
+
+    const char* alphabet = "ABCDEFGHIJKLMNOPQRSTUVWXYZ"
+                           "abcdefghijklmnopqrstuvwxyz0123456789+/";
+    string encoded;
+    for (unsigned int i = 0; i < bytes.size(); i += 3) {
+        uint32_t group = static_cast<unsigned char>(bytes[i]) << 16;
+        if (i + 1 < bytes.size())
+            group |= static_cast<unsigned char>(bytes[i + 1]) << 8;
+        if (i + 2 < bytes.size())
+            group |= static_cast<unsigned char>(bytes[i + 2]);
+        encoded += alphabet[(group >> 18) & 0x3f];
+        encoded += alphabet[(group >> 12) & 0x3f];
+        encoded += i + 1 < bytes.size() ? alphabet[(group >> 6) & 0x3f] : '=';
+        encoded += i + 2 < bytes.size() ? alphabet[group & 0x3f] : '=';
+    }
+    return encoded;
+}
+
+// encode m/z-intensity pairs the way mzXML stores them
+static string encodeMzXMLPeaks(const vector<float>& mz,
+                               const vector<float>& intensity)
+{
+    vector<float> pairs;
+    for (unsigned int i = 0; i < mz.size(); i++) {
+        pairs.push_back(mz[i]);
+        pairs.push_back(intensity[i]);
+    }
+    return encodeFloats(pairs, true);
+}
+
+// write a DDA run, alternating between a full scan and a fragmentation scan
+// of one of three precursors; the signal of the run is shifted by `offset`
+// cycles
+static void writeDDAMzXML(const string& filename, int offset)
+{
+    ofstream file(filename);
+    file << "<?xml version=\"1.0\" encoding=\"ISO-8859-1\"?>\n"
+         << "<mzXML><msRun>\n";
+    int scannum = 1;
+    for (int i = 0; i < 200; i++) {
+        int cycle = i + offset;
+        vector<float> mz;
+        vector<float> intensity;
+        for (int j = 0; j < 150; j++) {
+            mz.push_back(100.0f + j * 2.5f + 0.001f * (cycle % 7));
+            intensity.push_back(1000.0f + 900.0f * sin(0.05f * cycle * cycle + j));
+        }
+        file << "<scan num=\"" << scannum++ << "\" msLevel=\"1\" "
+             << "retentionTime=\"PT" << 3.0f * (i + 1) << "S\">\n"
+             << "<peaks precision=\"32\">" << encodeMzXMLPeaks(mz, intensity)
+             << "</peaks>\n</scan>\n";
+
+        float precursorMz = mz[(cycle % 3) * 40 + 10];
+        mz.clear();
+        intensity.clear();
+        for (int j = 0; j < 40; j++) {
+            mz.push_back(50.0f + j * 2.5f);
+            intensity.push_back(500.0f + 450.0f * cos(0.3f * cycle + j));
+        }
+        file << "<scan num=\"" << scannum++ << "\" msLevel=\"2\" "
+             << "retentionTime=\"PT" << 3.0f * (i + 1) + 1.5f << "S\">\n"
+             << "<precursorMz>" << precursorMz << "</precursorMz>\n"
+             << "<peaks precision=\"32\">" << encodeMzXMLPeaks(mz, intensity)
+             << "</peaks>\n</scan>\n";
+    }
+    file << "</msRun></mzXML>\n";
+}
+
+void TestLoadSamples::testLazyPeakDataReaders() {
+    vector<string> filenames;
+    vector<mzSample*> eagerSamples;
+    vector<mzSample*> lazySamples;
+    for (int i = 0; i < 2; i++) {
+        string filename = QDir::temp()
+                              .filePath(i == 0 ? "lazyreaders_1.mzXML"
+                                               : "lazyreaders_2.mzXML")
+                              .toStdString();
+        writeDDAMzXML(filename, i == 0 ? 5 : 0);
+        filenames.push_back(filename);
+
+        eagerSamples.push_back(new mzSample);
+        eagerSamples.back()->loadSample(filename.c_str());
+
+        // a cache smaller than a single scan evicts any peak data that is not
+        // pinned as soon as another scan is loaded
+        mzSample::setLazyLoading(true);
+        mzSample::setLazyScanCacheSize(0);
+        lazySamples.push_back(new mzSample);
+        lazySamples.back()->loadSample(filename.c_str());
+        mzSample::setLazyLoading(false);
+        mzSample::setLazyScanCacheSize(256);
+        QVERIFY(lazySamples.back()->scanLoader() != nullptr);
+    }
+
+    mzSample* eager = eagerSamples[0];
+    mzSample* lazy = lazySamples[0];
+    for (unsigned int i = 1; i < 6; i += 2) {
+        Scan* ms2 = eager->scans[i];
+        QVERIFY(ms2->mslevel == 2);
+        mzSlice slice(ms2->precursorMz - 0.01,
+                      ms2->precursorMz + 0.01,
+                      eager->minRt,
+                      eager->maxRt);
+        vector<Scan*> eagerEvents = eager->getFragmentationEvents(&slice);
+        vector<Scan*> lazyEvents = lazy->getFragmentationEvents(&slice);
+        QVERIFY(!eagerEvents.empty());
+        QVERIFY(lazyEvents.size() == eagerEvents.size());
+        for (unsigned int j = 0; j < eagerEvents.size(); j++) {
+            Fragment a(eagerEvents[j], 0.01, 1, 1024);
+            Fragment b(lazyEvents[j], 0.01, 1, 1024);
+            QVERIFY(!a.mzValues.empty());
+            QVERIFY(a.scanNum == b.scanNum);
+            QVERIFY(a.precursorMz == b.precursorMz);
+            QVERIFY(a.mzValues == b.mzValues);
+            QVERIFY(a.intensityValues == b.intensityValues);
+            QVERIFY(a.purity == b.purity);
+        }
+    }
+
+    MavenParameters mavenparameters;
+    ObiParams params("cor", false, 2.0, 1.0, 0.20, 3.40, 0.0, 20.0, false, 0.60);
+    Aligner eagerAligner;
+    eagerAligner.setRefSample(eagerSamples[0]);
+    eagerAligner.alignWithObiWarp(eagerSamples, &params, &mavenparameters);
+    Aligner lazyAligner;
+    lazyAligner.setRefSample(lazySamples[0]);
+    lazyAligner.alignWithObiWarp(lazySamples, &params, &mavenparameters);
+
+    for (unsigned int i = 0; i < eagerSamples.size(); i++) {
+        QVERIFY(lazySamples[i]->scans.size() == eagerSamples[i]->scans.size());
+        for (unsigned int j = 0; j < eagerSamples[i]->scans.size(); j++) {
+            QVERIFY(lazySamples[i]->scans[j]->rt
+                    == eagerSamples[i]->scans[j]->rt);
+        }
+        delete eagerSamples[i];
+        delete lazySamples[i];
+        remove(filenames[i].c_str());
+    }
+}
+
+void TestLoadSamples::testSharedFilterLines() {
+    // the scans of a chromatogram all point to one copy of its id
+    mzSample mzsample;
+    mzsample.loadSample("bin/methods/ms2test1.mzML");
+    map<string, const char*> filterLines;
+    for (auto scan : mzsample.scans) {
+        QVERIFY(!scan->filterLine.str().empty());
+        auto inserted = filterLines.insert({scan->filterLine,
+                                            scan->filterLine.c_str()});
+        QVERIFY(inserted.first->second == scan->filterLine.c_str());
+    }
+    QVERIFY(filterLines.size() < mzsample.scans.size());
+}
+
+void TestLoadSamples::testFragmentationEvents() {
+    mzSample mzsample;
+    mzsample.loadSample("bin/methods/ms2test1.mzML");
+
+    // the precursor index finds the same scans, in the same order, as a
+    // pass over all scans of the sample
+    for (unsigned int i = 0; i < mzsample.scans.size(); i += 97) {
+        Scan* ms2 = mzsample.scans[i];
+        if (ms2->mslevel != 2)
+            continue;
+        mzSlice slice(ms2->precursorMz - 0.5,
+                      ms2->precursorMz + 0.5,
+                      ms2->rt - 1.0,
+                      ms2->rt + 1.0);
+        vector<Scan*> expected;
+        for (auto scan : mzsample.scans) {
+            if (scan->mslevel == 2
+                && scan->precursorMz >= slice.mzmin
+                && scan->precursorMz <= slice.mzmax
+                && scan->rt >= slice.rtmin
+                && scan->rt <= slice.rtmax)
+                expected.push_back(scan);
+        }
+        QVERIFY(!expected.empty());
+        QVERIFY(mzsample.getFragmentationEvents(&slice) == expected);
+    }
+
+    // scans added after loading are indexed as well
+    Scan* added = new Scan(&mzsample, 0, 2, mzsample.maxRt + 1.0f, 1234.5f, 1);
+    mzsample.addScan(added);
+    mzSlice slice(1234.0, 1235.0, mzsample.maxRt, mzsample.maxRt + 2.0);
+    vector<Scan*> events = mzsample.getFragmentationEvents(&slice);
+    QVERIFY(events.size() == 1 && events[0] == added);
+}
+
+void TestLoadSamples::testMzCSVEmptyFields() {
+    // an empty last field does not take the value of the next line
+    string filename = QDir::temp().filePath("emptyfields.mzCSV").toStdString();
+    ofstream file(filename);
+    file << "scannum,rt,mz,intensity,mslevel,precursorMz\n"
+         << "1,60,100.5,1000,1,\n"
+         << "1,60,200.5,2000,1,\n"
+         << "2,61,150.25,500,2,300.5\n"
+         << "3,62,100.5,1500,1,";
+    file.close();
+
+    mzSample mzsample;
+    mzsample.parseMzCSV(filename.c_str());
+    remove(filename.c_str());
+
+    QVERIFY(mzsample.scanCount() == 3);
+    Scan* scan = mzsample.getScan(0);
+    QVERIFY(scan->mslevel == 1);
+    QVERIFY(scan->precursorMz == 0.0f);
+    QVERIFY(scan->nobs() == 2);
+    QVERIFY(scan->mz[1] == 200.5f && scan->intensity[1] == 2000.0f);
+
+    scan = mzsample.getScan(1);
+    QVERIFY(scan->mslevel == 2);
+    QVERIFY(scan->precursorMz == 300.5f);
+
+    scan = mzsample.getScan(2);
+    QVERIFY(scan->precursorMz == 0.0f);
+    QVERIFY(scan->nobs() == 1 && scan->intensity[0] == 1500.0f);
+}
+
+void TestLoadSamples::testPeakSummaryOfParsedScans() {
+    // the summary of a scan is taken once all of its peaks have been read
+    string filename = QDir::temp().filePath("summary.mzCSV").toStdString();
+    ofstream csvFile(filename);
+    csvFile << "scannum,rt,mz,intensity,mslevel,precursorMz,polarity,srmid\n"
+            << "1,60,100.5,1000,1,0,+,\n"
+            << "1,60,200.5,2000,1,0,+,\n"
+            << "2,61,150.25,500,1,0,+,\n"
+            << "2,61,120.5,700,1,0,+,\n";
+    csvFile.close();
+
+    mzSample csvSample;
+    csvSample.parseMzCSV(filename.c_str());
+    remove(filename.c_str());
+
+    QVERIFY(csvSample.scanCount() == 2);
+    Scan* scan = csvSample.getScan(0);
+    QVERIFY(scan->hasPeakSummary());
+    QVERIFY(scan->totalIntensity() == 3000.0f);
+    QVERIFY(scan->maxIntensity() == 2000.0f);
+    QVERIFY(scan->basePeakMz() == 200.5f);
+    scan = csvSample.getScan(1);
+    QVERIFY(scan->totalIntensity() == 1200.0f);
+    QVERIFY(scan->minMz() == 120.5f && scan->maxMz() == 150.25f);
+
+    filename = QDir::temp().filePath("summary.mzData").toStdString();
+    ofstream dataFile(filename);
+    dataFile << "<?xml version=\"1.0\" encoding=\"ISO-8859-1\"?>\n"
+             << "<mzData><spectrumList count=\"1\">\n"
+             << "<spectrum id=\"1\"><spectrumDesc><spectrumSettings>"
+             << "<spectrumInstrument msLevel=\"1\">"
+             << "<cvParam name=\"TimeInMinutes\" value=\"1.5\"/>"
+             << "</spectrumInstrument></spectrumSettings></spectrumDesc>\n"
+             << "<mzArrayBinary><data precision=\"32\">"
+             << encodeFloats({100.5f, 200.5f, 300.5f}, false)
+             << "</data></mzArrayBinary>\n"
+             << "<intenArrayBinary><data precision=\"32\">"
+             << encodeFloats({10.0f, 40.0f, 25.0f}, false)
+             << "</data></intenArrayBinary>\n"
+             << "</spectrum>\n</spectrumList></mzData>\n";
+    dataFile.close();
+
+    mzSample dataSample;
+    dataSample.parseMzData(filename.c_str());
+    remove(filename.c_str());
+
+    QVERIFY(dataSample.scanCount() == 1);
+    scan = dataSample.getScan(0);
+    QVERIFY(scan->nobs() == 3);
+    QVERIFY(scan->hasPeakSummary());
+    QVERIFY(scan->totalIntensity() == 75.0f);
+    QVERIFY(scan->maxIntensity() == 40.0f);
+    QVERIFY(scan->basePeakMz() == 200.5f);
+    QVERIFY(scan->minMz() == 100.5f && scan->maxMz() == 300.5f);
+}
+
+void TestLoadSamples::testMzCSVRoundTrip() {
+    mzSample sample;
+    sample.loadSample(loadFile);
+    string filename = QDir::temp().filePath("roundtrip.mzCSV").toStdString();
+    sample.writeMzCSV(filename.c_str());
+
+    mzSample csvSample;
+    csvSample.loadSample(filename.c_str());
+    QFile::remove(QString::fromStdString(filename));
+
+    // scans without any observations are not written
+    vector<Scan*> written;
+    for (auto scan : sample.scans) {
+        if (scan->nobs() > 0)
+            written.push_back(scan);
+    }
+    QVERIFY(csvSample.scans.size() == written.size());
+    for (unsigned int i = 0; i < written.size(); i++) {
+        Scan* a = written[i];
+        Scan* b = csvSample.scans[i];
+        QVERIFY(a->mslevel == b->mslevel);
+        QVERIFY(a->filterLine == b->filterLine);
+        QVERIFY(a->nobs() == b->nobs());
+        // values are written with six significant digits
+        QVERIFY(abs(a->rt - b->rt) <= 1e-5 * max(1.0f, a->rt));
+        for (unsigned int j = 0; j < a->nobs(); j++) {
+            QVERIFY(abs(a->mz[j] - b->mz[j]) <= 1e-5 * a->mz[j]);
+            QVERIFY(abs(a->intensity[j] - b->intensity[j])
+                    <= 1e-5 * a->intensity[j]);
+        }
+    }
+}
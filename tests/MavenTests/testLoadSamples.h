@@ -28,6 +28,7 @@ class TestLoadSamples : public QObject {
         void testFileLoad();
         void testIsAllScansParsed();
         void testScanParsing();
+        void testNestedScanParsing();
         void testSrmScan();
         void testMinMaxMz();
         void testMinMaxRT();
@@ -36,6 +37,15 @@ class TestLoadSamples : public QObject {
 #endif
         void testBlankSample();
         void testParseMzMLInjectionTimeStamp();
+        void testSampleCache();
+        void testLazyLoading();
+        void testCompactScans();
+        void testLazyPeakDataReaders();
+        void testSharedFilterLines();
+        void testFragmentationEvents();
+        void testMzCSVRoundTrip();
+        void testMzCSVEmptyFields();
+        void testPeakSummaryOfParsedScans();
 };
 
 #endif // TESTLOADSAMPLES_H
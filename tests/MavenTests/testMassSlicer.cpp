@@ -0,0 +1,263 @@
+#include <omp.h>
+#include "testMassSlicer.h"
+#include "datastructures/mzSlice.h"
+#include "masscutofftype.h"
+#include "mavenparameters.h"
+#include "mzMassSlicer.h"
+#include "mzSample.h"
+#include "Scan.h"
+#include "sliceindex.h"
+#include "utilities.h"
+
+TestMassSlicer::TestMassSlicer() {}
+
+void TestMassSlicer::initTestCase() {
+    // This function is being executed at the beginning of each test suite
+    // That is - before other tests from this class run
+}
+
+void TestMassSlicer::cleanupTestCase() {
+    // Similarly to initTestCase(), this function is executed at the end of test suite
+}
+
+void TestMassSlicer::init() {
+    // This function is executed before each test
+}
+
+void TestMassSlicer::cleanup() {
+    // This function is executed after each test
+}
+
+// slice a part of the m/z range of the MS1 test samples using algorithmB, and
+// return copies of the resulting slices; a buffer size of 0 keeps the default
+static vector<mzSlice> sliceTestSamples(size_t maxBufferedSlices)
+{
+    MavenParameters* mavenparameters = new MavenParameters();
+    mavenparameters->samples = maventests::samples.ms1TestSamples;
+
+    MassSlices massSlices;
+    massSlices.setSamples(mavenparameters->samples);
+    massSlices.setMavenParameters(mavenparameters);
+    massSlices.setMinMz(150.0f);
+    massSlices.setMaxMz(250.0f);
+    if (maxBufferedSlices > 0)
+        massSlices.setMaxBufferedSlices(maxBufferedSlices);
+    massSlices.algorithmB(mavenparameters->massCutoffMerge,
+                          mavenparameters->rtStepSize);
+
+    vector<mzSlice> slices;
+    for (auto slice : massSlices.slices)
+        slices.push_back(*slice);
+    delete mavenparameters;
+    return slices;
+}
+
+static bool sameSlices(const vector<mzSlice>& slices,
+                       const vector<mzSlice>& otherSlices)
+{
+    if (slices.size() != otherSlices.size())
+        return false;
+
+    for (size_t i = 0; i < slices.size(); ++i) {
+        const mzSlice& a = slices[i];
+        const mzSlice& b = otherSlices[i];
+        if (a.mzmin != b.mzmin
+            || a.mzmax != b.mzmax
+            || a.rtmin != b.rtmin
+            || a.rtmax != b.rtmax
+            || a.mz != b.mz
+            || a.rt != b.rt
+            || a.ionCount != b.ionCount) {
+            return false;
+        }
+    }
+    return true;
+}
+
+void TestMassSlicer::testalgorithmBBands() {
+    vector<mzSlice> slices = sliceTestSamples(0);
+    QVERIFY(slices.size() > 0);
+
+    // a buffer of a single slice makes every unit of m/z a band of its own,
+    // so that records near each band edge are carried over to the next band
+    vector<mzSlice> bandedSlices = sliceTestSamples(1);
+    QVERIFY(sameSlices(bandedSlices, slices));
+}
+
+void TestMassSlicer::testalgorithmBThreads() {
+    int maxThreads = omp_get_max_threads();
+
+    omp_set_num_threads(1);
+    vector<mzSlice> serialSlices = sliceTestSamples(0);
+
+    // slices are built, merged and adjusted in parallel parts of the m/z
+    // range, which must not depend on how many threads share the work
+    omp_set_num_threads(max(4, maxThreads));
+    vector<mzSlice> parallelSlices = sliceTestSamples(0);
+
+    omp_set_num_threads(maxThreads);
+    QVERIFY(serialSlices.size() > 0);
+    QVERIFY(sameSlices(parallelSlices, serialSlices));
+}
+
+void TestMassSlicer::testSliceIndex() {
+    SliceIndex index(0.1f, 1.0f);
+    mzSlice wide(100.05f, 100.35f, 0.5f, 3.5f);
+    mzSlice negative(200.01f, 200.02f, -3.0f, -1.5f);
+    index.insert(&wide);
+    index.insert(&negative);
+    QVERIFY(index.size() == 2);
+
+    // the same queries must give the same answers on any grid, including
+    // grids where the wide slice spans many cells in both dimensions
+    vector<pair<float, float>> cellSizes = {{0.1f, 1.0f},
+                                            {1.0f, 10.0f},
+                                            {0.01f, 0.1f}};
+    for (auto cellSize : cellSizes) {
+        index.setCellSize(cellSize.first, cellSize.second);
+        QVERIFY(index.size() == 2);
+
+        // a slice spanning several of the queried cells is reported once
+        auto found = index.query(100.0f, 100.4f, 0.0f, 4.0f);
+        QVERIFY(found.size() == 1);
+        QVERIFY(found[0] == &wide);
+
+        found = index.query(100.2f, 100.21f, 2.0f, 2.1f);
+        QVERIFY(found.size() == 1);
+        QVERIFY(found[0] == &wide);
+
+        found = index.query(100.4f, 100.5f, 0.0f, 4.0f);
+        QVERIFY(found.empty());
+
+        // negative rt bounds are as valid as positive ones
+        found = index.query(200.0f, 200.03f, -2.0f, -1.8f);
+        QVERIFY(found.size() == 1);
+        QVERIFY(found[0] == &negative);
+
+        found = index.query(200.0f, 200.03f, -1.0f, 0.0f);
+        QVERIFY(found.empty());
+
+        found = index.query(0.0f, 300.0f, -10.0f, 10.0f);
+        QVERIFY(found.size() == 2);
+    }
+
+    index.clear();
+    QVERIFY(index.size() == 0);
+    QVERIFY(index.query(0.0f, 300.0f, -10.0f, 10.0f).empty());
+}
+
+// algorithmC as it was before slices were indexed on a grid: slices were only
+// looked up among those whose m/z fell in the same 0.1 m/z bucket as the
+// queried m/z
+static vector<mzSlice> bucketedAlgorithmC(vector<mzSample*> samples,
+                                          float ppm,
+                                          float minIntensity,
+                                          float rtWindow)
+{
+    vector<mzSlice> slices;
+    multimap<int, size_t> cache;
+    for (auto sample : samples) {
+        for (auto scan : sample->scans) {
+            if (scan->mslevel != 1)
+                continue;
+            vector<int> positions = scan->intensityOrderDesc();
+            for (unsigned int k = 0; k < positions.size() && k < 10; k++) {
+                int pos = positions[k];
+                if (scan->intensity[pos] < minIntensity)
+                    continue;
+                float rt = scan->rt;
+                float mz = scan->mz[pos];
+                float mzmax = mz + mz / 1e6 * ppm;
+                float mzmin = mz - mz / 1e6 * ppm;
+                float rtmin = rt - 2 * rtWindow;
+                float rtmax = rt + 2 * rtWindow;
+
+                float mzCenter = (mzmin + mzmax) / 2.0f;
+                float rtCenter = (rtmin + rtmax) / 2.0f;
+                bool exists = false;
+                auto bucket = cache.equal_range(int(mzCenter * 10));
+                for (auto it = bucket.first; it != bucket.second; ++it) {
+                    const mzSlice& slice = slices[it->second];
+                    if ((mzCenter > slice.mzmin
+                         && mzCenter < slice.mzmax
+                         && rtCenter > slice.rtmin
+                         && rtCenter < slice.rtmax)
+                        || (slice.mz > mzmin
+                            && slice.mz < mzmax
+                            && slice.rt > rtmin
+                            && slice.rt < rtmax)) {
+                        exists = true;
+                        break;
+                    }
+                }
+                if (exists)
+                    continue;
+
+                mzSlice slice(mzmin, mzmax, rtmin, rtmax);
+                slice.ionCount = scan->intensity[pos];
+                slice.rt = scan->rt;
+                slice.mz = mz;
+                cache.insert(make_pair(int(mz * 10), slices.size()));
+                slices.push_back(slice);
+            }
+        }
+    }
+    return slices;
+}
+
+void TestMassSlicer::testalgorithmC() {
+    // a sample where one ion drifts across the edge of a 0.1 m/z bucket from
+    // scan to scan, next to a few steady and slowly drifting ions
+    mzSample* sample = new mzSample();
+    for (int i = 0; i < 100; i++) {
+        Scan* scan = new Scan(sample, i, 1, i * 0.05f, 0.0f, 1);
+        scan->mz = {150.123f,
+                    199.9996f + (i % 2) * 0.0008f,
+                    250.0f + i * 0.001f,
+                    300.456f + (i % 3) * 0.0005f};
+        scan->intensity = {1000.0f + i,
+                           5000.0f,
+                           2000.0f + (i % 7) * 100.0f,
+                           3000.0f - i};
+        sample->addScan(scan);
+    }
+    sample->calculateMzRtRange();
+    vector<mzSample*> samples = {sample};
+
+    MassSlices massSlices;
+    massSlices.setSamples(samples);
+    massSlices.algorithmC(10.0f, 0.0f, 0.5f);
+    vector<mzSlice> bucketedSlices = bucketedAlgorithmC(samples,
+                                                        10.0f,
+                                                        0.0f,
+                                                        0.5f);
+    QVERIFY(massSlices.slices.size() > 0);
+    QVERIFY(massSlices.slices.size() < bucketedSlices.size());
+
+    // every slice is one that the bucketed lookup created as well, in the
+    // same order, while all the slices that only the bucketed lookup created
+    // duplicate a slice found by the grid index
+    size_t next = 0;
+    for (const auto& bucketed : bucketedSlices) {
+        if (next < massSlices.slices.size()) {
+            mzSlice* slice = massSlices.slices[next];
+            if (slice->mzmin == bucketed.mzmin
+                && slice->mzmax == bucketed.mzmax
+                && slice->rtmin == bucketed.rtmin
+                && slice->rtmax == bucketed.rtmax
+                && slice->mz == bucketed.mz
+                && slice->rt == bucketed.rt
+                && slice->ionCount == bucketed.ionCount) {
+                ++next;
+                continue;
+            }
+        }
+        QVERIFY(massSlices.sliceExists(bucketed.mzmin,
+                                       bucketed.mzmax,
+                                       bucketed.rtmin,
+                                       bucketed.rtmax) != nullptr);
+    }
+    QVERIFY(next == massSlices.slices.size());
+
+    delete sample;
+}
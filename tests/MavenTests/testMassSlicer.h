@@ -0,0 +1,31 @@
+#ifndef TESTMASSSLICER_H
+#define TESTMASSSLICER_H
+#include <iostream>
+#include <QtTest>
+#include <string>
+#include <sstream>
+
+class TestMassSlicer : public QObject {
+    Q_OBJECT
+
+    public:
+        TestMassSlicer();
+
+    private Q_SLOTS:
+        // functions executed by QtTest before and after test suite
+        void initTestCase();
+        void cleanupTestCase();
+
+        // functions executed by QtTest before and after each test
+        void init();
+        void cleanup();
+
+        // test functions - all functions prefixed with "test" will be ran as tests
+        // this is automatically detected thanks to Qt's meta-information about QObjects
+        void testalgorithmBBands();
+        void testalgorithmBThreads();
+        void testSliceIndex();
+        void testalgorithmC();
+};
+
+#endif // TESTMASSSLICER_H
@@ -0,0 +1,633 @@
+#include <chrono>
+#include <sstream>
+#include "testProjectDB.h"
+#include "Compound.h"
+#include "connection.h"
+#include "cursor.h"
+#include "datastructures/adduct.h"
+#include "mzSample.h"
+#include "PeakGroup.h"
+#include "projectdatabase.h"
+#include "projectversioning.h"
+#include "Scan.h"
+
+TestProjectDB::TestProjectDB() {}
+
+void TestProjectDB::initTestCase() {
+    // This function is being executed at the beginning of each test suite
+    // That is - before other tests from this class run
+}
+
+void TestProjectDB::cleanupTestCase() {
+    // Similarly to initTestCase(), this function is executed at the end of test suite
+}
+
+void TestProjectDB::init() {
+    // This function is executed before each test
+}
+
+void TestProjectDB::cleanup() {
+    // This function is executed after each test
+}
+
+// a group with one peak in each of the given samples
+static PeakGroup* makeGroup(int groupId,
+                            const vector<mzSample*>& samples,
+                            float areaOffset)
+{
+    PeakGroup* group = new PeakGroup();
+    group->groupId = groupId;
+    group->tagString = "tag_" + to_string(groupId);
+    group->expectedMz = 100.0f + groupId * 0.01f;
+    for (unsigned int i = 0; i < samples.size(); ++i) {
+        Peak peak;
+        peak.setSample(samples[i]);
+        peak.rt = (groupId % 60) + i * 0.01f;
+        peak.peakMz = 100.05f + groupId * 0.01f;
+        peak.peakArea = 1000.0f * i + groupId + areaOffset;
+        peak.peakIntensity = 500.0f + groupId;
+        group->addPeak(peak);
+        group->samples.push_back(samples[i]);
+    }
+    return group;
+}
+
+static void describeGroup(ostream& out, PeakGroup* group, int depth)
+{
+    out << depth << " " << group->groupId << " " << group->tagString << " "
+        << group->expectedMz << " " << group->samples.size() << "\n";
+    for (auto& peak : group->getPeaks()) {
+        out << "  " << peak.getSample()->sampleName << " " << peak.rt << " "
+            << peak.peakMz << " " << peak.peakArea << " "
+            << peak.peakIntensity << "\n";
+    }
+    for (auto& child : group->children)
+        describeGroup(out, &child, depth + 1);
+}
+
+// all groups of a project, independent of the order they were saved in
+static vector<string> describeProject(const string& filename,
+                                      const vector<mzSample*>& samples)
+{
+    ProjectDatabase project(filename, "v0.11.0");
+    vector<string> descriptions;
+    for (auto group : project.loadGroups(samples)) {
+        ostringstream out;
+        out << group->tableName() << "\n";
+        describeGroup(out, group, 0);
+        descriptions.push_back(out.str());
+        delete group;
+    }
+    sort(descriptions.begin(), descriptions.end());
+    return descriptions;
+}
+
+// save the groups the way an open project is saved again, updating them in
+// place when possible; returns whether they were
+static bool saveProject(ProjectDatabase& project,
+                        const vector<mzSample*>& samples,
+                        const map<string, vector<PeakGroup*>>& tables)
+{
+    bool incremental = project.canSaveIncrementally();
+    if (incremental) {
+        project.deleteAllSamples();
+    } else {
+        project.deleteAll();
+    }
+    project.saveSamples(samples);
+
+    vector<pair<string, vector<PeakGroup*>>> groupTables(tables.begin(),
+                                                         tables.end());
+    if (incremental) {
+        project.updateGroups(groupTables);
+    } else {
+        for (const auto& table : groupTables)
+            project.saveGroups(table.second, table.first);
+    }
+    return incremental;
+}
+
+void TestProjectDB::testUpdateGroups() {
+    string filename = QDir::temp().filePath("incremental.emDB").toStdString();
+    string fullFilename = QDir::temp().filePath("full.emDB").toStdString();
+    remove(filename.c_str());
+    remove(fullFilename.c_str());
+
+    vector<mzSample*> samples;
+    for (int i = 0; i < 3; ++i) {
+        mzSample* sample = new mzSample();
+        sample->sampleName = "sample_" + to_string(i);
+        sample->fileName = "/data/" + sample->sampleName + ".mzML";
+        samples.push_back(sample);
+    }
+    map<string, vector<PeakGroup*>> tables;
+    for (int g = 1; g <= 40; ++g)
+        tables[g % 2 ? "table_a" : "table_b"].push_back(makeGroup(g, samples, 0));
+    vector<PeakGroup*> removed;
+
+    // the groups of a new project have not been saved through it yet
+    ProjectDatabase* project = new ProjectDatabase(filename, "v0.11.0");
+    QVERIFY(!project->canSaveIncrementally());
+    QVERIFY(!saveProject(*project, samples, tables));
+    QVERIFY(project->canSaveIncrementally());
+
+    // modify, remove and duplicate groups, then add a child to one
+    vector<PeakGroup*>& tableA = tables["table_a"];
+    vector<PeakGroup*>& tableB = tables["table_b"];
+    tableA[0]->peaks[0].peakArea += 1.0f;
+    tableA[3]->tagString = "changed";
+    removed.insert(removed.end(), tableB.begin() + 2, tableB.begin() + 5);
+    tableB.erase(tableB.begin() + 2, tableB.begin() + 5);
+    tableA.push_back(makeGroup(100, samples, 5.0f));
+    tableB.push_back(makeGroup(tableB[0]->groupId, samples, 3.0f));
+    PeakGroup* child = makeGroup(tableB[1]->groupId, samples, 7.0f);
+    tableB[1]->addChild(*child);
+    delete child;
+
+    int revision = project->revision();
+    QVERIFY(saveProject(*project, samples, tables));
+    QVERIFY(project->revision() > revision);
+    QVERIFY(project->canSaveIncrementally());
+
+    // a group sharing its id with another is updated on its own
+    tableB.back()->peaks[1].rt += 1.0f;
+    QVERIFY(saveProject(*project, samples, tables));
+
+    ProjectDatabase* fullProject = new ProjectDatabase(fullFilename, "v0.11.0");
+    QVERIFY(!saveProject(*fullProject, samples, tables));
+    delete fullProject;
+    vector<string> expected = describeProject(fullFilename, samples);
+    QVERIFY(expected.size() == tableA.size() + tableB.size());
+    QVERIFY(describeProject(filename, samples) == expected);
+
+    // groups written by anyone else force the project to be saved in full
+    {
+        ProjectDatabase writer(filename, "v0.11.0");
+        writer.deleteTableGroups("table_c");
+    }
+    QVERIFY(!project->canSaveIncrementally());
+    tableA[1]->peaks[2].peakIntensity += 1.0f;
+    QVERIFY(!saveProject(*project, samples, tables));
+    QVERIFY(project->canSaveIncrementally());
+    delete project;
+
+    fullProject = new ProjectDatabase(fullFilename, "v0.11.0");
+    QVERIFY(!saveProject(*fullProject, samples, tables));
+    delete fullProject;
+    QVERIFY(describeProject(filename, samples)
+            == describeProject(fullFilename, samples));
+
+    for (auto& table : tables) {
+        for (auto group : table.second)
+            delete group;
+    }
+    for (auto group : removed)
+        delete group;
+    for (auto sample : samples)
+        delete sample;
+    remove(filename.c_str());
+    remove(fullFilename.c_str());
+}
+
+// a sample with a full scan and fragmentation scans with the given numbers of
+// peaks, each at a different nominal mass
+static mzSample* makeScanSample(const vector<int>& peakCounts)
+{
+    mzSample* sample = new mzSample();
+    sample->sampleName = "scans";
+    sample->fileName = "/data/scans.mzML";
+    Scan* fullScan = new Scan(sample, 0, 1, 1.0f, 0.0f, 1);
+    fullScan->mz = {200.5f, 300.5f};
+    fullScan->intensity = {100.0f, 200.0f};
+    sample->addScan(fullScan);
+    for (unsigned int i = 0; i < peakCounts.size(); ++i) {
+        Scan* scan = new Scan(sample, 0, 2, 1.1f + i * 0.1f, 300.5f, 1);
+        for (int j = 0; j < peakCounts[i]; ++j) {
+            scan->mz.push_back(100.25f + j);
+            scan->intensity.push_back(1000.0f + (j * 37) % 200);
+        }
+        sample->addScan(scan);
+    }
+    return sample;
+}
+
+static vector<int> scanDataFormats(const string& filename)
+{
+    Connection connection(filename);
+    auto query = connection.prepare("SELECT data_format  \
+                                       FROM scans        \
+                                   ORDER BY scan         ");
+    vector<int> formats;
+    while (query->next())
+        formats.push_back(query->integerValue("data_format"));
+    return formats;
+}
+
+void TestProjectDB::testScanRoundTrip() {
+    string filename = QDir::temp().filePath("scans.emDB").toStdString();
+    remove(filename.c_str());
+
+    // a spectrum of a few peaks is stored as floats, a long one packed
+    mzSample* sample = makeScanSample({3, 600});
+    vector<mzSample*> samples = {sample};
+    {
+        ProjectDatabase project(filename, "v0.11.0");
+        project.saveSamples(samples);
+        project.saveScans(samples);
+    }
+    QVERIFY(scanDataFormats(filename) == vector<int>({1, 2}));
+
+    ProjectDatabase project(filename, "v0.11.0");
+    vector<Scan*> scans = project.loadScans(samples);
+    QVERIFY(scans.size() == 2);
+    for (unsigned int i = 0; i < scans.size(); ++i) {
+        Scan* saved = sample->scans[i + 1];
+        Scan* loaded = scans[i];
+        QVERIFY(loaded->getSample() == sample);
+        QVERIFY(loaded->scannum == saved->scannum);
+        QVERIFY(loaded->mslevel == 2);
+        QVERIFY(loaded->rt == saved->rt);
+        QVERIFY(loaded->precursorMz == saved->precursorMz);
+        QVERIFY(loaded->mz == saved->mz);
+        QVERIFY(loaded->intensity == saved->intensity);
+        delete loaded;
+    }
+
+    delete sample;
+    remove(filename.c_str());
+}
+
+void TestProjectDB::testLegacyScanData() {
+    string filename = QDir::temp().filePath("legacyscans.emDB").toStdString();
+    remove(filename.c_str());
+
+    mzSample* sample = makeScanSample({});
+    vector<mzSample*> samples = {sample};
+    {
+        ProjectDatabase project(filename, "v0.11.0");
+        project.saveSamples(samples);
+        project.saveScans(samples);
+    }
+
+    // older versions saved "[mz,intensity]" pairs by decreasing intensity
+    {
+        Connection connection(filename);
+        auto query = connection.prepare(
+            "INSERT INTO scans ( sample_id, scan, file_seek_start        \
+                               , file_seek_end, mslevel, rt              \
+                               , precursor_mz, precursor_charge          \
+                               , precursor_ic, minmz, maxmz, data        \
+                               , data_format )                           \
+                        VALUES ( :sample_id, 7, -1, -1, 2, 1.5, 300.5    \
+                               , 0, 0, 0, 0, :data, 0 )                  ");
+        query->bind(":sample_id", sample->getSampleId());
+        query->bind(":data", string("[200.5,30][100.25,20][150.75,10]"));
+        QVERIFY(query->execute());
+    }
+
+    ProjectDatabase project(filename, "v0.11.0");
+    vector<Scan*> scans = project.loadScans(samples);
+    QVERIFY(scans.size() == 1);
+    QVERIFY(scans[0]->scannum == 7);
+    QVERIFY(scans[0]->precursorMz == 300.5f);
+    QVERIFY(scans[0]->mz == vector<float>({100.25f, 150.75f, 200.5f}));
+    QVERIFY(scans[0]->intensity == vector<float>({20.0f, 10.0f, 30.0f}));
+
+    delete scans[0];
+    delete sample;
+    remove(filename.c_str());
+}
+
+void TestProjectDB::testScanTableUpgrade() {
+    for (bool withScans : {true, false}) {
+        string filename = QDir::temp().filePath("upgrade.emDB").toStdString();
+        string backup = QDir::temp().filePath("upgrade(v0.11.0).emDB")
+                            .toStdString();
+        remove(filename.c_str());
+        remove(backup.c_str());
+
+        mzSample* sample = makeScanSample({3});
+        vector<mzSample*> samples = {sample};
+        {
+            ProjectDatabase project(filename, "v0.10.0");
+            project.saveSamples(samples);
+            QVERIFY(project.version() == 4);
+        }
+
+        // a project of version 4 keeps the older scans table, holding text
+        if (withScans) {
+            ProjectDatabase project(filename, "v0.10.0");
+            project.saveScans(samples);
+            Connection connection(filename);
+            QVERIFY(!ProjectVersioning::hasColumn(connection,
+                                                  "scans",
+                                                  "data_format"));
+        }
+
+        // scans saved before the upgrade are still read as text, new ones
+        // are saved in binary form
+        ProjectDatabase project(filename, "v0.11.0");
+        QVERIFY(project.version() == 5);
+        QVERIFY(scanDataFormats(filename)
+                == (withScans ? vector<int>({0}) : vector<int>()));
+        vector<Scan*> scans = project.loadScans(samples);
+        QVERIFY(scans.size() == (withScans ? 1 : 0));
+        for (auto scan : scans) {
+            QVERIFY(scan->mz == sample->scans[1]->mz);
+            QVERIFY(scan->intensity == sample->scans[1]->intensity);
+            delete scan;
+        }
+
+        project.saveScans(samples);
+        QVERIFY(scanDataFormats(filename) == vector<int>({1}));
+        scans = project.loadScans(samples);
+        QVERIFY(scans.size() == 1);
+        QVERIFY(scans[0]->mz == sample->scans[1]->mz);
+        QVERIFY(scans[0]->intensity == sample->scans[1]->intensity);
+        delete scans[0];
+
+        delete sample;
+        remove(filename.c_str());
+        remove(backup.c_str());
+    }
+}
+
+static void collectSpecies(PeakGroup* group,
+                           set<Compound*>& compounds,
+                           set<Adduct*>& adducts)
+{
+    if (group->getCompound())
+        compounds.insert(group->getCompound());
+    if (group->getAdduct())
+        adducts.insert(group->getAdduct());
+    for (auto& child : group->children)
+        collectSpecies(&child, compounds, adducts);
+}
+
+// delete groups returned by `loadGroups`, along with the compounds and
+// adducts created for them
+static void deleteLoadedGroups(const vector<PeakGroup*>& groups)
+{
+    set<Compound*> compounds;
+    set<Adduct*> adducts;
+    for (auto group : groups) {
+        collectSpecies(group, compounds, adducts);
+        delete group;
+    }
+    for (auto compound : compounds)
+        delete compound;
+    for (auto adduct : adducts)
+        delete adduct;
+}
+
+void TestProjectDB::testUpgradeExistingColumns() {
+    string filename = QDir::temp().filePath("columns.emDB").toStdString();
+    string backup = QDir::temp().filePath("columns(v0.11.0).emDB")
+                        .toStdString();
+    remove(filename.c_str());
+    remove(backup.c_str());
+    {
+        Connection connection(filename);
+        QVERIFY(connection.prepare("CREATE TABLE scans ( id          INTEGER \
+                                                       , data_format INTEGER )")
+                    ->execute());
+    }
+
+    // a column that already exists must not stop the rest of the upgrade
+    ProjectVersioning::upgradeDatabase(
+        filename,
+        "BEGIN TRANSACTION;"
+        "ALTER TABLE scans ADD COLUMN data_format INTEGER NOT NULL DEFAULT 0;"
+        "ALTER TABLE scans ADD COLUMN data BLOB;"
+        "COMMIT;",
+        "v0.11.0");
+
+    {
+        Connection connection(filename);
+        QVERIFY(ProjectVersioning::hasColumn(connection, "scans", "data"));
+        QVERIFY(ProjectVersioning::hasColumn(connection,
+                                             "scans",
+                                             "data_format"));
+        QVERIFY(!ProjectVersioning::hasColumn(connection, "scans", "rt"));
+        QVERIFY(!ProjectVersioning::hasColumn(connection, "peaks", "rt"));
+    }
+
+    remove(filename.c_str());
+    remove(backup.c_str());
+}
+
+void TestProjectDB::testLoadGroups() {
+    string filename = QDir::temp().filePath("loadgroups.emDB").toStdString();
+    remove(filename.c_str());
+
+    vector<mzSample*> samples;
+    for (int i = 0; i < 3; ++i) {
+        mzSample* sample = new mzSample();
+        sample->sampleName = "sample_" + to_string(i);
+        sample->fileName = "/data/" + sample->sampleName + ".mzML";
+        samples.push_back(sample);
+    }
+
+    // compounds without an id are looked up by their name
+    Compound* alanine = new Compound("C00041", "alanine", "C3H7NO2", 0);
+    alanine->setDb("test_db");
+    Compound* glycine = new Compound("", "glycine", "C2H5NO2", 0);
+    glycine->setDb("test_db");
+    set<Compound*> compounds = {alanine, glycine};
+    Adduct protonated("[M+H]+", 1, 1, 1.007276f);
+    Adduct deprotonated("[M-H]-", 1, -1, -1.007276f);
+
+    vector<PeakGroup*> groups;
+    for (int g = 0; g < 3; ++g) {
+        PeakGroup* group = new PeakGroup();
+        group->groupId = g + 1;
+        group->tagString = "tag_" + to_string(g + 1);
+        group->expectedMz = 90.05f + g;
+        group->label = 'g';
+        for (int k = 0; k <= g; ++k) {
+            Peak peak;
+            peak.setSample(samples[k]);
+            peak.rt = 2.5f + g + k * 0.1f;
+            peak.peakMz = 90.05f + g + k * 0.001f;
+            peak.peakIntensity = 1000.0f * (k + 1);
+            group->addPeak(peak);
+            group->samples.push_back(samples[k]);
+        }
+        groups.push_back(group);
+    }
+    groups[0]->setCompound(alanine);
+    groups[0]->setAdduct(&protonated);
+    groups[1]->setCompound(glycine);
+    groups[1]->setAdduct(&deprotonated);
+    PeakGroup child(*groups[1]);
+    child.groupId = 4;
+    child.tagString = "child";
+    PeakGroup grandchild(*groups[2]);
+    grandchild.groupId = 5;
+    grandchild.tagString = "grandchild";
+    child.addChild(grandchild);
+    groups[0]->addChild(child);
+
+    {
+        ProjectDatabase saveDB(filename, "v0.11.0");
+        saveDB.saveSamples(samples);
+        saveDB.saveCompounds(compounds);
+        saveDB.saveGroups(groups, "test_table");
+    }
+
+    ProjectDatabase loadDB(filename, "v0.11.0");
+    vector<PeakGroup*> loadedGroups = loadDB.loadGroups(samples);
+    QVERIFY(loadedGroups.size() == 3);
+    for (unsigned int g = 0; g < loadedGroups.size(); ++g) {
+        PeakGroup* group = loadedGroups[g];
+        QVERIFY(group->groupId == groups[g]->groupId);
+        QVERIFY(group->tagString == groups[g]->tagString);
+        QVERIFY(group->expectedMz == groups[g]->expectedMz);
+        QVERIFY(group->label == 'g');
+        QVERIFY(group->tableName() == "test_table");
+        QVERIFY(group->samples == groups[g]->samples);
+        QVERIFY(group->peakCount() == g + 1);
+        for (unsigned int k = 0; k < group->peakCount(); ++k) {
+            Peak& peak = group->getPeaks()[k];
+            QVERIFY(peak.getSample() == samples[k]);
+            QVERIFY(peak.rt == groups[g]->getPeaks()[k].rt);
+            QVERIFY(peak.peakMz == groups[g]->getPeaks()[k].peakMz);
+            QVERIFY(peak.peakIntensity == 1000.0f * (k + 1));
+        }
+    }
+
+    Compound* compound = loadedGroups[0]->getCompound();
+    QVERIFY(compound != nullptr && compound != alanine);
+    QVERIFY(compound->id() == "C00041");
+    QVERIFY(compound->name() == "alanine");
+    QVERIFY(compound->db() == "test_db");
+    QVERIFY(loadedGroups[0]->getAdduct()->getName() == "[M+H]+");
+    QVERIFY(loadedGroups[0]->childCount() == 1);
+    PeakGroup& loadedChild = loadedGroups[0]->children[0];
+    QVERIFY(loadedChild.groupId == 4);
+    QVERIFY(loadedChild.tagString == "child");
+    QVERIFY(loadedChild.peakCount() == 2);
+    QVERIFY(loadedChild.childCount() == 1);
+    PeakGroup& loadedGrandchild = loadedChild.children[0];
+    QVERIFY(loadedGrandchild.groupId == 5);
+    QVERIFY(loadedGrandchild.tagString == "grandchild");
+    QVERIFY(loadedGrandchild.peakCount() == 3);
+
+    compound = loadedGroups[1]->getCompound();
+    QVERIFY(compound != nullptr);
+    QVERIFY(compound->id().empty());
+    QVERIFY(compound->name() == "glycine");
+    QVERIFY(loadedChild.getCompound() == compound);
+    QVERIFY(loadedGroups[1]->getAdduct()->getName() == "[M-H]-");
+
+    QVERIFY(loadedGroups[2]->getCompound() == nullptr);
+    QVERIFY(loadedGroups[2]->getAdduct() == nullptr);
+
+    deleteLoadedGroups(loadedGroups);
+    for (auto group : groups)
+        delete group;
+    delete alanine;
+    delete glycine;
+    for (auto sample : samples)
+        delete sample;
+    remove(filename.c_str());
+}
+
+void TestProjectDB::testloadGroupsBenchmark() {
+    // loading a large project takes a while, so it is only timed on request
+    if (qgetenv("MAVEN_BENCHMARKS").isEmpty())
+        QSKIP("set MAVEN_BENCHMARKS to run benchmarks");
+
+    const int sampleCount = 1000;
+    const int groupCount = 100000;
+    string filename = QDir::temp().filePath("loadgroups.emDB").toStdString();
+    remove(filename.c_str());
+
+    vector<mzSample*> samples;
+    for (int i = 0; i < sampleCount; ++i) {
+        mzSample* sample = new mzSample();
+        sample->sampleName = "sample_" + to_string(i);
+        sample->fileName = "/data/" + sample->sampleName + ".mzML";
+        samples.push_back(sample);
+    }
+
+    set<Compound*> compounds;
+    vector<Compound*> compoundList;
+    for (int i = 0; i < 500; ++i) {
+        Compound* compound = new Compound("C" + to_string(i),
+                                          "compound_" + to_string(i),
+                                          "C6H12O6",
+                                          0);
+        compound->setDb("benchmark_db");
+        compounds.insert(compound);
+        compoundList.push_back(compound);
+    }
+    Adduct adduct("[M+H]+", 1, 1, 1.007276f);
+
+    // a project with a few peaks per group and a child for every fifth group
+    vector<PeakGroup*> groups;
+    for (int g = 0; g < groupCount; ++g) {
+        PeakGroup* group = new PeakGroup();
+        group->groupId = g + 1;
+        group->setCompound(compoundList[g % compoundList.size()]);
+        group->setAdduct(&adduct);
+        for (int k = 0; k < 3; ++k) {
+            mzSample* sample = samples[(g * 7 + k * 331) % sampleCount];
+            Peak peak;
+            peak.setSample(sample);
+            peak.rt = (g % 60) + k * 0.1f;
+            peak.peakMz = 100.0f + g * 0.001f;
+            peak.peakIntensity = 1000.0f + k;
+            group->addPeak(peak);
+            group->samples.push_back(sample);
+        }
+        if (g % 5 == 4) {
+            groups.back()->addChild(*group);
+            delete group;
+        } else {
+            groups.push_back(group);
+        }
+    }
+
+    {
+        ProjectDatabase saveDB(filename, "v0.11.0");
+        saveDB.saveSamples(samples);
+        saveDB.saveCompounds(compounds);
+        saveDB.saveGroups(groups, "benchmark_table");
+    }
+
+    ProjectDatabase loadDB(filename, "v0.11.0");
+    auto start = chrono::high_resolution_clock::now();
+    auto loadedGroups = loadDB.loadGroups(samples);
+    auto end = chrono::high_resolution_clock::now();
+    double seconds = chrono::duration<double>(end - start).count();
+    cerr << "loadGroups: " << groupCount << " groups over " << sampleCount
+         << " samples in " << seconds << " s ("
+         << groupCount / max(seconds, 1e-9) << " groups/sec)" << endl;
+
+    QVERIFY(loadedGroups.size() == groups.size());
+    bool allResolved = true;
+    for (size_t i = 0; i < loadedGroups.size() && allResolved; ++i) {
+        PeakGroup* group = loadedGroups[i];
+        allResolved = group->samples.size() == 3
+                      && group->peakCount() == 3
+                      && group->childCount() == groups[i]->childCount()
+                      && group->getCompound() != nullptr
+                      && group->getCompound()->id()
+                             == groups[i]->getCompound()->id()
+                      && group->getAdduct() != nullptr
+                      && group->getAdduct()->getName() == adduct.getName();
+        for (auto& peak : group->getPeaks())
+            allResolved = allResolved && peak.getSample() != nullptr;
+    }
+    QVERIFY(allResolved);
+
+    deleteLoadedGroups(loadedGroups);
+    for (auto group : groups)
+        delete group;
+    for (auto compound : compoundList)
+        delete compound;
+    for (auto sample : samples)
+        delete sample;
+    remove(filename.c_str());
+}
@@ -0,0 +1,33 @@
+#ifndef TESTPROJECTDB_H
+#define TESTPROJECTDB_H
+#include <iostream>
+#include <QtTest>
+#include <string>
+
+class TestProjectDB : public QObject {
+    Q_OBJECT
+
+    public:
+        TestProjectDB();
+
+    private Q_SLOTS:
+        // functions executed by QtTest before and after test suite
+        void initTestCase();
+        void cleanupTestCase();
+
+        // functions executed by QtTest before and after each test
+        void init();
+        void cleanup();
+
+        // test functions - all functions prefixed with "test" will be ran as tests
+        // this is automatically detected thanks to Qt's meta-information about QObjects
+        void testUpdateGroups();
+        void testScanRoundTrip();
+        void testLegacyScanData();
+        void testScanTableUpgrade();
+        void testUpgradeExistingColumns();
+        void testLoadGroups();
+        void testloadGroupsBenchmark();
+};
+
+#endif // TESTPROJECTDB_H
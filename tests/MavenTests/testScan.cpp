@@ -311,3 +311,30 @@ void TestScan::testgetTopPeaks() {
     QVERIFY(TestUtils::floatCompare(selected[0].second,(float) 2.06999993));
     QVERIFY(TestUtils::floatCompare(selected[1].second,(float) 8.8000001));
 }
+
+void TestScan::testsummarizePeaks() {
+    Scan* scan=new Scan (sample,1,2,3.3,4.4,1);
+    initScan (scan);
+    QVERIFY(!scan->hasPeakSummary());
+
+    scan->summarizePeaks();
+    QVERIFY(scan->hasPeakSummary());
+    QVERIFY(TestUtils::floatCompare(scan->totalIntensity(), 28.6));
+    QVERIFY(TestUtils::floatCompare(scan->maxIntensity(), 9.9));
+    QVERIFY(TestUtils::floatCompare(scan->basePeakMz(), 2.07));
+    QVERIFY(TestUtils::floatCompare(scan->minMz(), 2.07));
+    QVERIFY(TestUtils::floatCompare(scan->maxMz(), 8.8));
+
+    Scan* scan1 = new Scan(sample,3,4,5.0,6.0,-1);
+    scan1->deepcopy(scan);
+    QVERIFY(scan1->hasPeakSummary());
+    QVERIFY(TestUtils::floatCompare(scan1->totalIntensity(), 28.6));
+
+    // filtering discards the summary, the statistics follow the new data
+    scan->intensityFilter(6);
+    QVERIFY(!scan->hasPeakSummary());
+    QVERIFY(TestUtils::floatCompare(scan->totalIntensity(), 18.7));
+    QVERIFY(TestUtils::floatCompare(scan->maxIntensity(), 9.9));
+    QVERIFY(TestUtils::floatCompare(scan->minMz(), 2.07));
+    QVERIFY(TestUtils::floatCompare(scan->maxMz(), 8.8));
+}
@@ -40,6 +40,7 @@ class TestScan : public QObject {
         void testchargeSeries();
         void testdeconvolute();
         void testgetTopPeaks();
+        void testsummarizePeaks();
 
 };
 
@@ -2,6 +2,62 @@
 #include "base64.h"
 #include "utilities.h"
 
+#ifdef ZLIB
+#include <zlib.h>
+#endif
+
+/**
+ * Encode bytes to base64, for generating test data.
+ */
+static string encodeBase64(const string& bytes)
+{
+    const char* alphabet =
+        "ABCDEFGHIJKLMNOPQRSTUVWXYZabcdefghijklmnopqrstuvwxyz0123456789+/";
+    string encoded;
+    for (size_t i = 0; i < bytes.size(); i += 3) {
+        size_t remaining = bytes.size() - i;
+        unsigned int n = (unsigned char)bytes[i] << 16;
+        if (remaining > 1)
+            n |= (unsigned char)bytes[i + 1] << 8;
+        if (remaining > 2)
+            n |= (unsigned char)bytes[i + 2];
+        encoded += alphabet[n >> 18];
+        encoded += alphabet[n >> 12 & 63];
+        encoded += remaining > 1 ? alphabet[n >> 6 & 63] : '=';
+        encoded += remaining > 2 ? alphabet[n & 63] : '=';
+    }
+    return encoded;
+}
+
+/**
+ * Encode values as a binary array, the way mzML and mzXML files store them.
+ */
+template <typename T>
+static string encodeArray(const vector<T>& values,
+                          bool networkOrder,
+                          bool compress)
+{
+    string bytes(reinterpret_cast<const char*>(values.data()),
+                 values.size() * sizeof(T));
+    if (networkOrder) {
+        for (size_t i = 0; i < bytes.size(); i += sizeof(T))
+            reverse(bytes.begin() + i, bytes.begin() + i + sizeof(T));
+    }
+#ifdef ZLIB
+    if (compress) {
+        uLongf size = compressBound(bytes.size());
+        string compressed(size, '\0');
+        ::compress(reinterpret_cast<Bytef*>(&compressed[0]),
+                   &size,
+                   reinterpret_cast<const Bytef*>(bytes.data()),
+                   bytes.size());
+        compressed.resize(size);
+        bytes = compressed;
+    }
+#endif
+    return encodeBase64(bytes);
+}
+
 Testbase64::Testbase64() {
 
 }
@@ -60,3 +116,72 @@ void Testbase64::testdecodeString()
     QVERIFY((unsigned char)dest[15]=='e');
 
 }
+
+void Testbase64::testdecodeBinaryArrays()
+{
+    // lengths around the block sizes of the vectorised decoders
+    for (size_t count : {1, 2, 3, 5, 7, 8, 11, 12, 13, 31, 32, 33, 100, 1001}) {
+        vector<double> values(count);
+        for (size_t i = 0; i < count; i++)
+            values[i] = 50.0 + 1.37 * i * i;
+        vector<float> floats(values.begin(), values.end());
+
+        for (bool networkOrder : {false, true}) {
+            bool compress = false;
+#ifdef ZLIB
+            compress = networkOrder;
+#endif
+            string encoded = encodeArray(floats, networkOrder, compress);
+            vector<float> decoded = base64::decodeBase64(encoded.c_str(),
+                                                         encoded.size(),
+                                                         4,
+                                                         networkOrder,
+                                                         compress);
+            QVERIFY(decoded == floats);
+
+            encoded = encodeArray(values, networkOrder, compress);
+            decoded = base64::decodeBase64(encoded, 8, networkOrder, compress);
+            QVERIFY(decoded == floats);
+        }
+    }
+}
+
+void Testbase64::testdecodeBase64Throughput()
+{
+    // timings are only of interest when tuning the decoder
+    if (qgetenv("MAVEN_BENCHMARKS").isEmpty())
+        QSKIP("set MAVEN_BENCHMARKS to run benchmarks");
+
+    vector<double> values(100000);
+    for (size_t i = 0; i < values.size(); i++)
+        values[i] = 50.0 + fmod(i * 0.618034, 1.0) * 1450.0;
+    vector<float> floats(values.begin(), values.end());
+
+    vector<pair<string, string>> arrays = {
+        {"32-bit", encodeArray(floats, false, false)},
+        {"64-bit, network order", encodeArray(values, true, false)}
+    };
+    vector<int> floatSizes = {4, 8};
+    vector<bool> networkOrders = {false, true};
+
+    for (size_t a = 0; a < arrays.size(); a++) {
+        const string& encoded = arrays[a].second;
+        int repeats = 50;
+        vector<float> decoded;
+        QElapsedTimer timer;
+        timer.start();
+        for (int r = 0; r < repeats; r++) {
+            decoded = base64::decodeBase64(encoded.c_str(),
+                                           encoded.size(),
+                                           floatSizes[a],
+                                           networkOrders[a],
+                                           false);
+        }
+        double seconds = max(timer.nsecsElapsed() / 1e9, 1e-9);
+        double throughput = encoded.size() * repeats / seconds / 1e6;
+        qDebug() << arrays[a].first.c_str() << "base64 decoding:"
+                 << throughput << "MB/s";
+
+        QVERIFY(decoded == floats);
+    }
+}
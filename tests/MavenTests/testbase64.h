@@ -28,6 +28,8 @@ class Testbase64 : public QObject {
         // this is automatically detected thanks to Qt's meta-information about QObjects
         void testdecodeBase64();
         void testdecodeString();
+        void testdecodeBinaryArrays();
+        void testdecodeBase64Throughput();
 };
 
 #endif // TESTBASE64_H